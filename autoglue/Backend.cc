@@ -27,4 +27,9 @@ void Backend::ensureGlueGenerated()
 	}
 }
 
+BridgeTable& Backend::getBridgeTable()
+{
+	return bridgeTable;
+}
+
 }
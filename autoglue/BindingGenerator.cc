@@ -21,6 +21,7 @@ void BindingGenerator::generateBindings(bool resetEntityContext)
 	}
 
 	backend.getRoot().generate(*this);
+	finishGeneration();
 }
 
 void BindingGenerator::changeClassDepth(int amount)
@@ -33,10 +34,17 @@ unsigned BindingGenerator::getClassDepth()
 	return classDepth;
 }
 
+Backend& BindingGenerator::getBackend()
+{
+	return backend;
+}
+
 void BindingGenerator::generateClass(ClassEntity&) {}
 void BindingGenerator::generateEnum(EnumEntity&) {}
 void BindingGenerator::generateEnumEntry(EnumEntryEntity&) {}
 void BindingGenerator::generateFunction(FunctionEntity&) {}
+void BindingGenerator::generateField(FieldEntity&) {}
+void BindingGenerator::generateCallableType(CallableTypeEntity&) {}
 void BindingGenerator::generateTypeReference(TypeReferenceEntity&) {}
 void BindingGenerator::generateTypeAlias(TypeAliasEntity&) {}
 bool BindingGenerator::generateBaseType(TypeEntity&, size_t) { return false; }
@@ -46,6 +54,7 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity&, FunctionEnt
 void BindingGenerator::generateBridgeCall(FunctionEntity&) {}
 void BindingGenerator::generateInterceptionFunction(FunctionEntity&, ClassEntity&) {}
 void BindingGenerator::generateInterceptionContext(ClassEntity&) {}
+void BindingGenerator::finishGeneration() {}
 
 std::string_view BindingGenerator::getObjectHandleName()
 {
@@ -0,0 +1,56 @@
+#include <autoglue/BridgeTable.hh>
+
+#include <cassert>
+
+namespace ag
+{
+
+static void hash(uint32_t& value, std::string_view str)
+{
+	for(char c : str)
+	{
+		value ^= static_cast <unsigned char> (c);
+		value *= 16777619u;
+	}
+
+	// Separate consecutive strings so that moving characters between them changes the hash.
+	value ^= 0xff;
+	value *= 16777619u;
+}
+
+size_t BridgeTable::add(const std::string& name, std::string_view signature)
+{
+	assert(indices.find(name) == indices.end());
+
+	hash(version, name);
+	hash(version, signature);
+
+	indices.emplace(name, names.size());
+	names.emplace_back(name);
+
+	return names.size() - 1;
+}
+
+size_t BridgeTable::getIndex(const std::string& name)
+{
+	auto it = indices.find(name);
+	return it == indices.end() ? npos : it->second;
+}
+
+size_t BridgeTable::getCount()
+{
+	return names.size();
+}
+
+const std::string& BridgeTable::getName(size_t index)
+{
+	assert(index < names.size());
+	return names[index];
+}
+
+uint32_t BridgeTable::getVersion()
+{
+	return version;
+}
+
+}
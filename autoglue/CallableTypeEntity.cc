@@ -1,5 +1,7 @@
 #include <autoglue/CallableTypeEntity.hh>
 #include <autoglue/TypeReferenceEntity.hh>
+#include <autoglue/PrimitiveEntity.hh>
+#include <autoglue/BindingGenerator.hh>
 
 #include <cassert>
 
@@ -28,17 +30,49 @@ const std::string& CallableTypeEntity::getName() const
 	return fullName;
 }
 
+std::string CallableTypeEntity::getHierarchy(const std::string&)
+{
+	return fullName;
+}
+
+TypeReferenceEntity& CallableTypeEntity::getReturnType()
+{
+	return *returnType;
+}
+
+size_t CallableTypeEntity::getParameterCount()
+{
+	return children.size();
+}
+
+TypeReferenceEntity& CallableTypeEntity::getParameter(size_t index)
+{
+	return static_cast <TypeReferenceEntity&> (*children[index]);
+}
+
+bool CallableTypeEntity::returnsValue()
+{
+	return !returnType->isPrimitive() || returnType->getPrimitiveType().getType() != PrimitiveEntity::Type::Void;
+}
+
 const char* CallableTypeEntity::getTypeString()
 {
 	return "Callable type";
 }
 
-void CallableTypeEntity::onGenerate(BindingGenerator&)
+void CallableTypeEntity::onGenerate(BindingGenerator& generator)
 {
-	// TODO: Since some languages might want to export some interface
-	// that can be used to utilize a callable type entity when such
-	// is used by the language bindings, something like
-	// generator.generateCallableType should be called here.
+	generator.generateCallableType(*this);
+}
+
+void CallableTypeEntity::onFirstUse()
+{
+	returnType->use();
+
+	for(auto child : children)
+	{
+		child->use();
+	}
 }
 
 }
@@ -168,6 +168,78 @@ void ClassEntity::onFirstUse()
 	}
 }
 
+void ClassEntity::setValueLayout(size_t size, size_t alignment)
+{
+	valueType = true;
+	valueSize = size;
+	valueAlignment = alignment;
+}
+
+void ClassEntity::addValueField(std::string_view name, std::shared_ptr <PrimitiveEntity> type, size_t offset, size_t size)
+{
+	assert(valueType);
+	assert(valueFields.empty() || valueFields.back().offset < offset);
+
+	valueFields.push_back({ std::string(name), std::move(type), offset, size });
+}
+
+bool ClassEntity::isValueType()
+{
+	return valueType;
+}
+
+size_t ClassEntity::getValueSize()
+{
+	return valueSize;
+}
+
+size_t ClassEntity::getValueAlignment()
+{
+	return valueAlignment;
+}
+
+void ClassEntity::setStorageLayout(size_t size, size_t alignment)
+{
+	storageSize = size;
+	storageAlignment = alignment;
+}
+
+bool ClassEntity::isStorable()
+{
+	return storageSize > 0;
+}
+
+size_t ClassEntity::getStorageSize()
+{
+	return storageSize;
+}
+
+size_t ClassEntity::getStorageAlignment()
+{
+	return storageAlignment;
+}
+
+size_t ClassEntity::getValueFieldCount()
+{
+	return valueFields.size();
+}
+
+const ClassEntity::ValueField& ClassEntity::getValueField(size_t index)
+{
+	assert(index < valueFields.size());
+	return valueFields[index];
+}
+
+void ClassEntity::setPooled()
+{
+	pooled = true;
+}
+
+bool ClassEntity::isPooled()
+{
+	return pooled;
+}
+
 bool ClassEntity::isAbstract()
 {
 	return abstract;
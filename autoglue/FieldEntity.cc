@@ -0,0 +1,122 @@
+#include <autoglue/FieldEntity.hh>
+#include <autoglue/FunctionGroupEntity.hh>
+#include <autoglue/FunctionEntity.hh>
+#include <autoglue/TypeReferenceEntity.hh>
+#include <autoglue/BindingGenerator.hh>
+
+#include <cassert>
+
+namespace ag
+{
+
+static std::shared_ptr <FunctionEntity> addAccessor(Entity& field, std::string_view name,
+													std::shared_ptr <TypeReferenceEntity>&& returnType)
+{
+	auto accessor = std::make_shared <FunctionEntity> (std::move(returnType), false, false, false, false);
+	auto group = std::make_shared <FunctionGroupEntity> (name, FunctionEntity::Type::MemberFunction);
+
+	group->addOverload(std::shared_ptr <FunctionEntity> (accessor));
+	field.addChild(std::move(group));
+
+	return accessor;
+}
+
+FieldEntity::FieldEntity(std::string_view name, std::shared_ptr <TypeReferenceEntity>&& type, bool readOnly)
+	: Entity(Type::Field, name), type(std::move(type))
+{
+	// The getter returns the field as it is.
+	auto returned = std::make_shared <TypeReferenceEntity> ("", this->type->getReferredPtr(), this->type->isReference());
+	returned->initializeContext(this->type->getContext());
+	getter = addAccessor(*this, "get", std::move(returned));
+
+	if(!readOnly)
+	{
+		auto assigned = std::make_shared <TypeReferenceEntity> ("value", this->type->getReferredPtr(), false);
+		assigned->initializeContext(this->type->getContext());
+
+		setter = addAccessor(*this, "set", std::make_shared <TypeReferenceEntity> (
+			"", PrimitiveEntity::getVoid(), false
+		));
+
+		setter->addParameter(std::move(assigned));
+	}
+
+	// Accessing a field doesn't call anything, but copying a string or a buffer allocates.
+	auto pod = this->type->getAsPOD();
+	if(!pod.isPrimitive() || (pod.getPrimitiveType().getType() != PrimitiveEntity::Type::String &&
+								pod.getPrimitiveType().getType() != PrimitiveEntity::Type::Buffer))
+	{
+		getter->setLeaf();
+
+		if(setter)
+		{
+			setter->setLeaf();
+		}
+	}
+}
+
+TypeReferenceEntity& FieldEntity::getFieldType()
+{
+	return *type;
+}
+
+bool FieldEntity::isReadOnly()
+{
+	return !setter;
+}
+
+FunctionEntity& FieldEntity::getGetter()
+{
+	return *getter;
+}
+
+FunctionEntity& FieldEntity::getSetter()
+{
+	assert(setter);
+	return *setter;
+}
+
+void FieldEntity::setOffset(size_t value)
+{
+	offset = value;
+	offsetKnown = true;
+}
+
+bool FieldEntity::hasOffset()
+{
+	return offsetKnown;
+}
+
+size_t FieldEntity::getOffset()
+{
+	assert(offsetKnown);
+	return offset;
+}
+
+bool FieldEntity::matchType(Entity& entity)
+{
+	return entity.getType() == Entity::Type::Field;
+}
+
+void FieldEntity::onGenerate(BindingGenerator& generator)
+{
+	generator.generateField(*this);
+}
+
+void FieldEntity::onFirstUse()
+{
+	type->use();
+	getter->use();
+
+	if(setter)
+	{
+		setter->use();
+	}
+}
+
+const char* FieldEntity::getTypeString()
+{
+	return "Field";
+}
+
+}
@@ -2,6 +2,8 @@
 #include <autoglue/FunctionGroupEntity.hh>
 #include <autoglue/BindingGenerator.hh>
 #include <autoglue/TypeReferenceEntity.hh>
+#include <autoglue/FieldEntity.hh>
+#include <autoglue/ClassEntity.hh>
 
 #include <cassert>
 
@@ -24,7 +26,9 @@ void FunctionEntity::addParameter(std::shared_ptr <TypeReferenceEntity>&& param)
 Entity& FunctionEntity::getParent() const
 {
 	// The parent that a user might care about is the parent of the containing group.
-	return getGroup().getParent();
+	// Field accessors are contained by the field, so the parent is the class containing it.
+	auto* field = getAccessedField();
+	return field ? field->getParent() : getGroup().getParent();
 }
 
 const std::string& FunctionEntity::getName() const
@@ -226,12 +230,44 @@ std::string FunctionEntity::getBridgeName(bool shortened)
 {
 	if(shortened)
 	{
-		return getName() + std::to_string(overloadIndex);
+		// Every field has accessors of the same name, so they are named after the field.
+		auto* field = getAccessedField();
+		return (field ? field->getName() + '_' : std::string()) + getName() + std::to_string(overloadIndex);
 	}
 
 	return getHierarchy("_") + std::to_string(overloadIndex);
 }
 
+std::string FunctionEntity::getBatchBridgeName(bool shortened)
+{
+	assert(batchedFunction);
+	return getBridgeName(shortened) + "_AG_batch";
+}
+
+std::string FunctionEntity::getStorageBridgeName(bool shortened)
+{
+	assert(hasStorageBridge());
+	return getBridgeName(shortened) + "_AG_storage";
+}
+
+std::string FunctionEntity::getAsyncBridgeName(bool shortened)
+{
+	assert(asyncFunction);
+	return getBridgeName(shortened) + "_AG_async";
+}
+
+std::string FunctionEntity::getUnpackedBridgeName(bool shortened)
+{
+	assert(hasUnpackedBridge());
+	return getBridgeName(shortened) + "_AG_unpacked";
+}
+
+FieldEntity* FunctionEntity::getAccessedField() const
+{
+	auto& parent = getGroup().getParent();
+	return FieldEntity::matchType(parent) ? &static_cast <FieldEntity&> (parent) : nullptr;
+}
+
 bool FunctionEntity::isClassMemberFunction()
 {
 	return getType() == Type::MemberFunction ||
@@ -297,6 +333,94 @@ bool FunctionEntity::isProtected()
 	return protectedFunction;
 }
 
+void FunctionEntity::setLeaf()
+{
+	leafFunction = true;
+}
+
+bool FunctionEntity::isLeaf()
+{
+	return leafFunction;
+}
+
+void FunctionEntity::setBatched()
+{
+	batchedFunction = true;
+}
+
+bool FunctionEntity::isBatched()
+{
+	return batchedFunction;
+}
+
+void FunctionEntity::setAsync()
+{
+	asyncFunction = true;
+}
+
+bool FunctionEntity::isAsync()
+{
+	return asyncFunction;
+}
+
+void FunctionEntity::setThrowing()
+{
+	throwingFunction = true;
+}
+
+bool FunctionEntity::isThrowing()
+{
+	return throwingFunction;
+}
+
+bool FunctionEntity::returnsToStorage()
+{
+	// Virtual functions and field accessors are called through other paths in the glue code.
+	if(getType() != Type::MemberFunction || overridable || isOverride() || getAccessedField())
+	{
+		return false;
+	}
+
+	if(returnType->isReference() || returnType->getType() != TypeEntity::Type::Class)
+	{
+		return false;
+	}
+
+	auto& returned = returnType->getClassType();
+	return !returned.isValueType() && returned.isStorable();
+}
+
+bool FunctionEntity::hasStorageBridge()
+{
+	if(getType() == Type::Destructor)
+	{
+		return static_cast <ClassEntity&> (getParent()).isStorable();
+	}
+
+	return returnsToStorage();
+}
+
+bool FunctionEntity::hasUnpackedBridge()
+{
+	// Virtual functions and field accessors are called through other paths in the glue code.
+	if(!leafFunction || getType() != Type::MemberFunction || overridable || isOverride() || getAccessedField())
+	{
+		return false;
+	}
+
+	for(size_t i = 0; i < getParameterCount(); i++)
+	{
+		auto parameter = getParameter(i).getAsPOD();
+		if(parameter.getType() == TypeEntity::Type::Primitive &&
+			parameter.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool FunctionEntity::shouldPrepareClass()
 {
 	if(getType() == Type::Constructor)
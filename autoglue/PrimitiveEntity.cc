@@ -1,12 +1,13 @@
 #include <autoglue/PrimitiveEntity.hh>
 
 #include <cassert>
+#include <map>
 
 namespace ag
 {
 
-PrimitiveEntity::PrimitiveEntity(std::string_view name, Type type)
-	: TypeEntity(name, TypeEntity::Type::Primitive), type(type)
+PrimitiveEntity::PrimitiveEntity(std::string_view name, Type type, Type element)
+	: TypeEntity(name, TypeEntity::Type::Primitive), type(type), element(element)
 {
 }
 
@@ -58,11 +59,107 @@ std::shared_ptr <PrimitiveEntity> PrimitiveEntity::getVoid()
 	return entity;
 }
 
+std::shared_ptr <PrimitiveEntity> PrimitiveEntity::getInteger(Type type)
+{
+	assert(isInteger(type));
+
+	if(type == Type::Integer)
+	{
+		return getInteger();
+	}
+
+	// There is a single entity for each integer type.
+	static std::map <Type, std::shared_ptr <PrimitiveEntity>> entities;
+	auto& entity = entities[type];
+
+	if(!entity)
+	{
+		const char* name = "";
+
+		switch(type)
+		{
+			case Type::Int8: name = "Int8"; break;
+			case Type::Int16: name = "Int16"; break;
+			case Type::Int64: name = "Int64"; break;
+			case Type::UInt8: name = "UInt8"; break;
+			case Type::UInt16: name = "UInt16"; break;
+			case Type::UInt32: name = "UInt32"; break;
+			case Type::UInt64: name = "UInt64"; break;
+			case Type::IntPtr: name = "IntPtr"; break;
+			case Type::UIntPtr: name = "UIntPtr"; break;
+			default: {}
+		}
+
+		entity.reset(new PrimitiveEntity(name, type));
+	}
+
+	return entity;
+}
+
+bool PrimitiveEntity::isInteger(Type type)
+{
+	switch(type)
+	{
+		case Type::Integer:
+		case Type::Int8:
+		case Type::Int16:
+		case Type::Int64:
+		case Type::UInt8:
+		case Type::UInt16:
+		case Type::UInt32:
+		case Type::UInt64:
+		case Type::IntPtr:
+		case Type::UIntPtr:
+			return true;
+
+		default: {}
+	}
+
+	return false;
+}
+
+std::shared_ptr <PrimitiveEntity> PrimitiveEntity::getBuffer(Type element)
+{
+	assert(isBufferElement(element));
+
+	// There is a single buffer entity for each element type.
+	static std::map <Type, std::shared_ptr <PrimitiveEntity>> entities;
+	auto& entity = entities[element];
+
+	if(!entity)
+	{
+		entity.reset(new PrimitiveEntity("Buffer", Type::Buffer, element));
+	}
+
+	return entity;
+}
+
+bool PrimitiveEntity::isBufferElement(Type element)
+{
+	switch(element)
+	{
+		case Type::Integer:
+		case Type::Float:
+		case Type::Double:
+		case Type::Character:
+			return true;
+
+		default: {}
+	}
+
+	return false;
+}
+
 PrimitiveEntity::Type PrimitiveEntity::getType()
 {
 	return type;
 }
 
+PrimitiveEntity::Type PrimitiveEntity::getElementType()
+{
+	return element;
+}
+
 const char* PrimitiveEntity::getTypeString()
 {
 	return "Primitive type";
@@ -1,4 +1,5 @@
 #include <autoglue/TypeReferenceEntity.hh>
+#include <autoglue/CallableTypeEntity.hh>
 #include <autoglue/BindingGenerator.hh>
 
 #include <iostream>
@@ -83,17 +84,44 @@ PrimitiveEntity& TypeReferenceEntity::getPrimitiveType()
 	return static_cast <PrimitiveEntity&> (*referred);
 }
 
+bool TypeReferenceEntity::isCallable()
+{
+	return getType() == TypeEntity::Type::Callable;
+}
+
+CallableTypeEntity& TypeReferenceEntity::getCallableType()
+{
+	assert(isCallable());
+	return static_cast <CallableTypeEntity&> (*referred);
+}
+
 bool TypeReferenceEntity::isReference()
 {
 	return reference;
 }
 
+void TypeReferenceEntity::setConsumed()
+{
+	consumed = true;
+}
+
+bool TypeReferenceEntity::isConsumed()
+{
+	return consumed;
+}
+
 TypeReferenceEntity TypeReferenceEntity::getAsPOD()
 {
 	switch(getType())
 	{
 		case TypeEntity::Type::Class:
 		{
+			// Value types are passed as they are.
+			if(getClassType().isValueType())
+			{
+				return *this;
+			}
+
 			TypeReferenceEntity podRef(getName(), PrimitiveEntity::getObjectHandle(), isReference());
 			podRef.initializeContext(getContext());
 
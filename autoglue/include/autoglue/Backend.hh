@@ -1,6 +1,7 @@
 #ifndef AUTOGLUE_BACKEND_HH
 #define AUTOGLUE_BACKEND_HH
 
+#include <autoglue/BridgeTable.hh>
 #include <autoglue/Entity.hh>
 
 namespace ag
@@ -17,6 +18,12 @@ public:
 	/// Ensures that the glue code is generated.
 	void ensureGlueGenerated();
 
+	/// Gets the table of bridge functions exported by the glue code.
+	/// The table is filled when the glue code is generated.
+	///
+	/// \return The bridge table.
+	BridgeTable& getBridgeTable();
+
 protected:
 	Backend(std::shared_ptr <Entity>&& root);
 
@@ -25,6 +32,7 @@ protected:
 
 private:
 	bool glueGenerated = false;
+	BridgeTable bridgeTable;
 	std::shared_ptr <Entity> root;
 };
 
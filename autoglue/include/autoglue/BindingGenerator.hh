@@ -13,6 +13,8 @@ class TypeEntity;
 class EnumEntity;
 class EnumEntryEntity;
 class FunctionEntity;
+class FieldEntity;
+class CallableTypeEntity;
 class ScopeEntity;
 class TypeReferenceEntity;
 class TypeAliasEntity;
@@ -50,6 +52,16 @@ public:
 	/// \param entity The FunctionEntity to generate.
 	virtual void generateFunction(FunctionEntity& entity);
 
+	/// Generates a field entity.
+	///
+	/// \param entity The FieldEntity to generate.
+	virtual void generateField(FieldEntity& entity);
+
+	/// Generates a callable type entity.
+	///
+	/// \param entity The CallableTypeEntity to generate.
+	virtual void generateCallableType(CallableTypeEntity& entity);
+
 	/// Generates a type reference entity.
 	///
 	/// \param entity The TypeReferenceEntity to generate.
@@ -99,6 +111,10 @@ public:
 	/// \param entity The class to generate the interception context for.
 	virtual void generateInterceptionContext(ClassEntity& entity);
 
+	/// Called once every entity has been generated. This can be used to generate
+	/// things that depend on all of the generated entities, such as registration code.
+	virtual void finishGeneration();
+
 	/// Changes the class depth.
 	///
 	/// \param amount Positive or a negative number indicating which way the class depth should go.
@@ -114,6 +130,11 @@ public:
 protected:
 	unsigned getClassDepth();
 
+	/// Gets the backend that this generator generates bindings for.
+	///
+	/// \return The backend.
+	Backend& getBackend();
+
 private:
 	Backend& backend;
 	unsigned classDepth = 0;
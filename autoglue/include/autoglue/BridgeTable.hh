@@ -0,0 +1,62 @@
+#ifndef AUTOGLUE_BRIDGE_TABLE_HH
+#define AUTOGLUE_BRIDGE_TABLE_HH
+
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ag
+{
+
+/// BridgeTable keeps track of the bridge functions that the glue code exports
+/// through a single table of function pointers. The glue code registers each bridge
+/// function as it is generated, and foreign generators use the resulting indices
+/// to look up the bridge functions from the table at runtime.
+class BridgeTable
+{
+public:
+	static constexpr size_t npos = static_cast <size_t> (-1);
+
+	/// Adds a bridge function to the table.
+	///
+	/// \param name The name of the bridge function.
+	/// \param signature The C signature of the bridge function.
+	/// \return The index of the bridge function within the table.
+	size_t add(const std::string& name, std::string_view signature);
+
+	/// Gets the index of a bridge function.
+	///
+	/// \param name The name of the bridge function.
+	/// \return The index of the bridge function or npos if it isn't in the table.
+	size_t getIndex(const std::string& name);
+
+	/// Gets the amount of bridge functions in the table.
+	///
+	/// \return The amount of bridge functions in the table.
+	size_t getCount();
+
+	/// Gets the name of a bridge function.
+	///
+	/// \param index The index of the bridge function.
+	/// \return The name of the bridge function.
+	const std::string& getName(size_t index);
+
+	/// Gets the version of the table. The version changes whenever a bridge
+	/// function is added, removed, reordered or has its signature changed.
+	///
+	/// \return The version of the table.
+	uint32_t getVersion();
+
+private:
+	std::vector <std::string> names;
+	std::unordered_map <std::string, size_t> indices;
+
+	// The version is an FNV-1a hash over the names and signatures.
+	uint32_t version = 2166136261u;
+};
+
+}
+
+#endif
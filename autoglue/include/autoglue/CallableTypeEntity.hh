@@ -6,6 +6,10 @@
 namespace ag
 {
 
+/// Represents the signature of something that can be called, such as std::function
+/// or a function pointer. Callables are passed to and from the glue code as AG_Callable
+/// which holds a trampoline function, a context pointer that the trampoline is called
+/// with and a function that releases the context.
 class CallableTypeEntity : public TypeEntity
 {
 public:
@@ -14,11 +18,42 @@ public:
 	void addParameter(std::shared_ptr <TypeReferenceEntity>&& param);
 	const std::string& getName() const override;
 
+	/// Gets the hierarchy of this callable type. Callable types are
+	/// named after their signature and placed in the root scope, so
+	/// the hierarchy only contains the name.
+	///
+	/// \return The name of this callable type.
+	std::string getHierarchy(const std::string& delimiter = "_") override;
+
+	/// Gets the return type of this callable.
+	///
+	/// \return The return type of this callable.
+	TypeReferenceEntity& getReturnType();
+
+	/// Gets the parameter count.
+	///
+	/// \return The count of parameters.
+	size_t getParameterCount();
+
+	/// Gets the parameter at the given index.
+	///
+	/// \return The parameter at the given index.
+	TypeReferenceEntity& getParameter(size_t index);
+
+	/// Checks whether calling this callable returns a value.
+	///
+	/// \return True if this callable returns a value.
+	bool returnsValue();
+
 	const char* getTypeString() override;
 
 private:
+	/// Generates this callable type.
 	void onGenerate(BindingGenerator& generator) override;
 
+	/// Makes sure that the return type and the parameters are used.
+	void onFirstUse() override;
+
 	std::string fullName;
 	std::shared_ptr <TypeReferenceEntity> returnType;
 };
@@ -2,8 +2,10 @@
 #define AUTOGLUE_CLASS_ENTITY_HH
 
 #include <autoglue/TypeEntity.hh>
+#include <autoglue/PrimitiveEntity.hh>
 
 #include <memory>
+#include <vector>
 
 namespace ag
 {
@@ -16,6 +18,15 @@ class ClassEntity : public TypeEntity,
 public:
 	ClassEntity(std::string_view name);
 
+	/// ValueField describes a field of a value type.
+	struct ValueField
+	{
+		std::string name;
+		std::shared_ptr <PrimitiveEntity> type;
+		size_t offset;
+		size_t size;
+	};
+
 	/// Adds a nested entity for this class.
 	///
 	/// \param nested The entity to add to this class.
@@ -64,6 +75,79 @@ public:
 	/// \param generator The BindingGenerator to call functions from.
 	void generateNested(BindingGenerator& generator);
 
+	/// Makes this class a value type. Value types are trivially copyable classes
+	/// that are passed by value as structs mirroring their fields instead of
+	/// being referred to through object handles.
+	///
+	/// \param size The size of the class in bytes.
+	/// \param alignment The alignment of the class in bytes.
+	void setValueLayout(size_t size, size_t alignment);
+
+	/// Adds a field to the layout of this value type. Fields are added in the order of their offsets.
+	///
+	/// \param name The name of the field.
+	/// \param type The type of the field.
+	/// \param offset The offset of the field in bytes.
+	/// \param size The size of the field in bytes.
+	void addValueField(std::string_view name, std::shared_ptr <PrimitiveEntity> type, size_t offset, size_t size);
+
+	/// Checks whether this class is a value type.
+	///
+	/// \return True if this class is a value type.
+	bool isValueType();
+
+	/// Gets the size of this value type.
+	///
+	/// \return The size of this value type in bytes.
+	size_t getValueSize();
+
+	/// Gets the alignment of this value type.
+	///
+	/// \return The alignment of this value type in bytes.
+	size_t getValueAlignment();
+
+	/// Gets the amount of fields in this value type.
+	///
+	/// \return The amount of fields in this value type.
+	size_t getValueFieldCount();
+
+	/// Gets the nth field of this value type.
+	///
+	/// \param index The index of the desired field.
+	/// \return The field at the given index.
+	const ValueField& getValueField(size_t index);
+
+	/// Records the size and the alignment of this class, which makes it storable.
+	/// Objects of a storable class that are returned by value can be constructed
+	/// into storage that foreign code provides instead of being allocated by the glue code.
+	///
+	/// \param size The size of the class in bytes.
+	/// \param alignment The alignment of the class in bytes.
+	void setStorageLayout(size_t size, size_t alignment);
+
+	/// Checks whether this class is storable.
+	///
+	/// \return True if objects of this class can be constructed into foreign storage.
+	bool isStorable();
+
+	/// Gets the size of this storable class.
+	///
+	/// \return The size of this class in bytes.
+	size_t getStorageSize();
+
+	/// Gets the alignment of this storable class.
+	///
+	/// \return The alignment of this class in bytes.
+	size_t getStorageAlignment();
+
+	/// Makes the glue code allocate objects of this class from per-thread free lists.
+	void setPooled();
+
+	/// Checks whether objects of this class are allocated from the free lists.
+	///
+	/// \return True if this class is pooled.
+	bool isPooled();
+
 	/// Checks whether this class is abstract.
 	///
 	/// \return True if this class is abstract.
@@ -126,6 +210,16 @@ private:
 	bool abstract = false;
 	bool isConcrete = false;
 
+	bool valueType = false;
+	size_t valueSize = 0;
+	size_t valueAlignment = 0;
+	std::vector <ValueField> valueFields;
+
+	size_t storageSize = 0;
+	size_t storageAlignment = 0;
+
+	bool pooled = false;
+
 	std::vector <std::weak_ptr <TypeEntity>> baseTypes;
 	std::vector <std::weak_ptr <ClassEntity>> derivedClasses;
 
@@ -23,7 +23,8 @@ public:
 		FunctionGroup,
 		Type,
 		TypeReference,
-		EnumEntry
+		EnumEntry,
+		Field
 	};
 
 	Entity(Type type, std::string_view name);
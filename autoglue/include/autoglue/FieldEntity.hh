@@ -0,0 +1,90 @@
+#ifndef AUTOGLUE_FIELD_ENTITY_HH
+#define AUTOGLUE_FIELD_ENTITY_HH
+
+#include <autoglue/Entity.hh>
+
+#include <cstddef>
+
+namespace ag
+{
+
+class TypeReferenceEntity;
+class FunctionEntity;
+
+/// Represents a public non-static data member of a class. Fields are accessed
+/// through getter and setter functions that get bridge functions like any other
+/// member function. If the offset of the field is known, generators may
+/// instead access the field directly through the object handle.
+class FieldEntity : public Entity
+{
+public:
+	/// FieldEntity constructor.
+	///
+	/// \param name The name of the field.
+	/// \param type The type of the field.
+	/// \param readOnly If true, no setter is created for the field.
+	FieldEntity(std::string_view name, std::shared_ptr <TypeReferenceEntity>&& type, bool readOnly);
+
+	/// Gets the type of this field.
+	///
+	/// \return The type of this field.
+	TypeReferenceEntity& getFieldType();
+
+	/// Checks whether this field can only be read.
+	///
+	/// \return True if this field has no setter.
+	bool isReadOnly();
+
+	/// Gets the function that returns the value of this field.
+	///
+	/// \return The getter of this field.
+	FunctionEntity& getGetter();
+
+	/// Gets the function that assigns a value to this field.
+	/// This should only be called for fields that aren't read-only.
+	///
+	/// \return The setter of this field.
+	FunctionEntity& getSetter();
+
+	/// Sets the offset of this field within its class. This should only be set
+	/// when the field can be read and written as is from that offset.
+	///
+	/// \param offset The offset of this field in bytes.
+	void setOffset(size_t offset);
+
+	/// Checks whether the offset of this field is known.
+	///
+	/// \return True if the offset of this field is known.
+	bool hasOffset();
+
+	/// Gets the offset of this field within its class.
+	///
+	/// \return The offset of this field in bytes.
+	size_t getOffset();
+
+	/// Checks whether the given entity is a FieldEntity.
+	///
+	/// \param entity The entity to check.
+	/// \return True if the given entity is a FieldEntity.
+	static bool matchType(Entity& entity);
+
+	const char* getTypeString() override;
+
+private:
+	/// Generates this field.
+	void onGenerate(BindingGenerator& generator) override;
+
+	/// Makes sure that the field type and the accessors are used.
+	void onFirstUse() override;
+
+	std::shared_ptr <TypeReferenceEntity> type;
+	std::shared_ptr <FunctionEntity> getter;
+	std::shared_ptr <FunctionEntity> setter;
+
+	bool offsetKnown = false;
+	size_t offset = 0;
+};
+
+}
+
+#endif
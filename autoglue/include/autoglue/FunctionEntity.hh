@@ -8,6 +8,7 @@ namespace ag
 
 class TypeReferenceEntity;
 class FunctionGroupEntity;
+class FieldEntity;
 
 class FunctionEntity : public Entity, public std::enable_shared_from_this <FunctionEntity>
 {
@@ -158,6 +159,39 @@ public:
 	/// \return The name of the corresponding bridge function.
 	std::string getBridgeName(bool shortened = false);
 
+	/// Gets the name of the corresponding batched bridge function.
+	/// This should only be called for batched functions.
+	///
+	/// \param shortened If true, the location of the function is excluded.
+	/// \return The name of the corresponding batched bridge function.
+	std::string getBatchBridgeName(bool shortened = false);
+
+	/// Gets the name of the corresponding storage bridge function.
+	/// This should only be called for functions that have a storage bridge function.
+	///
+	/// \param shortened If true, the location of the function is excluded.
+	/// \return The name of the corresponding storage bridge function.
+	std::string getStorageBridgeName(bool shortened = false);
+
+	/// Gets the name of the corresponding asynchronous bridge function.
+	/// This should only be called for asynchronous functions.
+	///
+	/// \param shortened If true, the location of the function is excluded.
+	/// \return The name of the corresponding asynchronous bridge function.
+	std::string getAsyncBridgeName(bool shortened = false);
+
+	/// Gets the name of the corresponding unpacked bridge function.
+	/// This should only be called for functions that have an unpacked bridge function.
+	///
+	/// \param shortened If true, the location of the function is excluded.
+	/// \return The name of the corresponding unpacked bridge function.
+	std::string getUnpackedBridgeName(bool shortened = false);
+
+	/// Gets the field that this function accesses if it's a getter or a setter of a field.
+	///
+	/// \return The accessed field or nullptr.
+	FieldEntity* getAccessedField() const;
+
 	/// Checks whether this function is a class member function.
 	///
 	/// \return True if this function is a class member function.
@@ -200,6 +234,71 @@ public:
 	/// \return True if this function overload is protected.
 	bool isProtected();
 
+	/// Marks this function as a leaf function. Leaf functions return quickly
+	/// without blocking or calling back into foreign code, which lets
+	/// generators call them with a cheaper transition to native code.
+	void setLeaf();
+
+	/// Checks whether this function is a leaf function.
+	///
+	/// \return True if this function is a leaf function.
+	bool isLeaf();
+
+	/// Marks this function as batched. Batched functions additionally get a bridge
+	/// function that calls the function for an array of objects at once.
+	/// This should only be set for non-virtual member functions whose parameters
+	/// and return value are numbers that can be stored in a buffer.
+	void setBatched();
+
+	/// Checks whether this function is batched.
+	///
+	/// \return True if this function is batched.
+	bool isBatched();
+
+	/// Marks this function as asynchronous. Asynchronous functions additionally get a
+	/// bridge function that runs the function on a native worker thread and passes the
+	/// result to a completion function. This should only be set for non-virtual functions
+	/// whose parameters are numbers, booleans, characters or strings and whose return
+	/// value is a number, a boolean or a character.
+	void setAsync();
+
+	/// Checks whether this function is asynchronous.
+	///
+	/// \return True if this function is asynchronous.
+	bool isAsync();
+
+	/// Marks this function as potentially throwing. The bridge functions of such
+	/// functions catch exceptions and report them through an error slot that the
+	/// caller passes as the last parameter. Functions that aren't marked are
+	/// assumed not to throw and are called directly.
+	void setThrowing();
+
+	/// Checks whether this function can throw an exception.
+	///
+	/// \return True if this function can throw an exception.
+	bool isThrowing();
+
+	/// Checks whether this function returns an object by value that can be constructed
+	/// into storage provided by the caller. Such functions additionally get a bridge
+	/// function that takes a pointer to the storage as its first parameter.
+	///
+	/// \return True if this function can return an object to caller provided storage.
+	bool returnsToStorage();
+
+	/// Checks whether this function has a storage bridge function. Besides functions
+	/// that return to storage, the destructors of storable classes have one which
+	/// destroys an object without freeing its storage.
+	///
+	/// \return True if this function has a storage bridge function.
+	bool hasStorageBridge();
+
+	/// Checks whether this function has an unpacked bridge function. Leaf member functions
+	/// taking buffers have one that takes the pointer and the size of each buffer as separate
+	/// parameters, so that foreign code can pass arrays that it only pins for the call.
+	///
+	/// \return True if this function has an unpacked bridge function.
+	bool hasUnpackedBridge();
+
 	/// Checks whether this function should do further class preparation such as the
 	/// initialization of interception functions.
 	///
@@ -244,6 +343,10 @@ private:
 	size_t overloadIndex = 0;
 	bool protectedFunction = false;
 	bool staticFunction = false;
+	bool leafFunction = false;
+	bool batchedFunction = false;
+	bool asyncFunction = false;
+	bool throwingFunction = false;
 };
 
 }
@@ -12,12 +12,28 @@ public:
 	enum class Type
 	{
 		ObjectHandle,
+
+		/// A 32-bit signed integer.
 		Integer,
+
+		Int8,
+		Int16,
+		Int64,
+		UInt8,
+		UInt16,
+		UInt32,
+		UInt64,
+
+		/// Integers that are as wide as a pointer.
+		IntPtr,
+		UIntPtr,
+
 		Float,
 		Double,
 		Boolean,
 		Character,
 		String,
+		Buffer,
 		Void
 	};
 
@@ -30,12 +46,45 @@ public:
 	static std::shared_ptr <PrimitiveEntity> getString();
 	static std::shared_ptr <PrimitiveEntity> getVoid();
 
+	/// Gets the primitive representing an integer of the given type.
+	/// Integers keep their width and signedness so that values can be
+	/// passed to foreign code as they are.
+	///
+	/// \param type The integer type.
+	/// \return The integer primitive for the given type.
+	static std::shared_ptr <PrimitiveEntity> getInteger(Type type);
+
+	/// Checks whether the given type is an integer type.
+	///
+	/// \param type The type to check.
+	/// \return True if the type is an integer type.
+	static bool isInteger(Type type);
+
+	/// Gets the primitive representing a contiguous buffer of the given element type.
+	/// Buffers are passed as a pointer to their elements and the count of elements,
+	/// so that foreign code can pass arrays without copying them element by element.
+	///
+	/// \param element The type of the buffer elements.
+	/// \return The buffer primitive for the given element type.
+	static std::shared_ptr <PrimitiveEntity> getBuffer(Type element);
+
+	/// Checks whether a buffer can contain elements of the given type.
+	///
+	/// \param element The type to check.
+	/// \return True if the type can be a buffer element.
+	static bool isBufferElement(Type element);
+
 	Type getType();
 
+	/// Gets the element type of a buffer primitive.
+	///
+	/// \return The element type or Void if this primitive isn't a buffer.
+	Type getElementType();
+
 	const char* getTypeString() override;
 
 private:
-	PrimitiveEntity(std::string_view name, Type type);
+	PrimitiveEntity(std::string_view name, Type type, Type element = Type::Void);
 
 	void onGenerate(BindingGenerator&) override
 	{
@@ -43,6 +92,7 @@ private:
 	}
 
 	Type type;
+	Type element;
 };
 
 }
@@ -9,6 +9,8 @@
 namespace ag
 {
 
+class CallableTypeEntity;
+
 class TypeReferenceEntity : public Entity
 {
 public:
@@ -75,6 +77,16 @@ public:
 	/// \return The referred type entity as a primitive type.
 	PrimitiveEntity& getPrimitiveType();
 
+	/// Checks if this type reference refers to a callable type.
+	///
+	/// \return True if this type reference refers to a callable type.
+	bool isCallable();
+
+	/// Gets the referred type entity as a callable type.
+	///
+	/// \return The referred type entity as a callable type.
+	CallableTypeEntity& getCallableType();
+
 	/// Checks whether this type reference entity represents a reference.
 	/// This information is especially important in return values, as it
 	/// determines if a foreign language should own a returned object or not.
@@ -82,6 +94,16 @@ public:
 	/// \return True if this type reference entity represents a reference.
 	bool isReference();
 
+	/// Marks the object passed through this type reference as consumed.
+	/// The called function moves from a consumed object, so foreign code
+	/// gives up the object handle instead of letting it be used again.
+	void setConsumed();
+
+	/// Checks whether the object passed through this type reference is consumed.
+	///
+	/// \return True if the object passed through this type reference is consumed.
+	bool isConsumed();
+
 	/// Returns the POD representation of this type reference.
 	///
 	/// \return The POD representation of this type reference.
@@ -100,6 +122,7 @@ private:
 
 	std::shared_ptr <TypeEntity> referred;
 	bool reference = false;
+	bool consumed = false;
 
 	// TODO: Use these:
 	//bool unsignedType = false;
@@ -12,6 +12,7 @@
 #include <autoglue/EnumEntity.hh>
 #include <autoglue/EnumEntryEntity.hh>
 #include <autoglue/FunctionGroupEntity.hh>
+#include <autoglue/FieldEntity.hh>
 #include <autoglue/PrimitiveEntity.hh>
 #include <autoglue/ClassEntity.hh>
 #include <autoglue/EnumEntity.hh>
@@ -23,6 +24,7 @@
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/ASTContext.h>
+#include <clang/AST/Attr.h>
 
 #include <filesystem>
 #include <algorithm>
@@ -108,8 +110,69 @@ ag::FunctionEntity::OverloadedOperator getOverloadedOperator(clang::OverloadedOp
 	return ag::FunctionEntity::OverloadedOperator::None;
 }
 
+static bool isStringClass(clang::QualType type)
+{
+	// Strings behind a non-const reference might be modified, so they stay objects.
+	if(type->isLValueReferenceType() && !type.getNonReferenceType().isConstQualified())
+	{
+		return false;
+	}
+
+	auto* record = type.getNonReferenceType()->getAsCXXRecordDecl();
+	auto* specialization = clang::dyn_cast_or_null <clang::ClassTemplateSpecializationDecl> (record);
+
+	if(!specialization || !specialization->isInStdNamespace())
+	{
+		return false;
+	}
+
+	auto name = specialization->getName();
+	if(name != "basic_string" && name != "basic_string_view")
+	{
+		return false;
+	}
+
+	// Only narrow strings can be passed as UTF-8.
+	auto& args = specialization->getTemplateArgs();
+	return args.size() > 0 && args[0].getKind() == clang::TemplateArgument::Type &&
+			args[0].getAsType()->isCharType();
+}
+
+static clang::QualType getCallableClass(clang::QualType type)
+{
+	// A std::function behind a non-const reference might be reassigned, so it stays an object.
+	if(type->isLValueReferenceType() && !type.getNonReferenceType().isConstQualified())
+	{
+		return clang::QualType();
+	}
+
+	auto* record = type.getNonReferenceType()->getAsCXXRecordDecl();
+	auto* specialization = clang::dyn_cast_or_null <clang::ClassTemplateSpecializationDecl> (record);
+
+	if(!specialization || !specialization->isInStdNamespace() || specialization->getName() != "function")
+	{
+		return clang::QualType();
+	}
+
+	auto& args = specialization->getTemplateArgs();
+	if(args.size() != 1 || args[0].getKind() != clang::TemplateArgument::Type)
+	{
+		return clang::QualType();
+	}
+
+	return args[0].getAsType();
+}
+
+static std::shared_ptr <ag::PrimitiveEntity> getBufferClass(clang::QualType type);
+
 bool isReferenceType(clang::QualType type)
 {
+	// Standard strings and buffers are passed by value as primitives.
+	if(isStringClass(type) || getBufferClass(type))
+	{
+		return false;
+	}
+
 	// Reference and pointer types can be treated as references.
 	if(type->isReferenceType() || type->isPointerType())
 	{
@@ -132,7 +195,40 @@ bool isReferenceType(clang::QualType type)
 	return false;
 }
 
-static std::shared_ptr <ag::TypeEntity> getPrimitive(clang::QualType type)
+static std::shared_ptr <ag::TypeEntity> getInteger(clang::QualType type, clang::ASTContext& context)
+{
+	// Pointer sized integers are only recognizable by the name of their typedef.
+	for(auto* typedefNode = type->getAs <clang::TypedefType> (); typedefNode;
+		typedefNode = typedefNode->desugar()->getAs <clang::TypedefType> ())
+	{
+		auto name = typedefNode->getDecl()->getName();
+
+		if(name == "size_t" || name == "uintptr_t")
+		{
+			return ag::PrimitiveEntity::getInteger(ag::PrimitiveEntity::Type::UIntPtr);
+		}
+
+		else if(name == "ptrdiff_t" || name == "intptr_t" || name == "ssize_t")
+		{
+			return ag::PrimitiveEntity::getInteger(ag::PrimitiveEntity::Type::IntPtr);
+		}
+	}
+
+	bool isSigned = type->isSignedIntegerType();
+
+	switch(context.getIntWidth(type))
+	{
+		case 8: return ag::PrimitiveEntity::getInteger(isSigned ? ag::PrimitiveEntity::Type::Int8 : ag::PrimitiveEntity::Type::UInt8);
+		case 16: return ag::PrimitiveEntity::getInteger(isSigned ? ag::PrimitiveEntity::Type::Int16 : ag::PrimitiveEntity::Type::UInt16);
+		case 32: return ag::PrimitiveEntity::getInteger(isSigned ? ag::PrimitiveEntity::Type::Integer : ag::PrimitiveEntity::Type::UInt32);
+		case 64: return ag::PrimitiveEntity::getInteger(isSigned ? ag::PrimitiveEntity::Type::Int64 : ag::PrimitiveEntity::Type::UInt64);
+	}
+
+	// TODO: Support 128-bit integers.
+	return nullptr;
+}
+
+static std::shared_ptr <ag::TypeEntity> getPrimitive(clang::QualType type, clang::ASTContext& context)
 {
 	if(type->isVoidType())
 	{
@@ -144,29 +240,489 @@ static std::shared_ptr <ag::TypeEntity> getPrimitive(clang::QualType type)
 		return ag::PrimitiveEntity::getBoolean();
 	}
 
-	else if(type->isAnyCharacterType())
+	// Signed and unsigned char are treated as 8-bit integers.
+	else if(type->isAnyCharacterType() && !type->isSpecificBuiltinType(clang::BuiltinType::SChar) &&
+			!type->isSpecificBuiltinType(clang::BuiltinType::UChar))
 	{
 		return ag::PrimitiveEntity::getCharacter();
 	}
 
 	else if(type->isIntegerType())
 	{
-		return ag::PrimitiveEntity::getInteger();
+		return getInteger(type, context);
 	}
 
-	else if(type->isRealType())
+	else if(type->isSpecificBuiltinType(clang::BuiltinType::Float))
 	{
-		return ag::PrimitiveEntity::getDouble();
+		return ag::PrimitiveEntity::getFloat();
 	}
 
-	else if(type->isFloatingType())
+	else if(type->isRealFloatingType())
 	{
-		return ag::PrimitiveEntity::getFloat();
+		return ag::PrimitiveEntity::getDouble();
 	}
 
 	return nullptr;
 }
 
+static std::shared_ptr <ag::PrimitiveEntity> getBufferElement(clang::QualType type)
+{
+	// Unlike single values that are converted, the elements of a buffer
+	// have to match the foreign element type exactly.
+	auto* builtin = type->getAs <clang::BuiltinType> ();
+	if(!builtin)
+	{
+		return nullptr;
+	}
+
+	switch(builtin->getKind())
+	{
+		case clang::BuiltinType::Int:
+		case clang::BuiltinType::UInt:
+			return ag::PrimitiveEntity::getBuffer(ag::PrimitiveEntity::Type::Integer);
+
+		case clang::BuiltinType::Float:
+			return ag::PrimitiveEntity::getBuffer(ag::PrimitiveEntity::Type::Float);
+
+		case clang::BuiltinType::Double:
+			return ag::PrimitiveEntity::getBuffer(ag::PrimitiveEntity::Type::Double);
+
+		case clang::BuiltinType::Char_S:
+		case clang::BuiltinType::Char_U:
+		case clang::BuiltinType::SChar:
+		case clang::BuiltinType::UChar:
+			return ag::PrimitiveEntity::getBuffer(ag::PrimitiveEntity::Type::Character);
+
+		default:
+			return nullptr;
+	}
+}
+
+static std::shared_ptr <ag::PrimitiveEntity> getBufferClass(clang::QualType type)
+{
+	// Vectors behind a non-const reference might be resized, so they stay objects.
+	if(type->isLValueReferenceType() && !type.getNonReferenceType().isConstQualified())
+	{
+		return nullptr;
+	}
+
+	auto* record = type.getNonReferenceType()->getAsCXXRecordDecl();
+	auto* specialization = clang::dyn_cast_or_null <clang::ClassTemplateSpecializationDecl> (record);
+
+	if(!specialization || !specialization->isInStdNamespace())
+	{
+		return nullptr;
+	}
+
+	auto name = specialization->getName();
+	if(name != "span" && name != "vector")
+	{
+		return nullptr;
+	}
+
+	auto& args = specialization->getTemplateArgs();
+	if(args.size() == 0 || args[0].getKind() != clang::TemplateArgument::Type)
+	{
+		return nullptr;
+	}
+
+	return getBufferElement(args[0].getAsType().getCanonicalType().getUnqualifiedType());
+}
+
+static bool isBorrowedBuffer(clang::QualType type)
+{
+	if(!getBufferClass(type))
+	{
+		return false;
+	}
+
+	// Vectors behind a reference and spans refer to elements that outlive the call.
+	auto* record = type->getAsCXXRecordDecl();
+	return type->isLValueReferenceType() || (record && record->getName() == "span");
+}
+
+static bool isValueClass(const std::shared_ptr <ag::TypeEntity>& entity)
+{
+	return entity->getType() == ag::TypeEntity::Type::Class &&
+			static_cast <ag::ClassEntity&> (*entity).isValueType();
+}
+
+static bool isValueRecord(const clang::CXXRecordDecl* decl)
+{
+	if(decl->isUnion() || decl->isPolymorphic() || decl->getNumBases() > 0 ||
+		!decl->isStandardLayout() || !decl->isTriviallyCopyable())
+	{
+		return false;
+	}
+
+	// Only plain data is passed by value, because member functions would need an object to be called on.
+	for(auto* method : decl->methods())
+	{
+		if(!method->isImplicit() && !clang::isa <clang::CXXConstructorDecl> (method) &&
+			!clang::isa <clang::CXXDestructorDecl> (method))
+		{
+			return false;
+		}
+	}
+
+	for(auto* field : decl->fields())
+	{
+		if(field->getAccess() != clang::AccessSpecifier::AS_public || field->isBitField())
+		{
+			return false;
+		}
+	}
+
+	return !decl->field_empty();
+}
+
+static bool initializeValueLayout(ag::ClassEntity& entity, const clang::CXXRecordDecl* decl, clang::ASTContext& context)
+{
+	if(!isValueRecord(decl))
+	{
+		return false;
+	}
+
+	auto& layout = context.getASTRecordLayout(decl);
+	std::vector <ag::ClassEntity::ValueField> fields;
+	size_t end = 0;
+
+	for(auto* field : decl->fields())
+	{
+		auto type = field->getType().getCanonicalType();
+		auto primitive = type->isBuiltinType() ? getPrimitive(type, context) : nullptr;
+
+		// The fields have to be numbers that mean the same on both sides.
+		if(!primitive || !type->isArithmeticType() || type->isBooleanType() ||
+			type->isSpecificBuiltinType(clang::BuiltinType::LongDouble) ||
+			std::static_pointer_cast <ag::PrimitiveEntity> (primitive)->getType() == ag::PrimitiveEntity::Type::Character)
+		{
+			return false;
+		}
+
+		size_t offset = context.toCharUnitsFromBits(layout.getFieldOffset(field->getFieldIndex())).getQuantity();
+		size_t size = context.getTypeSizeInChars(type).getQuantity();
+		size_t alignment = context.getTypeAlignInChars(type).getQuantity();
+
+		// Foreign structs lay out their fields sequentially with natural alignment.
+		if(offset != (end + alignment - 1) / alignment * alignment)
+		{
+			return false;
+		}
+
+		fields.push_back({ field->getNameAsString(), std::static_pointer_cast <ag::PrimitiveEntity> (primitive), offset, size });
+		end = offset + size;
+	}
+
+	entity.setValueLayout(layout.getSize().getQuantity(), layout.getAlignment().getQuantity());
+
+	for(auto& field : fields)
+	{
+		entity.addValueField(field.name, field.type, field.offset, field.size);
+	}
+
+	return true;
+}
+
+static void initializeStorageLayout(ag::ClassEntity& entity, const clang::CXXRecordDecl* decl, clang::ASTContext& context)
+{
+	// Foreign code can only provide storage for objects that it can also destroy.
+	if(decl->isDependentType() || decl->isAbstract() || decl->isUnion())
+	{
+		return;
+	}
+
+	auto* destructor = decl->getDestructor();
+	if(destructor && (destructor->isDeleted() || destructor->getAccess() != clang::AccessSpecifier::AS_public))
+	{
+		return;
+	}
+
+	auto& layout = context.getASTRecordLayout(decl);
+	entity.setStorageLayout(layout.getSize().getQuantity(), layout.getAlignment().getQuantity());
+}
+
+static bool hasAnnotation(const clang::Decl* decl, llvm::StringRef annotation)
+{
+	for(auto* attr : decl->specific_attrs <clang::AnnotateAttr> ())
+	{
+		if(attr->getAnnotation() == annotation)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool isSizeType(clang::QualType type)
+{
+	// size_t is recognized by name, because its canonical type is shared with other integers.
+	while(auto* typedefType = type->getAs <clang::TypedefType> ())
+	{
+		if(typedefType->getDecl()->getName() == "size_t")
+		{
+			return true;
+		}
+
+		type = typedefType->desugar();
+	}
+
+	return false;
+}
+
+static bool isSizeName(llvm::StringRef name)
+{
+	std::string lower = name.lower();
+	if(lower == "n" || lower == "len" || lower.compare(0, 3, "num") == 0)
+	{
+		return true;
+	}
+
+	return lower.find("count") != std::string::npos || lower.find("size") != std::string::npos ||
+			lower.find("length") != std::string::npos;
+}
+
+static std::shared_ptr <ag::PrimitiveEntity> getBufferPointer(clang::QualType pointer, const clang::ParmVarDecl* size)
+{
+	// Plain char pointers are strings, whereas signed and unsigned
+	// char pointers such as uint8_t* are buffers of bytes.
+	if(!pointer->isPointerType() || pointer->getPointeeType()->isCharType())
+	{
+		return nullptr;
+	}
+
+	auto sizeType = size->getType();
+	if(!sizeType->isIntegerType() || sizeType->isBooleanType() || sizeType->isAnyCharacterType())
+	{
+		return nullptr;
+	}
+
+	// Any integer could follow a pointer, so only one that is clearly the size is merged.
+	if(!isSizeType(sizeType) && !isSizeName(size->getName()) && !hasAnnotation(size, "autoglue::size"))
+	{
+		return nullptr;
+	}
+
+	return getBufferElement(pointer->getPointeeType().getCanonicalType().getUnqualifiedType());
+}
+
+static bool isPooledClass(const clang::CXXRecordDecl* decl)
+{
+	// Derived classes are pooled as well since their objects can be
+	// freed through the destructor of a pooled base class.
+	if(hasAnnotation(decl, "autoglue::pool"))
+	{
+		return true;
+	}
+
+	for(auto& base : decl->bases())
+	{
+		auto* baseDecl = base.getType()->getAsCXXRecordDecl();
+		if(baseDecl && baseDecl->hasDefinition() && isPooledClass(baseDecl->getDefinition()))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool containsCall(const clang::Stmt* stmt)
+{
+	if(!stmt)
+	{
+		return false;
+	}
+
+	// Anything that may call other code, allocate or throw could block.
+	if(llvm::isa <clang::CallExpr> (stmt) ||
+		llvm::isa <clang::CXXConstructExpr> (stmt) ||
+		llvm::isa <clang::CXXNewExpr> (stmt) ||
+		llvm::isa <clang::CXXDeleteExpr> (stmt) ||
+		llvm::isa <clang::CXXThrowExpr> (stmt))
+	{
+		return true;
+	}
+
+	for(auto* child : stmt->children())
+	{
+		if(containsCall(child))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool isLeafFunction(const clang::FunctionDecl* decl, bool returnsObject)
+{
+	// Functions can explicitly be marked as leaf functions.
+	if(hasAnnotation(decl, "autoglue::leaf"))
+	{
+		return true;
+	}
+
+	// Bridges for these allocate or may end up calling foreign code.
+	if(returnsObject || !llvm::isa <clang::CXXMethodDecl> (decl) ||
+		llvm::isa <clang::CXXConstructorDecl> (decl) ||
+		llvm::isa <clang::CXXDestructorDecl> (decl) ||
+		llvm::cast <clang::CXXMethodDecl> (decl)->isVirtual())
+	{
+		return false;
+	}
+
+	// Otherwise only inline functions with at most a single statement that
+	// doesn't call anything are known to be short, such as simple getters.
+	if(!decl->isInlined() || !decl->hasBody())
+	{
+		return false;
+	}
+
+	auto* body = llvm::dyn_cast <clang::CompoundStmt> (decl->getBody());
+	return body && body->size() <= 1 && !containsCall(body);
+}
+
+static bool isThrowingFunction(const clang::FunctionDecl* decl)
+{
+	// Destructors are implicitly noexcept.
+	if(llvm::isa <clang::CXXDestructorDecl> (decl))
+	{
+		return false;
+	}
+
+	// Exception specifications that haven't been resolved yet, such as those
+	// of implicit members, are assumed to allow exceptions.
+	auto* proto = decl->getType()->getAs <clang::FunctionProtoType> ();
+	if(!proto || clang::isUnresolvedExceptionSpec(proto->getExceptionSpecType()))
+	{
+		return true;
+	}
+
+	return !proto->isNothrow();
+}
+
+static bool isBatchedValue(clang::QualType type)
+{
+	// Batched values are passed as buffers which need an exact element type.
+	type = type.getNonReferenceType().getCanonicalType().getUnqualifiedType();
+	auto* builtin = type->getAs <clang::BuiltinType> ();
+
+	return builtin && (builtin->getKind() == clang::BuiltinType::Int ||
+						builtin->getKind() == clang::BuiltinType::Float ||
+						builtin->getKind() == clang::BuiltinType::Double);
+}
+
+static void warnIgnored(const clang::FunctionDecl* decl, const char* annotation, const char* reason)
+{
+	// Explicitly requested bridges that can't be generated are reported instead of silently missing.
+	auto& diagnostics = decl->getASTContext().getDiagnostics();
+	unsigned id = diagnostics.getCustomDiagID(clang::DiagnosticsEngine::Warning, "%0 is ignored for %1: %2");
+	diagnostics.Report(decl->getLocation(), id) << annotation << decl->getQualifiedNameAsString() << reason;
+}
+
+static bool isBatchedFunction(const clang::FunctionDecl* decl)
+{
+	// Only functions that explicitly request it get a batched bridge.
+	if(!hasAnnotation(decl, "autoglue::batch"))
+	{
+		return false;
+	}
+
+	// The batched bridge calls the function directly for each object.
+	auto* method = llvm::dyn_cast <clang::CXXMethodDecl> (decl);
+	if(!method || method->isStatic() || method->isVirtual() || method->isOverloadedOperator() ||
+		llvm::isa <clang::CXXConstructorDecl> (decl) ||
+		llvm::isa <clang::CXXDestructorDecl> (decl))
+	{
+		warnIgnored(decl, "autoglue::batch", "only non-virtual member functions can be batched");
+		return false;
+	}
+
+	if(!decl->getReturnType()->isVoidType() &&
+		(decl->getReturnType()->isReferenceType() || !isBatchedValue(decl->getReturnType())))
+	{
+		warnIgnored(decl, "autoglue::batch", "the returned value has to be an int, a float or a double");
+		return false;
+	}
+
+	for(auto* param : decl->parameters())
+	{
+		// Non-const references could be modified, which the arrays wouldn't reflect.
+		if(!isBatchedValue(param->getType()) ||
+			(param->getType()->isReferenceType() && !param->getType().getNonReferenceType().isConstQualified()))
+		{
+			warnIgnored(decl, "autoglue::batch", "the parameters have to be ints, floats or doubles passed by value");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool isAsyncValue(clang::QualType type)
+{
+	// Asynchronous calls outlive the foreign call, so the values are copied for the
+	// worker thread. Only plain numbers, booleans and characters can be returned.
+	// TODO: Support objects.
+	if(type->isReferenceType() && !type.getNonReferenceType().isConstQualified())
+	{
+		return false;
+	}
+
+	type = type.getNonReferenceType().getCanonicalType().getUnqualifiedType();
+	return type->isBuiltinType() && !type->isVoidType();
+}
+
+static bool isAsyncParameter(clang::QualType type)
+{
+	// The glue code copies string arguments for the worker thread.
+	if(isStringClass(type) || (type->isPointerType() && type->getPointeeType()->isCharType()))
+	{
+		return true;
+	}
+
+	return isAsyncValue(type);
+}
+
+static bool isAsyncFunction(const clang::FunctionDecl* decl)
+{
+	// Only functions that explicitly request it get an asynchronous bridge.
+	if(!hasAnnotation(decl, "autoglue::async"))
+	{
+		return false;
+	}
+
+	// Virtual functions could call back into foreign code from the worker thread.
+	auto* method = llvm::dyn_cast <clang::CXXMethodDecl> (decl);
+	if(!method || method->isVirtual() || method->isOverloadedOperator() ||
+		llvm::isa <clang::CXXConstructorDecl> (decl) ||
+		llvm::isa <clang::CXXDestructorDecl> (decl))
+	{
+		warnIgnored(decl, "autoglue::async", "only non-virtual member functions can be asynchronous");
+		return false;
+	}
+
+	if(!decl->getReturnType()->isVoidType() &&
+		(decl->getReturnType()->isReferenceType() || !isAsyncValue(decl->getReturnType())))
+	{
+		warnIgnored(decl, "autoglue::async", "the returned value has to be a number, a boolean or a character");
+		return false;
+	}
+
+	for(auto* param : decl->parameters())
+	{
+		if(!isAsyncParameter(param->getType()))
+		{
+			warnIgnored(decl, "autoglue::async", "the parameters have to be numbers, booleans, characters or strings");
+			return false;
+		}
+	}
+
+	return true;
+}
+
 class NodeVisitor : public clang::RecursiveASTVisitor <NodeVisitor>
 {
 public:
@@ -292,7 +848,10 @@ private:
 			return nullptr;
 		}
 
-		auto ret = resolveType(functionType->getReturnType());
+		// The trampolines of a callable pass the values as they are, so only
+		// numbers, booleans and characters are supported for now.
+		// TODO: Support strings and objects.
+		auto ret = resolveCallableValue(functionType->getReturnType());
 		if(!ret)
 		{
 			return nullptr;
@@ -301,24 +860,22 @@ private:
 		auto entity = std::make_shared <ag::CallableTypeEntity> (std::make_shared <ag::TypeReferenceEntity> (
 			"",
 			ret,
-			isReferenceType(functionType->getReturnType())
+			false
 		));
 
-		size_t paramIndex = 0;
 		for(unsigned i = 0; i < functionType->getNumParams(); i++)
 		{
-			auto paramType = functionType->getParamType(i);
-			auto paramTypeEntity = resolveType(paramType);
+			auto paramTypeEntity = resolveCallableValue(functionType->getParamType(i));
 
-			if(!paramTypeEntity)
+			if(!paramTypeEntity || paramTypeEntity->getType() == ag::PrimitiveEntity::Type::Void)
 			{
 				return nullptr;
 			}
 
 			entity->addParameter(std::make_shared <ag::TypeReferenceEntity> (
-				"param" + std::to_string(paramIndex),
+				"param" + std::to_string(i),
 				paramTypeEntity,
-				isReferenceType(paramType)
+				false
 			));
 		}
 
@@ -338,8 +895,49 @@ private:
 		return std::static_pointer_cast <ag::TypeEntity> (result);
 	}
 
+	std::shared_ptr <ag::PrimitiveEntity> resolveCallableValue(clang::QualType type)
+	{
+		type = type.getUnqualifiedType();
+
+		if(!type->isBuiltinType())
+		{
+			return nullptr;
+		}
+
+		assert(context);
+		auto primitive = std::static_pointer_cast <ag::PrimitiveEntity> (getPrimitive(type, *context));
+
+		if(!primitive || primitive->getType() == ag::PrimitiveEntity::Type::String ||
+			primitive->getType() == ag::PrimitiveEntity::Type::Buffer)
+		{
+			return nullptr;
+		}
+
+		return primitive;
+	}
+
 	std::shared_ptr <ag::TypeEntity> resolveType(clang::QualType type)
 	{
+		// std::string and std::string_view are passed as views of their contents
+		// instead of as objects, so that no bridge call is needed to read them.
+		if(isStringClass(type))
+		{
+			return ag::PrimitiveEntity::getString();
+		}
+
+		// std::span and std::vector of numbers are passed as buffers.
+		if(auto buffer = getBufferClass(type))
+		{
+			return buffer;
+		}
+
+		// std::function and function pointers are passed as callables.
+		auto callable = getCallableClass(type);
+		if(!callable.isNull())
+		{
+			return resolveFunctionType(callable);
+		}
+
 		type = type.getNonReferenceType();
 		type = type.getUnqualifiedType();
 
@@ -348,6 +946,11 @@ private:
 			return resolveFunctionType(type);
 		}
 
+		if(type->isFunctionPointerType())
+		{
+			return resolveFunctionType(type->getPointeeType());
+		}
+
 		// TODO: Ignore void pointers until there's a nice way to
 		// present them in the abstraction.
 		if(type->isVoidPointerType())
@@ -371,7 +974,8 @@ private:
 
 		if(type->isBuiltinType())
 		{
-			return getPrimitive(type);
+			assert(context);
+			return getPrimitive(type, *context);
 		}
 
 		else if(type->isTypedefNameType())
@@ -500,6 +1104,13 @@ private:
 			// Check if the declaration is a function.
 			else if(auto* functionNode = clang::dyn_cast <clang::FunctionDecl> (named))
 			{
+				// Value types have no functions, not even constructors.
+				if(ag::ClassEntity::matchType(*parentEntity) &&
+					static_cast <ag::ClassEntity&> (*parentEntity).isValueType())
+				{
+					return nullptr;
+				}
+
 				auto group = std::make_shared <ag::FunctionGroupEntity> (name, getFunctionType(functionNode));
 				group->initializeContext(std::make_shared <ag::clang::FunctionContext> (functionNode));
 
@@ -563,6 +1174,20 @@ private:
 					{
 						auto classEntity = std::static_pointer_cast <ag::ClassEntity> (result);
 
+						// Value types only consist of their fields.
+						assert(context);
+						if(initializeValueLayout(*classEntity, cxxDef, *context))
+						{
+							return result;
+						}
+
+						initializeStorageLayout(*classEntity, cxxDef, *context);
+
+						if(isPooledClass(cxxDef))
+						{
+							classEntity->setPooled();
+						}
+
 						// Since the class definition is available here, collect its base classes.
 						for(auto base : cxxDef->bases())
 						{
@@ -596,6 +1221,11 @@ private:
 							ensureFunctionExists(method);
 						}
 
+						else if(auto* field = clang::dyn_cast <clang::FieldDecl> (subDecl))
+						{
+							ensureFieldExists(field, *result);
+						}
+
 						else
 						{
 							ensureEntityExists(subDecl);
@@ -715,10 +1345,30 @@ private:
 			return;
 		}
 
+		// Value types are returned as copies, which can't represent a null pointer.
+		// TODO: Support pointers to value types.
+		if(isValueClass(returnTypeEntity) && decl->getReturnType()->isPointerType())
+		{
+			return;
+		}
+
+		// TODO: Support callables in interception functions.
+		auto* virtualNode = clang::dyn_cast <clang::CXXMethodDecl> (decl);
+		bool isVirtual = virtualNode && virtualNode->isVirtual();
+
+		if(isVirtual && returnTypeEntity->getType() == ag::TypeEntity::Type::Callable)
+		{
+			return;
+		}
+
+		// Borrowed buffers are returned as views of the original elements instead of copies.
+		// TODO: Support borrowed buffers in interception functions.
+		bool borrowed = !isVirtual && isBorrowedBuffer(decl->getReturnType());
+
 		auto returnEntity = std::make_shared <ag::TypeReferenceEntity> (
 			"",
 			returnTypeEntity,
-			isReferenceType(decl->getReturnType())
+			isReferenceType(decl->getReturnType()) || borrowed
 		);
 
 		returnEntity->initializeContext(std::make_shared <ag::clang::TyperefContext> (
@@ -743,6 +1393,29 @@ private:
 			entity->setProtected();
 		}
 
+		if(isLeafFunction(decl, returnTypeEntity->getType() == ag::TypeEntity::Type::Class &&
+							!isValueClass(returnTypeEntity) && !isReferenceType(decl->getReturnType())))
+		{
+			entity->setLeaf();
+		}
+
+		// Being a leaf function only affects the call transition, so whether
+		// exceptions are caught depends on the exception specification alone.
+		if(isThrowingFunction(decl))
+		{
+			entity->setThrowing();
+		}
+
+		if(isBatchedFunction(decl))
+		{
+			entity->setBatched();
+		}
+
+		if(isAsyncFunction(decl))
+		{
+			entity->setAsync();
+		}
+
 		// If the function is an operator overload, check which one it is.
 		if(decl->isOverloadedOperator())
 		{
@@ -758,10 +1431,36 @@ private:
 			entity->setOverloadedOperator(overloadedOperator, compound);
 		}
 
+		// A pointer to numbers followed by its size is treated as a buffer.
+		// The bridge of a virtual function or a constructor has to keep the original
+		// parameters, so they aren't merged there.
+		auto* methodNode = clang::dyn_cast <clang::CXXMethodDecl> (decl);
+		bool mergeBuffers = !clang::isa <clang::CXXConstructorDecl> (decl) && !(methodNode && methodNode->isVirtual());
+		auto params = decl->parameters();
+
 		size_t paramIndex = 1;
-		for(auto param : decl->parameters())
+		for(size_t i = 0; i < params.size(); i++)
 		{
-			auto paramTypeEntity = resolveType(param->getType());
+			auto* param = params[i];
+			std::shared_ptr <ag::TypeEntity> paramTypeEntity;
+			bool reference = isReferenceType(param->getType());
+
+			if(mergeBuffers && i + 1 < params.size())
+			{
+				paramTypeEntity = getBufferPointer(param->getType(), params[i + 1]);
+
+				// The size parameter is passed along with the buffer.
+				if(paramTypeEntity)
+				{
+					reference = false;
+					i++;
+				}
+			}
+
+			if(!paramTypeEntity)
+			{
+				paramTypeEntity = resolveType(param->getType());
+			}
 
 			if(!paramTypeEntity)
 			{
@@ -771,18 +1470,42 @@ private:
 				return;
 			}
 
+			// Foreign callables need a context pointer which a plain function pointer can't carry.
+			if(paramTypeEntity->getType() == ag::TypeEntity::Type::Callable &&
+				(isVirtual || getCallableClass(param->getType()).isNull()))
+			{
+				return;
+			}
+
+			// Value types are passed as copies, so changes made through pointers
+			// and non-const references wouldn't be visible to the caller.
+			// TODO: Support pointers and references to value types.
+			if(isValueClass(paramTypeEntity) && (param->getType()->isPointerType() ||
+				(param->getType()->isLValueReferenceType() && !param->getType().getNonReferenceType().isConstQualified())))
+			{
+				return;
+			}
+
 			auto name = param->getNameAsString();
 
 			auto paramEntity = std::make_shared <ag::TypeReferenceEntity> (
 				name.empty() ? "param" + std::to_string(paramIndex) : name,
 				paramTypeEntity,
-				isReferenceType(param->getType())
+				reference
 			);
 
 			paramEntity->initializeContext(std::make_shared <ag::clang::TyperefContext> (
 				param->getType(), decl->getASTContext()
 			));
 
+			// Objects passed through an rvalue reference are moved from, as are objects passed by value
+			// to a parameter marked as consuming. Foreign code then gives up the object instead of copying it.
+			if(paramTypeEntity->getType() == ag::TypeEntity::Type::Class && !isValueClass(paramTypeEntity) &&
+				(param->getType()->isRValueReferenceType() || (!reference && hasAnnotation(param, "autoglue::consume"))))
+			{
+				paramEntity->setConsumed();
+			}
+
 			entity->addParameter(std::move(paramEntity));
 			paramIndex++;
 		}
@@ -799,6 +1522,74 @@ private:
 		std::static_pointer_cast <ag::FunctionGroupEntity> (group)->addOverload(std::move(entity));
 	}
 
+	void ensureFieldExists(const clang::FieldDecl* decl, ag::Entity& parent)
+	{
+		// Only public fields that have a name and an address of their own are exported.
+		if(decl->getAccess() != clang::AccessSpecifier::AS_public || decl->isBitField() ||
+			decl->isAnonymousStructOrUnion() || decl->getName().empty())
+		{
+			return;
+		}
+
+		// References can't be assigned to and have no address of their own.
+		// TODO: Support arrays as buffers.
+		auto type = decl->getType();
+		if(type->isReferenceType() || type->isArrayType())
+		{
+			return;
+		}
+
+		auto name = decl->getNameAsString();
+		if(parent.resolve(name))
+		{
+			return;
+		}
+
+		auto typeEntity = resolveType(type);
+		if(!typeEntity)
+		{
+			//std::cerr << "Unable to add field " << decl->getQualifiedNameAsString() <<
+			//			": Failed to resolve type (" << type.getAsString() << ")\n";
+			return;
+		}
+
+		// Value types are returned as copies, which can't represent a null pointer.
+		if(isValueClass(typeEntity) && type->isPointerType())
+		{
+			return;
+		}
+
+		// Objects stored in fields are borrowed instead of being copied to the heap.
+		bool object = typeEntity->getType() == ag::TypeEntity::Type::Class && !isValueClass(typeEntity);
+		bool reference = object || isReferenceType(type);
+
+		// Assigning an object or a pointer could leave the field referring to foreign memory.
+		// TODO: Allow assigning copyable objects.
+		bool readOnly = type.isConstQualified() || type->isPointerType() || reference;
+
+		auto typeRef = std::make_shared <ag::TypeReferenceEntity> (name, typeEntity, reference);
+		typeRef->initializeContext(std::make_shared <ag::clang::TyperefContext> (type, decl->getASTContext()));
+
+		auto entity = std::make_shared <ag::FieldEntity> (name, std::move(typeRef), readOnly);
+
+		// Numbers can be accessed directly through an object handle if their offset is the same
+		// for every object of the class and they have the same size as the foreign type.
+		auto* record = clang::dyn_cast <clang::CXXRecordDecl> (decl->getParent());
+		auto canonical = type.getCanonicalType();
+
+		if((!record || record->isStandardLayout()) && !canonical.isVolatileQualified() &&
+			canonical->isBuiltinType() && !canonical->isSpecificBuiltinType(clang::BuiltinType::LongDouble) &&
+			!(canonical->isAnyCharacterType() && decl->getASTContext().getTypeSize(canonical) != 8))
+		{
+			auto& layout = decl->getASTContext().getASTRecordLayout(decl->getParent());
+			entity->setOffset(decl->getASTContext().toCharUnitsFromBits(
+				layout.getFieldOffset(decl->getFieldIndex())
+			).getQuantity());
+		}
+
+		parent.addChild(std::move(entity));
+	}
+
 	std::string getDeclInclusion(const clang::NamedDecl* decl)
 	{
 		auto loc = decl->getLocation();
@@ -843,6 +1634,9 @@ private:
 
 	ag::clang::Backend& backend;
 	clang::SourceManager& sourceManager;
+
+	/// The context of the translation unit being traversed.
+	clang::ASTContext* context = nullptr;
 };
 
 class HierarchyGenerator : public clang::ASTConsumer
@@ -856,6 +1650,7 @@ public:
 private:
 	void HandleTranslationUnit(clang::ASTContext& context) override
 	{
+		visitor.context = &context;
 		visitor.TraverseDecl(context.getTranslationUnitDecl());
 	}
 
@@ -994,6 +1789,11 @@ std::string Backend::getInclusion(const std::string& path)
 	return std::string();
 }
 
+GlueOptions& Backend::getGlueOptions()
+{
+	return glueOptions;
+}
+
 bool Backend::generateHierarchy()
 {
 	if(!database)
@@ -1027,6 +1827,7 @@ void Backend::generateGlue()
 {
 	GlueGenerator glueGen(*this);
 	glueGen.generateBindings(false);
+	glueGen.generateBridgeTable();
 }
 
 void Backend::disableUntrivialNew(ClassEntity& entity)
@@ -9,6 +9,7 @@
 #include <autoglue/TypeReferenceEntity.hh>
 #include <autoglue/FunctionGroupEntity.hh>
 #include <autoglue/FunctionEntity.hh>
+#include <autoglue/FieldEntity.hh>
 
 #include <iostream>
 #include <set>
@@ -56,21 +57,380 @@ static std::string getSelfType(FunctionEntity& entity)
 
 }
 
-void generateTypePOD(std::ofstream& file, TypeReferenceEntity& entity)
+static void generateViewTypes(std::ostream& file)
 {
+	// Strings are passed as UTF-8 data and its length in bytes. Strings passed
+	// to the glue code are also null terminated so that they can be used as C strings.
+	// The guard lets foreign glue define the same type.
+	file << "#ifndef AG_STRING_DEFINED\n";
+	file << "#define AG_STRING_DEFINED\n";
+	file << "struct AG_String\n{\nconst char* data;\nsize_t size;\n};\n";
+	file << "#endif\n";
+
+	// Buffers are passed as a pointer to their elements and the count of elements.
+	file << "#ifndef AG_BUFFER_DEFINED\n";
+	file << "#define AG_BUFFER_DEFINED\n";
+	file << "struct AG_Buffer\n{\nvoid* data;\nsize_t size;\n};\n";
+	file << "#endif\n";
+
+	// Callables are passed as a trampoline that is called with the context
+	// and the arguments, and a function that releases the context.
+	file << "#ifndef AG_CALLABLE_DEFINED\n";
+	file << "#define AG_CALLABLE_DEFINED\n";
+	file << "struct AG_Callable\n{\nvoid* invoke;\nvoid* context;\nvoid (*release)(void*);\n};\n";
+	file << "#endif\n";
+
+	// Potentially throwing bridge functions take a pointer to an error slot that the
+	// caller has zeroed. The kind stays zero unless an exception has been caught.
+	file << "#ifndef AG_ERROR_DEFINED\n";
+	file << "#define AG_ERROR_DEFINED\n";
+	file << "struct AG_Error\n{\nint32_t kind;\nconst char* message;\n};\n";
+	file << "#endif\n";
+}
+
+static void generateAllocationPool(std::ostream& header)
+{
+	header << "#include <algorithm>\n";
+	header << "#include <mutex>\n";
+	header << "#include <vector>\n";
+
+	header << "struct AG_AllocationStats\n{\n";
+	header << "uint64_t allocations;\n";
+	header << "uint64_t deallocations;\n";
+	header << "uint64_t reused;\n";
+	header << "uint64_t heapAllocations;\n};\n";
+
+	// Blocks come in power of two size classes starting from 32 bytes. Each block starts
+	// with a header holding its size class so that it can be freed on any thread.
+	header << "constexpr size_t AG_poolHeaderSize = alignof(std::max_align_t);\n";
+	header << "constexpr size_t AG_poolClasses = 6;\n";
+	header << "constexpr size_t AG_poolLimit = 256;\n";
+
+	// A thread keeps a limited amount of free blocks and returns them to the heap when it exits.
+	// Blocks freed after the lists are gone go straight back to the heap.
+	header << "struct AG_FreeBlock\n{\nAG_FreeBlock* next;\n};\n";
+	header << "struct AG_FreeLists;\n";
+	header << "void AG_attachFreeLists(AG_FreeLists* lists);\n";
+	header << "void AG_detachFreeLists(AG_FreeLists* lists);\n";
+	header << "struct AG_FreeLists\n{\n";
+	header << "AG_FreeLists() { AG_attachFreeLists(this); }\n";
+	header << "~AG_FreeLists()\n{\n";
+	header << "AG_detachFreeLists(this);\n";
+	header << "alive = false;\n";
+	header << "for(auto*& head : heads)\n{\n";
+	header << "while(head) { auto* next = head->next; ::operator delete(head); head = next; }\n}\n}\n";
+	header << "AG_FreeBlock* heads[AG_poolClasses] = {};\n";
+	header << "size_t counts[AG_poolClasses] = {};\n";
+	header << "bool alive = true;\n";
+
+	// Each thread counts allocations in counters that only it writes to, so counting doesn't
+	// need a locked instruction or share cache lines with other threads. AG_getAllocationStats
+	// sums the counters of every thread. Threads that allocate or free after their lists are
+	// gone count in counters shared by such threads.
+	header << "std::atomic <uint64_t> counters[4] = {};\n};\n";
+	header << "inline thread_local AG_FreeLists AG_freeLists;\n";
+	header << "inline std::atomic <uint64_t> AG_lateAllocationCounters[4];\n";
+	header << "inline void AG_countAllocation(size_t counter)\n{\n";
+	header << "if(!AG_freeLists.alive) { AG_lateAllocationCounters[counter].fetch_add(1, std::memory_order_relaxed); return; }\n";
+	header << "auto& value = AG_freeLists.counters[counter];\n";
+	header << "value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);\n}\n";
+
+	header << "inline void* AG_allocate(size_t size)\n{\n";
+	header << "size_t index = 0;\n";
+	header << "while(index < AG_poolClasses && (size_t(32) << index) < size + AG_poolHeaderSize) { index++; }\n";
+	header << "AG_countAllocation(0);\n";
+	header << "void* block;\n";
+	header << "if(index < AG_poolClasses && AG_freeLists.heads[index])\n{\n";
+	header << "block = AG_freeLists.heads[index];\n";
+	header << "AG_freeLists.heads[index] = AG_freeLists.heads[index]->next;\n";
+	header << "AG_freeLists.counts[index]--;\n";
+	header << "AG_countAllocation(2);\n}\n";
+	header << "else\n{\n";
+	header << "block = ::operator new(index < AG_poolClasses ? size_t(32) << index : size + AG_poolHeaderSize);\n";
+	header << "AG_countAllocation(3);\n}\n";
+	header << "*static_cast <size_t*> (block) = index;\n";
+	header << "return static_cast <char*> (block) + AG_poolHeaderSize;\n}\n";
+
+	header << "inline void AG_deallocate(void* data)\n{\n";
+	header << "void* block = static_cast <char*> (data) - AG_poolHeaderSize;\n";
+	header << "size_t index = *static_cast <size_t*> (block);\n";
+	header << "AG_countAllocation(1);\n";
+	header << "if(index < AG_poolClasses && AG_freeLists.alive && AG_freeLists.counts[index] < AG_poolLimit)\n{\n";
+	header << "auto* free = static_cast <AG_FreeBlock*> (block);\n";
+	header << "free->next = AG_freeLists.heads[index];\n";
+	header << "AG_freeLists.heads[index] = free;\n";
+	header << "AG_freeLists.counts[index]++;\n";
+	header << "return;\n}\n";
+	header << "::operator delete(block);\n}\n";
+
+	// Objects are created with "::new (AG_pool)" which bypasses any class specific operator new.
+	// Over-aligned types use the aligned global heap since the blocks are only aligned for std::max_align_t.
+	header << "struct AG_PoolTag {};\n";
+	header << "inline constexpr AG_PoolTag AG_pool{};\n";
+	header << "inline void* operator new(size_t size, AG_PoolTag) { return AG_allocate(size); }\n";
+	header << "inline void operator delete(void* data, AG_PoolTag) noexcept { AG_deallocate(data); }\n";
+	header << "inline void* operator new(size_t size, std::align_val_t alignment, AG_PoolTag) { return ::operator new(size, alignment); }\n";
+	header << "inline void operator delete(void* data, std::align_val_t alignment, AG_PoolTag) noexcept { ::operator delete(data, alignment); }\n";
+
+	// Polymorphic objects are freed starting from the most derived object.
+	header << "template <typename T>\n";
+	header << "void AG_delete(T* object)\n{\n";
+	header << "if constexpr(alignof(T) > alignof(std::max_align_t)) { delete object; }\n";
+	header << "else\n{\n";
+	header << "void* data = object;\n";
+	header << "if constexpr(std::is_polymorphic_v <T>) { data = dynamic_cast <void*> (object); }\n";
+	header << "object->~T();\n";
+	header << "AG_deallocate(data);\n}\n}\n";
+}
+
+static void generateErrorHandling(std::ostream& header)
+{
+	header << "#include <exception>\n";
+	header << "#include <stdexcept>\n";
+
+	// The caught exception is mapped to a kind that foreign code translates to its own
+	// exception type. The message is copied to a per-thread buffer, which stays valid
+	// until the next exception on the same thread, so that reporting doesn't allocate.
+	header << "inline void AG_catch(AG_Error* error) noexcept\n{\n";
+	header << "thread_local char message[512];\n";
+	header << "auto report = [&](int32_t kind, const char* what)\n{\n";
+	header << "strncpy(message, what, sizeof(message) - 1);\n";
+	header << "error->kind = kind;\n";
+	header << "error->message = message;\n};\n";
+	header << "try { throw; }\n";
+	header << "catch(const std::invalid_argument& e) { report(2, e.what()); }\n";
+	header << "catch(const std::out_of_range& e) { report(3, e.what()); }\n";
+	header << "catch(const std::bad_alloc& e) { report(4, e.what()); }\n";
+	header << "catch(const std::exception& e) { report(1, e.what()); }\n";
+	header << "catch(...) { report(1, \"Unknown exception\"); }\n}\n";
+}
+
+static void generateExport(std::ostream& file)
+{
+	// Exported like AG_getBridgeTable so that it can be called even when the bridge functions are hidden.
+	file << "#if defined(_WIN32)\n";
+	file << "extern \"C\" __declspec(dllexport)\n";
+	file << "#else\n";
+	file << "extern \"C\" __attribute__((visibility(\"default\")))\n";
+	file << "#endif\n";
+}
+
+static void generateCallCounters(std::ostream& header, size_t sampling)
+{
+	header << "#include <algorithm>\n";
+	header << "#include <chrono>\n";
+	header << "#include <mutex>\n";
+
+	// Latency bucket 0 holds calls shorter than 64 ns and each following bucket
+	// doubles the limit. The last bucket holds every call from about 1 ms up.
+	header << "constexpr size_t AG_latencyBuckets = 16;\n";
+	header << "#ifndef AG_BRIDGE_STATS_DEFINED\n";
+	header << "#define AG_BRIDGE_STATS_DEFINED\n";
+	header << "struct AG_BridgeStats\n{\n";
+	header << "uint64_t calls;\n";
+	header << "uint64_t latencies[AG_latencyBuckets];\n};\n";
+	header << "#endif\n";
+
+	// Each thread counts calls in counters that only it writes to, so counting
+	// doesn't need a locked instruction or share cache lines with other threads.
+	header << "struct AG_BridgeCounters\n{\n";
+	header << "std::atomic <uint64_t> calls{};\n";
+
+	if(sampling > 0)
+	{
+		header << "std::atomic <uint64_t> latencies[AG_latencyBuckets]{};\n";
+	}
+
+	header << "};\n";
+	header << "inline thread_local AG_BridgeCounters* AG_threadCounters = nullptr;\n";
+	header << "AG_BridgeCounters* AG_attachBridgeCounters();\n";
+	header << "inline void AG_increment(std::atomic <uint64_t>& counter)\n{\n";
+	header << "counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);\n}\n";
+
+	header << "class AG_BridgeCall\n{\npublic:\n";
+	header << "explicit AG_BridgeCall(size_t index)\n";
+	header << "\t: counters((AG_threadCounters ? AG_threadCounters : AG_attachBridgeCounters())[index])\n{\n";
+	header << "AG_increment(counters.calls);\n";
+
+	if(sampling > 1)
+	{
+		header << "if(counters.calls.load(std::memory_order_relaxed) % " << sampling << " == 0)\n{\n";
+		header << "start = std::chrono::steady_clock::now();\n}\n";
+	}
+
+	else if(sampling == 1)
+	{
+		header << "start = std::chrono::steady_clock::now();\n";
+	}
+
+	header << "}\n";
+
+	// The elapsed time is recorded when the bridge function returns.
+	if(sampling > 0)
+	{
+		header << "~AG_BridgeCall()\n{\n";
+		header << "if(start == std::chrono::steady_clock::time_point()) { return; }\n";
+		header << "auto elapsed = std::chrono::duration_cast <std::chrono::nanoseconds> (std::chrono::steady_clock::now() - start).count();\n";
+		header << "size_t bucket = 0;\n";
+		header << "while(bucket + 1 < AG_latencyBuckets && (int64_t(64) << bucket) <= elapsed) { bucket++; }\n";
+		header << "AG_increment(counters.latencies[bucket]);\n}\n";
+	}
+
+	header << "private:\n";
+	header << "AG_BridgeCounters& counters;\n";
+
+	if(sampling > 0)
+	{
+		header << "std::chrono::steady_clock::time_point start;\n";
+	}
+
+	header << "};\n";
+}
+
+static void generateWorkerPool(std::ostream& header, size_t workers)
+{
+	header << "#include <condition_variable>\n";
+	header << "#include <deque>\n";
+	header << "#include <exception>\n";
+	header << "#include <mutex>\n";
+	header << "#include <thread>\n";
+
+	// The workers are started on the first asynchronous call. The pool is never destroyed
+	// since joining the workers while the library is unloaded could deadlock, and work that
+	// is still queued at that point can't be completed for a foreign runtime that is gone.
+	header << "class AG_WorkerPool\n{\npublic:\n";
+	header << "AG_WorkerPool()\n{\n";
+
+	if(workers == 0)
+	{
+		header << "size_t count = std::thread::hardware_concurrency();\n";
+		header << "if(count == 0) { count = 1; }\n";
+	}
+
+	else
+	{
+		header << "size_t count = " << workers << ";\n";
+	}
+
+	header << "for(size_t i = 0; i < count; i++) { std::thread([this] { run(); }).detach(); }\n}\n";
+
+	header << "void submit(std::function <void()> work)\n{\n";
+	header << "{\nstd::lock_guard <std::mutex> lock(mutex);\n";
+	header << "queue.push_back(std::move(work));\n}\n";
+	header << "ready.notify_one();\n}\n";
+
+	header << "private:\n";
+	header << "void run()\n{\n";
+	header << "while(true)\n{\n";
+	header << "std::function <void()> work;\n";
+	header << "{\nstd::unique_lock <std::mutex> lock(mutex);\n";
+	header << "ready.wait(lock, [this] { return !queue.empty(); });\n";
+	header << "work = std::move(queue.front());\n";
+	header << "queue.pop_front();\n}\n";
+	header << "work();\n}\n}\n";
+
+	header << "std::mutex mutex;\n";
+	header << "std::condition_variable ready;\n";
+	header << "std::deque <std::function <void()>> queue;\n};\n";
+
+	header << "inline AG_WorkerPool& AG_getWorkerPool()\n{\n";
+	header << "static AG_WorkerPool* pool = new AG_WorkerPool;\n";
+	header << "return *pool;\n}\n";
+
+	// Exceptions can't cross into foreign code, so the completion function receives
+	// the message of the exception instead. The message is null if the call succeeded.
+	header << "template <typename R, typename F>\n";
+	header << "void AG_runAsync(F call, void (*complete)(void*, const char*, R), void* context)\n{\n";
+	header << "AG_getWorkerPool().submit([call, complete, context]\n{\n";
+	header << "R result{};\n";
+	header << "std::string error;\n";
+	header << "bool failed = false;\n";
+	header << "try { result = call(); }\n";
+	header << "catch(const std::exception& e) { failed = true; error = e.what(); }\n";
+	header << "catch(...) { failed = true; error = \"Unknown exception\"; }\n";
+	header << "complete(context, failed ? error.c_str() : nullptr, result);\n});\n}\n";
+
+	header << "template <typename F>\n";
+	header << "void AG_runAsync(F call, void (*complete)(void*, const char*), void* context)\n{\n";
+	header << "AG_getWorkerPool().submit([call, complete, context]\n{\n";
+	header << "std::string error;\n";
+	header << "bool failed = false;\n";
+	header << "try { call(); }\n";
+	header << "catch(const std::exception& e) { failed = true; error = e.what(); }\n";
+	header << "catch(...) { failed = true; error = \"Unknown exception\"; }\n";
+	header << "complete(context, failed ? error.c_str() : nullptr);\n});\n}\n";
+}
+
+static std::string getValueName(ClassEntity& entity)
+{
+	return "AG_Value_" + entity.getHierarchy("_");
+}
+
+void generateTypePOD(std::ostream& file, TypeReferenceEntity& entity)
+{
+	// Value types are passed as structs mirroring their fields.
+	if(entity.getType() == TypeEntity::Type::Class)
+	{
+		assert(entity.getClassType().isValueType());
+		file << getValueName(entity.getClassType());
+		return;
+	}
+
+	if(entity.getType() == TypeEntity::Type::Callable)
+	{
+		file << "AG_Callable";
+		return;
+	}
+
 	switch(entity.getPrimitiveType().getType())
 	{
-		case PrimitiveEntity::Type::String: file << "const char *"; break;
+		case PrimitiveEntity::Type::String: file << "AG_String"; break;
+		case PrimitiveEntity::Type::Buffer: file << "AG_Buffer"; break;
 		case PrimitiveEntity::Type::ObjectHandle: file << "void*"; break;
 		case PrimitiveEntity::Type::Character: file << "char"; break;
 		case PrimitiveEntity::Type::Double: file << "double"; break;
 		case PrimitiveEntity::Type::Boolean: file << "bool"; break;
 		case PrimitiveEntity::Type::Float: file << "float"; break;
 		case PrimitiveEntity::Type::Integer: file << "int"; break;
+		case PrimitiveEntity::Type::Int8: file << "int8_t"; break;
+		case PrimitiveEntity::Type::Int16: file << "int16_t"; break;
+		case PrimitiveEntity::Type::Int64: file << "int64_t"; break;
+		case PrimitiveEntity::Type::UInt8: file << "uint8_t"; break;
+		case PrimitiveEntity::Type::UInt16: file << "uint16_t"; break;
+		case PrimitiveEntity::Type::UInt32: file << "uint32_t"; break;
+		case PrimitiveEntity::Type::UInt64: file << "uint64_t"; break;
+		case PrimitiveEntity::Type::IntPtr: file << "intptr_t"; break;
+		case PrimitiveEntity::Type::UIntPtr: file << "uintptr_t"; break;
 		case PrimitiveEntity::Type::Void: file << "void"; break;
 	}
 }
 
+static void generateValueTypes(std::ostream& file, const std::vector <std::shared_ptr <ClassEntity>>& valueTypes)
+{
+	// A value type is passed as a struct that has the same layout as the original class.
+	// The guard lets foreign glue define the same type.
+	for(auto& value : valueTypes)
+	{
+		auto name = getValueName(*value);
+
+		file << "#ifndef " << name << "_DEFINED\n";
+		file << "#define " << name << "_DEFINED\n";
+		file << "struct alignas(" << value->getValueAlignment() << ") " << name << "\n{\n";
+
+		for(size_t i = 0; i < value->getValueFieldCount(); i++)
+		{
+			auto& field = value->getValueField(i);
+			TypeReferenceEntity fieldType(field.name, field.type, false);
+
+			generateTypePOD(file, fieldType);
+			file << ' ' << field.name << ";\n";
+		}
+
+		file << "};\n";
+		file << "#endif\n";
+	}
+}
+
 class IncludeCollector : public BindingGenerator
 {
 public:
@@ -92,6 +452,16 @@ public:
 			addInclude(ctx->getTypeContext()->getInclude());
 		}
 
+		if(entity.isValueType())
+		{
+			valueTypes.push_back(entity.shared_from_this());
+		}
+
+		if(entity.isPooled())
+		{
+			pooledClasses = true;
+		}
+
 		entity.generateNested(*this);
 	}
 
@@ -99,6 +469,21 @@ public:
 	{
 		entity.generateReturnType(*this, true);
 		entity.generateParameters(*this, true, true);
+
+		if(entity.isAsync())
+		{
+			asyncFunctions = true;
+		}
+
+		if(entity.isThrowing())
+		{
+			throwingFunctions = true;
+		}
+	}
+
+	void generateField(FieldEntity& entity) override
+	{
+		generateFunction(entity.getGetter());
 	}
 
 	void generateTypeReference(TypeReferenceEntity& entity) override
@@ -108,7 +493,7 @@ public:
 			auto ctx = getClangContext(entity.getReferred());
 			if(ctx)
 			{
-				includes.emplace("#include <" + ctx->getTypeContext()->getInclude() + ">");
+				addInclude(ctx->getTypeContext()->getInclude());
 			}
 		}
 	}
@@ -117,18 +502,22 @@ public:
 	{
 		if(!include.empty())
 		{
-			includes.emplace("#include <" + include + ">");
+			includes.emplace(include);
 		}
 	}
 
 	std::set <std::string> includes;
+	std::vector <std::shared_ptr <ClassEntity>> valueTypes;
+	bool asyncFunctions = false;
+	bool throwingFunctions = false;
+	bool pooledClasses = false;
 };
 
 class ClassGenerator : public ag::BindingGenerator
 {
 public:
 	ClassGenerator(Backend& backend, std::ofstream& file)
-		: BindingGenerator(backend), file(file)
+		: BindingGenerator(backend), file(file), poolAllocations(backend.getGlueOptions().poolAllocations)
 	{
 	}
 
@@ -141,6 +530,12 @@ public:
 
 	void generateClass(ClassEntity& entity) override
 	{
+		// Value types are copied as they are and need no impersonating class.
+		if(entity.isValueType())
+		{
+			return;
+		}
+
 		if(!entity.isConcreteType())
 		{
 			file << "struct " << "AG_" << entity.getName();
@@ -232,12 +627,13 @@ public:
 
 			else
 			{
+				// Field accessors have no overload context as they aren't C++ functions.
 				auto ctx = getClangContext(entity);
-				assert(ctx);
+				assert(ctx || entity.getAccessedField());
 
 				// Don't generate in-class bridges for private interface overrides
 				// as they simply call a virtual bridge function and don't need data access.
-				if(ctx->getOverloadContext()->isPrivateOverride())
+				if(ctx && ctx->getOverloadContext()->isPrivateOverride())
 				{
 					return;
 				}
@@ -251,7 +647,14 @@ public:
 				file << "AG_virtual_";
 			}
 
-			file << entity.getBridgeName(true) << '(';
+			file << (inStorage ? entity.getStorageBridgeName(true) : entity.getBridgeName(true)) << '(';
+
+			// The storage that a returned object is constructed into comes first.
+			if(inStorage && entity.getType() != FunctionEntity::Type::Destructor)
+			{
+				file << "void* AG_storage" << (entity.getParameterCount(true) > 0 ? ", " : "");
+			}
+
 			entity.generateParameters(*this, true, true);
 			file << ")\n{\n    ";
 
@@ -264,6 +667,23 @@ public:
 			}
 
 			file << ";\n}\n";
+
+			if(!inStorage && entity.hasStorageBridge())
+			{
+				inStorage = true;
+				generateFunction(entity);
+				inStorage = false;
+			}
+		}
+	}
+
+	void generateField(FieldEntity& entity) override
+	{
+		generateFunction(entity.getGetter());
+
+		if(!entity.isReadOnly())
+		{
+			generateFunction(entity.getSetter());
 		}
 	}
 
@@ -288,6 +708,25 @@ public:
 		{
 			case FunctionEntity::Type::MemberFunction:
 			{
+				// Field accessors read or assign the field directly.
+				if(auto* field = entity.getAccessedField())
+				{
+					file << "static_cast <AG_" << entity.getParent().getHierarchy("::AG_") << "*> (" <<
+							getObjectHandleName() << ")->" << field->getName();
+
+					// Setters assign their only parameter to the field.
+					if(entity.getParameterCount() > 0)
+					{
+						file << " = ";
+
+						onlyParameterNames = true;
+						entity.generateParameters(*this, false, false);
+						onlyParameterNames = false;
+					}
+
+					break;
+				}
+
 				if(entity.isConcreteOverride())
 				{
 					assert(!entity.isStatic());
@@ -350,8 +789,23 @@ public:
 							"*> (" << getObjectHandleName() << ")->data()));\n";
 				}
 
-				file << "delete static_cast <AG_" << entity.getParent().getHierarchy("::AG_") <<
-						"*> (" << getObjectHandleName() << ')';
+				// Objects in foreign storage are only destroyed since the storage isn't owned by the glue code.
+				if(inStorage)
+				{
+					auto ctx = getClangContext(entity.getParent());
+					assert(ctx);
+
+					file << "std::destroy_at(static_cast <" << ctx->getTypeContext()->getRealName() << "*> (" <<
+							getObjectHandleName() << "))";
+
+					break;
+				}
+
+				// Pooled objects are returned to the free lists.
+				bool pooled = isPooled(static_cast <ClassEntity&> (entity.getParent()));
+				file << (pooled ? "AG_delete(" : "delete ") << "static_cast <AG_" <<
+						entity.getParent().getHierarchy("::AG_") << "*> (" << getObjectHandleName() << ')' <<
+						(pooled ? ")" : "");
 
 				break;
 			}
@@ -378,13 +832,39 @@ public:
 			int toClose = 0;
 			file << "return ";
 
+			if(entity.isPrimitive() && entity.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
+			{
+				auto ctx = getClangContext(entity);
+				assert(ctx);
+
+				file << "AG_storeString <" << ctx->getTyperefContext()->getOriginalType() << "> (AG_returned_" <<
+						target.getBridgeName(true) << ", ";
+
+				target.generateBridgeCall(*this);
+				file << ')';
+				return false;
+			}
+
+			if(entity.isPrimitive() && entity.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
+			{
+				auto ctx = getClangContext(entity);
+				assert(ctx);
+
+				file << "AG_storeBuffer <" << ctx->getTyperefContext()->getOriginalType() << "> (AG_returned_" <<
+						target.getBridgeName(true) << ", ";
+
+				target.generateBridgeCall(*this);
+				file << ')';
+				return false;
+			}
+
 			if(!entity.isReference())
 			{
 				// If the type to return isn't trivially copyable, let's move it instead and
 				// return the object that way.
 				// TODO: What if the type isn't moveable?
 				auto ctx = getClangContext(entity);
-				if(ctx && !ctx->getTyperefContext()->isTypeTriviallyCopyable())
+				if(ctx && !entity.isPrimitive() && !ctx->getTyperefContext()->isTypeTriviallyCopyable())
 				{
 					file << "std::move(";
 					toClose++;
@@ -408,11 +888,21 @@ public:
 			file << "return ";
 
 			// If a non-reference class type is returned, return a heap allocated copy of it.
-			if(!entity.isReference() && entity.getType() == TypeEntity::Type::Class)
+			// Value types are returned as copies of their fields instead.
+			if(!entity.isReference() && entity.getType() == TypeEntity::Type::Class &&
+				!entity.getClassType().isValueType())
 			{
 				// TODO: What if the "operator new" is protected and new is invoked
 				// and this class has no access to it (Class of different type).
-				file << "new ";
+				if(inStorage)
+				{
+					file << "::new (AG_storage) ";
+				}
+
+				else
+				{
+					file << (isPooled(entity.getClassType()) ? "::new (AG_pool) " : "new ");
+				}
 
 				// If this is not a constructor call, specify the type.
 				if(target.getType() != FunctionEntity::Type::Constructor)
@@ -447,7 +937,8 @@ public:
 
 			else
 			{
-				assert(entity.isPrimitive());
+				assert(entity.isPrimitive() || entity.getType() == TypeEntity::Type::Class ||
+						entity.getType() == TypeEntity::Type::Callable);
 				generateTypePOD(file, entity);
 			}
 
@@ -487,6 +978,20 @@ public:
 		// Parameters passed in class bridge functions.
 		else
 		{
+			// A buffer that was a pointer is passed along with its size.
+			if(entity.isPrimitive() && entity.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
+			{
+				auto ctx = getClangContext(entity);
+				assert(ctx);
+
+				if(ctx->getTyperefContext()->isPointer())
+				{
+					file << "static_cast <" << ctx->getTyperefContext()->getWrittenType() << "*> (" <<
+							entity.getName() << ".data), " << entity.getName() << ".size";
+					return;
+				}
+			}
+
 			int toClose = generateForeignToGlue(entity);
 			file << entity.getName();
 
@@ -498,14 +1003,33 @@ public:
 		}
 	}
 
-	void generateInterceptionFunction(FunctionEntity& entity, ClassEntity&) override
+	void generateInterceptionFunction(FunctionEntity& entity, ClassEntity& parentClass) override
 	{
+		// The index of the interception function is its position in the override mask.
+		size_t index = interceptionIndex++;
+
 		if(entity.getType() == FunctionEntity::Type::Destructor ||
 			entity.getOverloadedOperator() != FunctionEntity::OverloadedOperator::None)
 		{
 			return;
 		}
 
+		// Returned strings and buffers are stored here, see AG_storeString and AG_storeBuffer.
+		auto returned = entity.getReturnType(true);
+		if(returned.isPrimitive() && returned.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
+		{
+			file << "std::string AG_returned_" << entity.getBridgeName(true) << ";\n";
+		}
+
+		else if(returned.isPrimitive() && returned.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
+		{
+			auto ctx = getClangContext(entity.getReturnType());
+			assert(ctx);
+
+			file << "AG_BufferStorage <" << ctx->getTyperefContext()->getOriginalType() << "> AG_returned_" <<
+					entity.getBridgeName(true) << ";\n";
+		}
+
 		entity.generateReturnType(*this, true);
 		file << "(*AG_intercept_" << entity.getBridgeName(true) << ")(";
 		entity.generateParameters(*this, true, true);
@@ -518,6 +1042,30 @@ public:
 		inOverride = false;
 
 		file << ") " << getClangContext(entity)->getOverloadContext()->getEastQualifiers() << "override\n{\n";
+
+		// If the foreign class doesn't override this function, call the base implementation
+		// directly. Interfaces have no base implementation and functions that don't fit
+		// in the mask are always intercepted. Private overrides are always intercepted
+		// as well, since the base implementation can't be called from a derived class.
+		auto overridden = entity.getOverridden();
+		auto ctx = getClangContext(parentClass);
+		auto functionCtx = getClangContext(entity);
+		bool privateOverride = functionCtx && functionCtx->getOverloadContext()->isPrivateOverride();
+
+		if(index < overrideMaskBits && ctx && !privateOverride && !(overridden && overridden->isInterface()))
+		{
+			file << "if(!(AG_overrides & (uint64_t(1) << " << index << ")))\n{\n";
+			file << "return " << ctx->getTypeContext()->getRealName() << "::" << entity.getName() << '(';
+
+			inOverride = true;
+			onlyParameterNames = true;
+			entity.generateParameters(*this, false, false);
+			onlyParameterNames = false;
+			inOverride = false;
+
+			file << ");\n}\n";
+		}
+
 		inIntercept = true;
 
 		if(entity.returnsValue())
@@ -537,6 +1085,10 @@ public:
 	void generateInterceptionContext(ClassEntity&) override
 	{
 		file << "void* AG_foreignObject;\n";
+
+		// Bit N is set when the foreign class overrides the Nth interception function.
+		file << "uint64_t AG_overrides = ~uint64_t(0);\n";
+		interceptionIndex = 0;
 	}
 
 	void generateArgumentSeparator() override
@@ -555,6 +1107,13 @@ public:
 		{
 			case TypeEntity::Type::Class:
 			{
+				// Value types are copied to their mirror structs.
+				if(entity.getClassType().isValueType())
+				{
+					file << "AG_copyValue <" << getValueName(entity.getClassType()) << "> (";
+					return true;
+				}
+
 				if(inIntercept || entity.isReference())
 				{
 					auto ctx = getClangContext(entity);
@@ -585,11 +1144,29 @@ public:
 			}
 
 			case TypeEntity::Type::Primitive:
-			case TypeEntity::Type::Callable:
 			{
+				// Strings are passed as views of the original string when possible.
+				if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
+				{
+					file << "AG_makeString(";
+					return true;
+				}
+
+				else if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
+				{
+					file << "AG_makeBuffer(";
+					return true;
+				}
+
 				return false;
 			}
 
+			case TypeEntity::Type::Callable:
+			{
+				file << "AG_makeCallable(";
+				return true;
+			}
+
 			case TypeEntity::Type::Alias:
 			{
 				TypeReferenceEntity underlying("", entity.getAliasType().getUnderlying(true), entity.isReference());
@@ -612,7 +1189,16 @@ public:
 				auto ctx = getClangContext(entity);
 				assert(ctx);
 
-				if(ctx->getTyperefContext()->isRValueReference())
+				// Value types are copied from their mirror structs.
+				if(entity.getClassType().isValueType())
+				{
+					file << "AG_copyValue <" << ctx->getTyperefContext()->getWrittenType() << "> (";
+					toClose++;
+					break;
+				}
+
+				// Consumed objects are moved from instead of being copied.
+				if(ctx->getTyperefContext()->isRValueReference() || entity.isConsumed())
 				{
 					file << "std::move(";
 					toClose++;
@@ -643,11 +1229,34 @@ public:
 
 			case TypeEntity::Type::Primitive:
 			{
-				// If a string should be duplicated, pass it into stdup.
-				if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::String && duplicateString)
+				if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
+				{
+					auto ctx = getClangContext(entity);
+					assert(ctx);
+
+					// If a string should be duplicated, pass it into stdup.
+					if(duplicateString)
+					{
+						file << "strdup(";
+						toClose++;
+					}
+
+					// The string view is converted to whatever string type the function expects.
+					file << "AG_fromString <" << ctx->getTyperefContext()->getOriginalType() << "> (";
+					toClose++;
+
+					break;
+				}
+
+				if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
 				{
-					file << "strdup(";
+					auto ctx = getClangContext(entity);
+					assert(ctx);
+
+					file << "AG_fromBuffer <" << ctx->getTyperefContext()->getOriginalType() << "> (";
 					toClose++;
+
+					break;
 				}
 
 				if(castPrimitives)
@@ -671,7 +1280,13 @@ public:
 
 			case TypeEntity::Type::Callable:
 			{
-				// TODO: Something with function pointers?
+				auto ctx = getClangContext(entity);
+				assert(ctx);
+
+				file << "AG_fromCallable <" << ctx->getTyperefContext()->getOriginalType() << "> (";
+				toClose++;
+
+				break;
 			}
 		}
 
@@ -679,28 +1294,415 @@ public:
 	}
 
 private:
+	bool isPooled(ClassEntity& entity)
+	{
+		// Concrete types are allocated like the class that they implement.
+		if(entity.isConcreteType())
+		{
+			return isPooled(static_cast <ClassEntity&> (entity.getParent()));
+		}
+
+		return poolAllocations || entity.isPooled();
+	}
+
 	std::ofstream& file;
+	bool poolAllocations;
 
 	bool inOverride = false;
+	bool inStorage = false;
 	bool inIntercept = false;
 	bool onlyParameterNames = false;
 	bool castPrimitives = false;
 	bool duplicateString = false;
+
+	/// Interception functions past this index are always intercepted.
+	static constexpr size_t overrideMaskBits = 64;
+	size_t interceptionIndex = 0;
 };
 
 GlueGenerator::GlueGenerator(Backend& backend)
-	: BindingGenerator(backend), file("glue.cpp")
+	: BindingGenerator(backend), options(backend.getGlueOptions())
 {
+	if(options.shards == 0)
+	{
+		options.shards = 1;
+	}
+
 	IncludeCollector collector(backend);
 	collector.generateBindings(false);
 
+	// The includes and the impersonating classes are shared by every shard.
+	std::ofstream header("glue.hh");
+	header << "#pragma once\n";
+	header << "#include <atomic>\n";
+	header << "#include <cstdint>\n";
+	header << "#include <cstddef>\n";
+	header << "#include <cstring>\n";
+	header << "#include <functional>\n";
+	header << "#include <memory>\n";
+	header << "#include <new>\n";
+	header << "#include <string>\n";
+	header << "#include <string_view>\n";
+	header << "#include <type_traits>\n";
+	header << "#include <vector>\n";
+	header << "#if __has_include(<span>)\n";
+	header << "#include <span>\n";
+	header << "#endif\n";
+	generateViewTypes(header);
+
+	// Strings returned to foreign code are views that stay valid until the foreign code
+	// has copied them. A string returned by value is kept in a per-thread buffer
+	// until the next string is returned.
+	header << "inline AG_String AG_makeString(const char* value) { return { value, value ? strlen(value) : 0 }; }\n";
+	header << "inline AG_String AG_makeString(std::string_view value) { return { value.data(), value.size() }; }\n";
+	header << "inline AG_String AG_makeString(const std::string& value) { return { value.data(), value.size() }; }\n";
+	header << "inline AG_String AG_makeString(std::string&& value)\n{\n";
+	header << "thread_local std::string returned;\n";
+	header << "returned = std::move(value);\n";
+	header << "return { returned.data(), returned.size() };\n}\n";
+
+	// Strings received from foreign code are borrowed for the duration of the call.
+	header << "template <typename T>\n";
+	header << "std::decay_t <T> AG_fromString(AG_String value)\n{\n";
+	header << "if constexpr(std::is_pointer_v <std::decay_t <T>>) { return const_cast <std::decay_t <T>> (value.data); }\n";
+	header << "else { return std::decay_t <T> (value.data, value.size); }\n}\n";
+
+	// Strings returned by interception functions only live until the foreign code returns
+	// another string, so they are copied into storage owned by the intercepting object.
+	// References and views returned to the caller then stay valid until the next call.
+	header << "template <typename T>\n";
+	header << "T AG_storeString(std::string& storage, AG_String value)\n{\n";
+	header << "if constexpr(std::is_same_v <T, std::string>) { return std::string(value.data, value.size); }\n";
+	header << "else if constexpr(std::is_pointer_v <T>)\n{\n";
+	header << "if(!value.data) { return nullptr; }\n";
+	header << "storage.assign(value.data, value.size);\n";
+	header << "return storage.data();\n}\n";
+	header << "else\n{\n";
+	header << "storage.assign(value.data, value.size);\n";
+	header << "return storage;\n}\n}\n";
+
+	// Buffers work the same way as strings. Vectors received from foreign code
+	// have to be copied, but spans refer to the foreign memory directly.
+	header << "#ifdef __cpp_lib_span\n";
+	header << "template <typename T, size_t Extent>\n";
+	header << "AG_Buffer AG_makeBuffer(std::span <T, Extent> value) { return { const_cast <std::remove_cv_t <T>*> (value.data()), value.size() }; }\n";
+	header << "#endif\n";
+	header << "template <typename T>\n";
+	header << "AG_Buffer AG_makeBuffer(const std::vector <T>& value) { return { const_cast <T*> (value.data()), value.size() }; }\n";
+	header << "template <typename T>\n";
+	header << "AG_Buffer AG_makeBuffer(std::vector <T>&& value)\n{\n";
+	header << "thread_local std::vector <T> returned;\n";
+	header << "returned = std::move(value);\n";
+	header << "return { returned.data(), returned.size() };\n}\n";
+
+	header << "template <typename T>\n";
+	header << "std::decay_t <T> AG_fromBuffer(AG_Buffer value)\n{\n";
+	header << "auto data = static_cast <typename std::decay_t <T>::pointer> (value.data);\n";
+	header << "return std::decay_t <T> (data, data + value.size);\n}\n";
+
+	// Buffers returned by interception functions are stored like strings. Only a vector
+	// returned by value owns its elements already.
+	header << "template <typename T>\n";
+	header << "using AG_BufferStorage = std::vector <std::remove_cv_t <typename std::decay_t <T>::value_type>>;\n";
+	header << "template <typename T>\n";
+	header << "T AG_storeBuffer(AG_BufferStorage <T>& storage, AG_Buffer value)\n{\n";
+	header << "auto data = static_cast <const typename AG_BufferStorage <T>::value_type*> (value.data);\n";
+	header << "if constexpr(std::is_same_v <T, AG_BufferStorage <T>>) { return T(data, data + value.size); }\n";
+	header << "else\n{\n";
+	header << "storage.assign(data, data + value.size);\n";
+	header << "if constexpr(std::is_reference_v <T>) { return storage; }\n";
+	header << "else { return T(storage.data(), storage.size()); }\n}\n}\n";
+
+	// Value types and their mirror structs are copied byte by byte.
+	header << "template <typename To, typename From>\n";
+	header << "std::remove_cv_t <To> AG_copyValue(const From& value)\n{\n";
+	header << "static_assert(sizeof(To) == sizeof(From) && std::is_trivially_copyable_v <From>);\n";
+	header << "alignas(To) unsigned char storage[sizeof(To)];\n";
+	header << "memcpy(storage, &value, sizeof(To));\n";
+	header << "return *std::launder(reinterpret_cast <std::remove_cv_t <To>*> (storage));\n}\n";
+
+	// Foreign callables are wrapped once when they are received, and each call goes straight
+	// to the foreign trampoline. The foreign object is released with the last copy of the wrapper.
+	header << "struct AG_ForeignCallable\n{\n";
+	header << "explicit AG_ForeignCallable(AG_Callable callable) : callable(callable) {}\n";
+	header << "~AG_ForeignCallable() { if(callable.release) { callable.release(callable.context); } }\n";
+	header << "AG_Callable callable;\n};\n";
+
+	header << "template <typename T> struct AG_CallableTraits;\n";
+	header << "template <typename R, typename... Args>\n";
+	header << "struct AG_CallableTraits <std::function <R(Args...)>>\n{\n";
+	header << "static std::function <R(Args...)> fromForeign(AG_Callable value)\n{\n";
+	header << "if(!value.invoke) { return nullptr; }\n";
+	header << "auto invoke = reinterpret_cast <R(*)(void*, Args...)> (value.invoke);\n";
+	header << "auto foreign = std::make_shared <AG_ForeignCallable> (value);\n";
+	header << "return [invoke, foreign](Args... args) -> R { return invoke(foreign->callable.context, args...); };\n}\n};\n";
+
+	header << "template <typename T>\n";
+	header << "std::decay_t <T> AG_fromCallable(AG_Callable value)\n{\n";
+	header << "return AG_CallableTraits <std::decay_t <T>>::fromForeign(value);\n}\n";
+
+	// Callables returned to foreign code are called through a static trampoline
+	// whose context is a copy of the callable, or the function pointer itself.
+	header << "template <typename R, typename... Args>\n";
+	header << "R AG_invokeCallable(void* context, Args... args) { return (*static_cast <std::function <R(Args...)>*> (context))(args...); }\n";
+	header << "template <typename R, typename... Args>\n";
+	header << "void AG_releaseCallable(void* context) { delete static_cast <std::function <R(Args...)>*> (context); }\n";
+	header << "template <typename R, typename... Args>\n";
+	header << "R AG_invokeFunction(void* context, Args... args) { return reinterpret_cast <R(*)(Args...)> (context)(args...); }\n";
+
+	header << "template <typename R, typename... Args>\n";
+	header << "AG_Callable AG_makeCallable(std::function <R(Args...)> value)\n{\n";
+	header << "if(!value) { return { nullptr, nullptr, nullptr }; }\n";
+	header << "return { reinterpret_cast <void*> (&AG_invokeCallable <R, Args...>), " <<
+				"new std::function <R(Args...)> (std::move(value)), &AG_releaseCallable <R, Args...> };\n}\n";
+	header << "template <typename R, typename... Args>\n";
+	header << "AG_Callable AG_makeCallable(R(*value)(Args...))\n{\n";
+	header << "if(!value) { return { nullptr, nullptr, nullptr }; }\n";
+	header << "return { reinterpret_cast <void*> (&AG_invokeFunction <R, Args...>), reinterpret_cast <void*> (value), nullptr };\n}\n";
+
+	// The pool is needed when every class is pooled or when some classes are annotated for it.
+	bool pooledAllocations = options.poolAllocations || collector.pooledClasses;
+	if(pooledAllocations)
+	{
+		generateAllocationPool(header);
+	}
+
+	if(collector.asyncFunctions)
+	{
+		generateWorkerPool(header, options.asyncWorkers);
+	}
+
+	if(collector.throwingFunctions)
+	{
+		generateErrorHandling(header);
+	}
+
+	if(options.callCounters)
+	{
+		generateCallCounters(header, options.latencySampling);
+	}
+
+	// When the bridge functions are only reachable through the bridge table,
+	// they don't need to be in the dynamic symbol table.
+	if(options.hideBridges)
+	{
+		header << "#if defined(__GNUC__)\n";
+		header << "#define AG_BRIDGE extern \"C\" __attribute__((visibility(\"hidden\")))\n";
+		header << "#else\n";
+		header << "#define AG_BRIDGE extern \"C\"\n";
+		header << "#endif\n";
+	}
+
+	else
+	{
+		header << "#define AG_BRIDGE extern \"C\"\n";
+	}
+
 	for(auto& include : collector.includes)
 	{
-		file << include << '\n';
+		header << "#include <" << include << ">\n";
+	}
+
+	// Make sure that the mirror structs match the layout of the original classes.
+	valueTypes = std::move(collector.valueTypes);
+	generateValueTypes(header, valueTypes);
+
+	for(auto& value : valueTypes)
+	{
+		auto ctx = getClangContext(*value);
+		if(!ctx)
+		{
+			continue;
+		}
+
+		auto name = getValueName(*value);
+		auto realName = ctx->getTypeContext()->getRealName();
+
+		header << "static_assert(sizeof(" << name << ") == sizeof(" << realName << ") && alignof(" <<
+				name << ") == alignof(" << realName << "));\n";
+
+		for(size_t i = 0; i < value->getValueFieldCount(); i++)
+		{
+			auto& field = value->getValueField(i);
+			header << "static_assert(offsetof(" << name << ", " << field.name << ") == offsetof(" <<
+					realName << ", " << field.name << "));\n";
+		}
 	}
 
-	ClassGenerator classGen(backend, file);
+	ClassGenerator classGen(backend, header);
 	classGen.generateBindings(false);
+
+	// Truncate the shards. Bridge functions are appended to them later.
+	for(size_t i = 0; i < options.shards; i++)
+	{
+		std::ofstream shard(getShardPath(i));
+		shard << "#include \"glue.hh\"\n";
+
+		if(i == 0 && pooledAllocations)
+		{
+			// The counts of exited threads are kept as retired counts. The registry is never
+			// destroyed since threads might still exit while the library is being unloaded.
+			shard << "struct AG_AllocationRegistry\n{\n";
+			shard << "std::mutex mutex;\n";
+			shard << "std::vector <AG_FreeLists*> threads;\n";
+			shard << "uint64_t retired[4] = {};\n};\n";
+			shard << "static AG_AllocationRegistry& AG_getAllocationRegistry()\n{\n";
+			shard << "static auto* registry = new AG_AllocationRegistry;\n";
+			shard << "return *registry;\n}\n";
+
+			shard << "void AG_attachFreeLists(AG_FreeLists* lists)\n{\n";
+			shard << "auto& registry = AG_getAllocationRegistry();\n";
+			shard << "std::lock_guard <std::mutex> lock(registry.mutex);\n";
+			shard << "registry.threads.push_back(lists);\n}\n";
+
+			shard << "void AG_detachFreeLists(AG_FreeLists* lists)\n{\n";
+			shard << "auto& registry = AG_getAllocationRegistry();\n";
+			shard << "std::lock_guard <std::mutex> lock(registry.mutex);\n";
+			shard << "for(size_t i = 0; i < 4; i++) { registry.retired[i] += lists->counters[i].load(std::memory_order_relaxed); }\n";
+			shard << "registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), lists));\n}\n";
+
+			generateExport(shard);
+			shard << "void AG_getAllocationStats(AG_AllocationStats* stats)\n{\n";
+			shard << "auto& registry = AG_getAllocationRegistry();\n";
+			shard << "uint64_t totals[4];\n";
+			shard << "{\nstd::lock_guard <std::mutex> lock(registry.mutex);\n";
+			shard << "for(size_t i = 0; i < 4; i++)\n{\n";
+			shard << "totals[i] = registry.retired[i] + AG_lateAllocationCounters[i].load(std::memory_order_relaxed);\n";
+			shard << "for(auto* lists : registry.threads) { totals[i] += lists->counters[i].load(std::memory_order_relaxed); }\n}\n}\n";
+			shard << "stats->allocations = totals[0];\n";
+			shard << "stats->deallocations = totals[1];\n";
+			shard << "stats->reused = totals[2];\n";
+			shard << "stats->heapAllocations = totals[3];\n}\n";
+		}
+	}
+
+	generateCMakeFragment(collector.includes);
+}
+
+std::string GlueGenerator::getShardPath(size_t index)
+{
+	if(options.shards == 1)
+	{
+		return "glue.cpp";
+	}
+
+	return "glue_" + std::to_string(index) + ".cpp";
+}
+
+void GlueGenerator::openShard(size_t index)
+{
+	if(file.is_open())
+	{
+		file.close();
+	}
+
+	file.open(getShardPath(index), std::ios::app);
+}
+
+void GlueGenerator::generateCMakeFragment(const std::set <std::string>& includes)
+{
+	std::ofstream fragment("glue.cmake");
+
+	fragment << "# Generated by Autoglue. Use autoglue_add_glue from the Autoglue package\n";
+	fragment << "# to create a target out of the glue sources listed here.\n";
+	fragment << "set(AUTOGLUE_GLUE_DIRECTORY \"${CMAKE_CURRENT_LIST_DIR}\")\n\n";
+
+	fragment << "set(AUTOGLUE_GLUE_SOURCES\n";
+	for(size_t i = 0; i < options.shards; i++)
+	{
+		fragment << "\t\"${CMAKE_CURRENT_LIST_DIR}/" << getShardPath(i) << "\"\n";
+	}
+	fragment << "\t\"${CMAKE_CURRENT_LIST_DIR}/glue_table.cpp\"\n";
+	fragment << ")\n\n";
+
+	// The headers collected from the hierarchy rarely change, which makes
+	// them good candidates for a precompiled header.
+	fragment << "set(AUTOGLUE_GLUE_PRECOMPILE_HEADERS\n";
+	for(auto& include : includes)
+	{
+		fragment << "\t\"<" << include << ">\"\n";
+	}
+	fragment << ")\n";
+}
+
+void GlueGenerator::generateBridgeTable()
+{
+	auto& table = getBackend().getBridgeTable();
+
+	std::ofstream header("glue_table.hh");
+	header << "#pragma once\n";
+	header << "#include <cstdint>\n";
+	header << "#include <cstddef>\n";
+	generateViewTypes(header);
+	generateValueTypes(header, valueTypes);
+	header << '\n';
+
+	header << "#define AG_BRIDGE_TABLE_VERSION " << table.getVersion() << "u\n\n";
+
+	// The layout of this struct is what foreign code reads when it bootstraps
+	// from AG_getBridgeTable, so the header fields are kept pointer aligned.
+	header << "struct AG_BridgeTable\n{\n";
+	header << "uint32_t version;\n";
+	header << "uint32_t count;\n";
+
+	for(auto& bridge : bridges)
+	{
+		header << bridge.returnType << "(*" << bridge.name << ")(" << bridge.parameters << ");\n";
+	}
+
+	header << "};\n\n";
+	header << "extern \"C\" const AG_BridgeTable* AG_getBridgeTable();\n";
+
+	std::ofstream source("glue_table.cpp");
+	source << "#include \"glue_table.hh\"\n\n";
+
+	for(auto& bridge : bridges)
+	{
+		source << "extern \"C\" " << bridge.returnType << bridge.name << '(' << bridge.parameters << ");\n";
+	}
+
+	source << "\nstatic const AG_BridgeTable table\n{\n";
+	source << "AG_BRIDGE_TABLE_VERSION,\n";
+	source << bridges.size() << ",\n";
+
+	for(auto& bridge : bridges)
+	{
+		source << bridge.name << ",\n";
+	}
+
+	source << "};\n\n";
+
+	// AG_getBridgeTable is the only function that has to be exported.
+	source << "#if defined(_WIN32)\n";
+	source << "extern \"C\" __declspec(dllexport)\n";
+	source << "#else\n";
+	source << "extern \"C\" __attribute__((visibility(\"default\")))\n";
+	source << "#endif\n";
+	source << "const AG_BridgeTable* AG_getBridgeTable()\n{\nreturn &table;\n}\n";
+}
+
+std::ostream& GlueGenerator::getOutput()
+{
+	if(inSignature)
+	{
+		return signature;
+	}
+
+	return file;
+}
+
+std::string GlueGenerator::takeSignature()
+{
+	std::string result = signature.str();
+	signature.str("");
+
+	return result;
+}
+
+void GlueGenerator::addBridge(const std::string& name, const std::string& returnType, const std::string& parameters)
+{
+	getBackend().getBridgeTable().add(name, returnType + '(' + parameters + ')');
+	bridges.push_back({ name, returnType, parameters });
 }
 
 void GlueGenerator::generateFunction(FunctionEntity& entity)
@@ -716,17 +1718,380 @@ void GlueGenerator::generateFunction(FunctionEntity& entity)
 		return;
 	}
 
-	file << "extern \"C\"\n";
+	// Capture the signature so that it can also be used in the bridge table.
+	inSignature = true;
 	entity.generateReturnType(*this, true);
-	file << entity.getBridgeName() << "(";
-
+	std::string returnType = takeSignature();
 	entity.generateParameters(*this, true, true);
-	file << ")\n{\n";
+	generateErrorParameter(entity, entity.getParameterCount(true) > 0);
+	std::string parameters = takeSignature();
+	inSignature = false;
 
+	file << "AG_BRIDGE\n" << returnType << entity.getBridgeName() << '(' << parameters << ")\n{\n";
+	addBridge(entity.getBridgeName(), returnType, parameters);
+	generateCallCounter(entity.getBridgeName());
+
+	beginErrorHandling(entity);
 	entity.generateReturnStatement(*this, true);
 	entity.generateBridgeCall(*this);
 
-	file << ";\n}\n\n";
+	file << ";\n";
+	endErrorHandling(entity, entity.returnsValue());
+	file << "}\n\n";
+
+	if(entity.isBatched())
+	{
+		generateBatchedBridge(entity);
+	}
+
+	if(entity.hasStorageBridge())
+	{
+		generateStorageBridge(entity);
+	}
+
+	if(entity.isAsync())
+	{
+		generateAsyncBridge(entity);
+	}
+
+	if(entity.hasUnpackedBridge())
+	{
+		generateUnpackedBridge(entity);
+	}
+}
+
+void GlueGenerator::generateStorageBridge(FunctionEntity& entity)
+{
+	bool destructor = entity.getType() == FunctionEntity::Type::Destructor;
+
+	inSignature = true;
+	entity.generateReturnType(*this, true);
+	std::string returnType = takeSignature();
+
+	// Destructors destroy the object in place, whereas other functions
+	// construct the returned object into the given storage.
+	if(!destructor)
+	{
+		signature << "void* AG_storage" << (entity.getParameterCount(true) > 0 ? ", " : "");
+	}
+
+	entity.generateParameters(*this, true, true);
+	generateErrorParameter(entity, !destructor || entity.getParameterCount(true) > 0);
+	std::string parameters = takeSignature();
+	inSignature = false;
+
+	file << "AG_BRIDGE\n" << returnType << entity.getStorageBridgeName() << '(' << parameters << ")\n{\n";
+	addBridge(entity.getStorageBridgeName(), returnType, parameters);
+	generateCallCounter(entity.getStorageBridgeName());
+
+	beginErrorHandling(entity);
+	file << (destructor ? "" : "return ") << "AG_" << entity.getParent().getHierarchy("::AG_") << "::" <<
+			entity.getStorageBridgeName(true) << '(';
+
+	if(!destructor)
+	{
+		file << "AG_storage" << (entity.getParameterCount(true) > 0 ? ", " : "");
+	}
+
+	onlyParameterNames = true;
+	entity.generateParameters(*this, true, true);
+	onlyParameterNames = false;
+
+	file << ");\n";
+	endErrorHandling(entity, !destructor);
+	file << "}\n\n";
+}
+
+void GlueGenerator::generateStorageLayout(ClassEntity& entity)
+{
+	auto ctx = getClangContext(entity);
+	assert(ctx);
+	auto& type = ctx->getTypeContext()->getRealName();
+
+	// The foreign code allocates storage based on the layout that the backend saw.
+	file << "static_assert(sizeof(" << type << ") == " << entity.getStorageSize() << " && alignof(" << type <<
+			") == " << entity.getStorageAlignment() << ", \"The layout of " << type << " has changed\");\n\n";
+
+	for(const char* query : { "sizeof", "alignof" })
+	{
+		std::string name = entity.getHierarchy() + "_AG_" + query;
+
+		file << "AG_BRIDGE\nsize_t " << name << "()\n{\nreturn " << query << '(' << type << ");\n}\n\n";
+		addBridge(name, "size_t ", "");
+	}
+}
+
+void GlueGenerator::generateBatchedBridge(FunctionEntity& entity)
+{
+	inSignature = true;
+	signature << "void** AG_objects, size_t AG_count, uint64_t AG_broadcast";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto param = entity.getParameter(i).getAsPOD();
+		signature << ", const ";
+		generateTypePOD(signature, param);
+		signature << "* " << param.getName();
+	}
+
+	auto returned = entity.getReturnType(true);
+	bool hasResults = !returned.isPrimitive() || returned.getPrimitiveType().getType() != PrimitiveEntity::Type::Void;
+
+	if(hasResults)
+	{
+		signature << ", ";
+		generateTypePOD(signature, returned);
+		signature << "* AG_results";
+	}
+
+	generateErrorParameter(entity, true);
+	std::string parameters = takeSignature();
+	inSignature = false;
+
+	file << "AG_BRIDGE\nvoid " << entity.getBatchBridgeName() << '(' << parameters << ")\n{\n";
+	addBridge(entity.getBatchBridgeName(), "void ", parameters);
+	generateCallCounter(entity.getBatchBridgeName());
+
+	// Broadcast parameters always use their first element.
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		file << "const size_t AG_step_" << entity.getParameter(i).getName() <<
+				" = (AG_broadcast >> " << i << ") & 1 ? 0 : 1;\n";
+	}
+
+	// The batch stops at the first exception.
+	beginErrorHandling(entity);
+	file << "for(size_t AG_i = 0; AG_i < AG_count; AG_i++)\n{\n";
+
+	if(hasResults)
+	{
+		file << "AG_results[AG_i] = ";
+	}
+
+	file << "AG_" << entity.getParent().getHierarchy("::AG_") << "::" <<
+			entity.getBridgeName(true) << "(AG_objects[AG_i]";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& name = entity.getParameter(i).getName();
+		file << ", " << name << "[AG_i * AG_step_" << name << ']';
+	}
+
+	file << ");\n}\n";
+	endErrorHandling(entity, false);
+	file << "}\n\n";
+}
+
+void GlueGenerator::generateCallCounter(const std::string& bridgeName)
+{
+	if(options.callCounters)
+	{
+		file << "AG_BridgeCall AG_call(" << countedBridges.size() << ");\n";
+		countedBridges.push_back(bridgeName);
+	}
+}
+
+void GlueGenerator::generateBridgeStats()
+{
+	openShard(0);
+
+	file << "constexpr size_t AG_bridgeCount = " << countedBridges.size() << ";\n";
+	file << "static const char* const AG_bridgeNames[AG_bridgeCount + 1] =\n{\n";
+
+	for(auto& name : countedBridges)
+	{
+		file << '"' << name << "\",\n";
+	}
+
+	file << "nullptr\n};\n\n";
+
+	// The counts of exited threads are kept as retired counts, and a reset only moves the
+	// baseline that is subtracted from the totals. The registry is never destroyed
+	// since threads might still exit while the library is being unloaded.
+	file << "struct AG_BridgeRegistry\n{\n";
+	file << "AG_BridgeRegistry() { threads.push_back(late); }\n";
+	file << "std::mutex mutex;\n";
+	file << "std::vector <AG_BridgeCounters*> threads;\n";
+	file << "std::vector <AG_BridgeStats> retired = std::vector <AG_BridgeStats> (AG_bridgeCount);\n";
+	file << "std::vector <AG_BridgeStats> baseline = std::vector <AG_BridgeStats> (AG_bridgeCount);\n";
+
+	// Calls made by destructors of thread locals after the counters of the thread
+	// are gone go to counters shared by such threads.
+	file << "AG_BridgeCounters* late = new AG_BridgeCounters[AG_bridgeCount]();\n};\n";
+	file << "static AG_BridgeRegistry& AG_getBridgeRegistry()\n{\n";
+	file << "static auto* registry = new AG_BridgeRegistry;\n";
+	file << "return *registry;\n}\n";
+
+	file << "static void AG_addBridgeStats(AG_BridgeStats* stats, const AG_BridgeCounters* counters)\n{\n";
+	file << "for(size_t i = 0; i < AG_bridgeCount; i++)\n{\n";
+	file << "stats[i].calls += counters[i].calls.load(std::memory_order_relaxed);\n";
+
+	if(options.latencySampling > 0)
+	{
+		file << "for(size_t j = 0; j < AG_latencyBuckets; j++)\n{\n";
+		file << "stats[i].latencies[j] += counters[i].latencies[j].load(std::memory_order_relaxed);\n}\n";
+	}
+
+	file << "}\n}\n";
+
+	file << "static void AG_sumBridgeStats(AG_BridgeRegistry& registry, AG_BridgeStats* stats)\n{\n";
+	file << "std::copy(registry.retired.begin(), registry.retired.end(), stats);\n";
+	file << "for(auto* counters : registry.threads) { AG_addBridgeStats(stats, counters); }\n}\n";
+
+	file << "struct AG_BridgeCountersOwner\n{\n";
+	file << "~AG_BridgeCountersOwner()\n{\n";
+	file << "auto& registry = AG_getBridgeRegistry();\n";
+	file << "std::lock_guard <std::mutex> lock(registry.mutex);\n";
+	file << "AG_addBridgeStats(registry.retired.data(), counters);\n";
+	file << "registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), counters));\n";
+	file << "AG_threadCounters = registry.late;\n";
+	file << "delete[] counters;\n}\n";
+	file << "AG_BridgeCounters* counters;\n};\n";
+
+	file << "AG_BridgeCounters* AG_attachBridgeCounters()\n{\n";
+	file << "auto& registry = AG_getBridgeRegistry();\n";
+	file << "auto* counters = new AG_BridgeCounters[AG_bridgeCount]();\n";
+	file << "{\nstd::lock_guard <std::mutex> lock(registry.mutex);\n";
+	file << "registry.threads.push_back(counters);\n}\n";
+	file << "thread_local AG_BridgeCountersOwner owner{counters};\n";
+	file << "AG_threadCounters = counters;\n";
+	file << "return counters;\n}\n\n";
+
+	generateExport(file);
+	file << "size_t AG_getBridgeCount()\n{\nreturn AG_bridgeCount;\n}\n\n";
+
+	generateExport(file);
+	file << "const char* AG_getBridgeName(size_t index)\n{\n";
+	file << "return index < AG_bridgeCount ? AG_bridgeNames[index] : nullptr;\n}\n\n";
+
+	// The caller provides an entry for each counted bridge function.
+	generateExport(file);
+	file << "void AG_getBridgeStats(AG_BridgeStats* stats)\n{\n";
+	file << "auto& registry = AG_getBridgeRegistry();\n";
+	file << "std::lock_guard <std::mutex> lock(registry.mutex);\n";
+	file << "AG_sumBridgeStats(registry, stats);\n";
+	file << "for(size_t i = 0; i < AG_bridgeCount; i++)\n{\n";
+	file << "stats[i].calls -= registry.baseline[i].calls;\n";
+	file << "for(size_t j = 0; j < AG_latencyBuckets; j++) { stats[i].latencies[j] -= registry.baseline[i].latencies[j]; }\n}\n}\n\n";
+
+	generateExport(file);
+	file << "void AG_resetBridgeStats()\n{\n";
+	file << "auto& registry = AG_getBridgeRegistry();\n";
+	file << "std::lock_guard <std::mutex> lock(registry.mutex);\n";
+	file << "AG_sumBridgeStats(registry, registry.baseline.data());\n}\n";
+
+	file.close();
+}
+
+void GlueGenerator::generateErrorParameter(FunctionEntity& entity, bool separate)
+{
+	if(entity.isThrowing())
+	{
+		signature << (separate ? ", " : "") << "AG_Error* AG_error";
+	}
+}
+
+void GlueGenerator::beginErrorHandling(FunctionEntity& entity)
+{
+	if(entity.isThrowing())
+	{
+		file << "try\n{\n";
+	}
+}
+
+void GlueGenerator::endErrorHandling(FunctionEntity& entity, bool returnsValue)
+{
+	if(entity.isThrowing())
+	{
+		// The caller ignores the return value when an exception was reported.
+		file << "}\ncatch(...)\n{\nAG_catch(AG_error);\n}\n";
+		file << (returnsValue ? "return {};\n" : "");
+	}
+}
+
+void GlueGenerator::generateAsyncBridge(FunctionEntity& entity)
+{
+	inSignature = true;
+	entity.generateParameters(*this, true, true);
+	signature << (entity.getParameterCount(true) > 0 ? ", " : "") << "void (*AG_complete)(void*, const char*";
+
+	// Functions returning nothing only report whether they succeeded.
+	if(entity.returnsValue())
+	{
+		auto returned = entity.getReturnType(true);
+		signature << ", ";
+		generateTypePOD(signature, returned);
+	}
+
+	signature << "), void* AG_context";
+	std::string parameters = takeSignature();
+	inSignature = false;
+
+	file << "AG_BRIDGE\nvoid " << entity.getAsyncBridgeName() << '(' << parameters << ")\n{\n";
+	addBridge(entity.getAsyncBridgeName(), "void ", parameters);
+	generateCallCounter(entity.getAsyncBridgeName());
+
+	// The arguments are copied for the worker. Strings are only borrowed for the
+	// duration of the foreign call, so the worker gets copies of their contents.
+	file << "AG_runAsync([=";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		if(param.getType() == TypeEntity::Type::Primitive &&
+			param.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
+		{
+			file << ", AG_copy_" << param.getName() << " = std::string(" << param.getName() << ".data ? " <<
+					param.getName() << ".data : \"\", " << param.getName() << ".size)";
+		}
+	}
+
+	file << "] { return AG_" << entity.getParent().getHierarchy("::AG_") << "::" <<
+			entity.getBridgeName(true) << '(';
+
+	onlyParameterNames = true;
+	copyStrings = true;
+	entity.generateParameters(*this, true, true);
+	copyStrings = false;
+	onlyParameterNames = false;
+
+	file << "); }, AG_complete, AG_context);\n}\n\n";
+}
+
+void GlueGenerator::generateUnpackedBridge(FunctionEntity& entity)
+{
+	inSignature = true;
+	entity.generateReturnType(*this, true);
+	std::string returnType = takeSignature();
+	unpackBuffers = true;
+	entity.generateParameters(*this, true, true);
+	generateErrorParameter(entity, entity.getParameterCount(true) > 0);
+	std::string parameters = takeSignature();
+	inSignature = false;
+
+	file << "AG_BRIDGE\n" << returnType << entity.getUnpackedBridgeName() << '(' << parameters << ")\n{\n";
+	addBridge(entity.getUnpackedBridgeName(), returnType, parameters);
+
+	// The usual bridge function counts the call and reports exceptions.
+	file << "return " << entity.getBridgeName() << '(';
+
+	onlyParameterNames = true;
+	entity.generateParameters(*this, true, true);
+	onlyParameterNames = false;
+	unpackBuffers = false;
+
+	file << (entity.isThrowing() ? ", AG_error" : "") << ");\n}\n\n";
+}
+
+void GlueGenerator::generateField(FieldEntity& entity)
+{
+	// Fields get bridge functions for their getters and setters.
+	generateFunction(entity.getGetter());
+
+	if(!entity.isReadOnly())
+	{
+		generateFunction(entity.getSetter());
+	}
 }
 
 void GlueGenerator::generateNamedScope(ScopeEntity& entity)
@@ -736,8 +2101,26 @@ void GlueGenerator::generateNamedScope(ScopeEntity& entity)
 
 void GlueGenerator::generateClass(ClassEntity& entity)
 {
+	// Value types have no bridge functions.
+	if(entity.isValueType())
+	{
+		return;
+	}
+
+	// Each top level class and its nested entities go to a single shard.
+	if(getClassDepth() == 1)
+	{
+		openShard(nextShard % options.shards);
+		nextShard++;
+	}
+
 	file << "// ---------- Class " << entity.getHierarchy("::") << " : " << " ----------\n\n";
 
+	if(entity.isStorable())
+	{
+		generateStorageLayout(entity);
+	}
+
 	entity.generateInterceptionContext(*this);
 	entity.generateNested(*this);
 	entity.generateConcreteType(*this);
@@ -745,21 +2128,46 @@ void GlueGenerator::generateClass(ClassEntity& entity)
 
 void GlueGenerator::generateTypeReference(TypeReferenceEntity& entity)
 {
-	if(onlyParameterNames)
+	// Unpacked buffers are passed as a pointer and a size that make up the buffer again.
+	if(unpackBuffers && entity.getType() == TypeEntity::Type::Primitive &&
+		entity.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
+	{
+		if(onlyParameterNames)
+		{
+			file << "AG_Buffer { " << entity.getName() << ", " << entity.getName() << "_size }";
+		}
+
+		else
+		{
+			getOutput() << "void* " << entity.getName() << ", size_t " << entity.getName() << "_size";
+		}
+
+		return;
+	}
+
+	// Copied strings keep a null pointer null.
+	if(copyStrings && entity.getType() == TypeEntity::Type::Primitive &&
+		entity.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
+	{
+		file << "AG_String { " << entity.getName() << ".data ? AG_copy_" << entity.getName() << ".c_str() : nullptr, AG_copy_" <<
+				entity.getName() << ".size() }";
+	}
+
+	else if(onlyParameterNames)
 	{
 		file << entity.getName();
 	}
 
 	else
 	{
-		generateTypePOD(file, entity);
-		file << ' ' << entity.getName();
+		generateTypePOD(getOutput(), entity);
+		getOutput() << ' ' << entity.getName();
 	}
 }
 
 void GlueGenerator::generateArgumentSeparator()
 {
-	file << ", ";
+	getOutput() << ", ";
 }
 
 std::string_view GlueGenerator::getObjectHandleName()
@@ -794,11 +2202,11 @@ void GlueGenerator::generateBridgeCall(FunctionEntity& target)
 			else
 			{
 				auto ctx = getClangContext(target);
-				assert(ctx);
+				assert(ctx || target.getAccessedField());
 
 				// If the function is a private override of an interface, it cannot be called
 				// without a virtual function call. Call the virtual function for interface instead.
-				if(ctx->getOverloadContext()->isPrivateOverride())
+				if(ctx && ctx->getOverloadContext()->isPrivateOverride())
 				{
 					auto& containing = ctx->getOverloadContext()->getOverriddenInterface()->getParent();
 					file << "AG_" << containing.getHierarchy("::AG_") << "::AG_virtual_" <<
@@ -846,24 +2254,32 @@ void GlueGenerator::generateInterceptionFunction(FunctionEntity& target, ClassEn
 	// initialization function.
 	else
 	{
-		file << ", ";
+		getOutput() << ", ";
 
 		target.generateReturnType(*this, true);
-		file << "(*AG_intercept_" << target.getBridgeName(true) << ")(";
+		getOutput() << "(*AG_intercept_" << target.getBridgeName(true) << ")(";
 		target.generateParameters(*this, true, true);
-		file << ')';
+		getOutput() << ')';
 	}
 }
 
 void GlueGenerator::generateInterceptionContext(ClassEntity& entity)
 {
-	file << "extern \"C\"\n";
-	file << "void " << entity.getHierarchy() << "_AG_initializeInterceptionContext(void* objectHandle, void* AG_foreignObject";
+	std::string name(entity.getHierarchy() + "_AG_initializeInterceptionContext");
+
+	inSignature = true;
+	signature << "void* objectHandle, void* AG_foreignObject, uint64_t AG_overrides";
 	entity.generateInterceptionFunctions(*this);
+	std::string parameters = takeSignature();
+	inSignature = false;
+
+	file << "AG_BRIDGE\n";
+	file << "void " << name << '(' << parameters << ")\n{\n";
+	addBridge(name, "void ", parameters);
 
-	file << ")\n{\n";
 	file << "auto* obj = static_cast <AG_" << entity.getHierarchy("::AG_") << "*> (objectHandle);\n";
-	file << "obj->AG_foreignObject = AG_foreignObject;";
+	file << "obj->AG_foreignObject = AG_foreignObject;\n";
+	file << "obj->AG_overrides = AG_overrides;\n";
 
 	onlyParameterNames = true;
 	entity.generateInterceptionFunctions(*this);
@@ -872,4 +2288,12 @@ void GlueGenerator::generateInterceptionContext(ClassEntity& entity)
 	file << "}\n";
 }
 
+void GlueGenerator::finishGeneration()
+{
+	if(options.callCounters)
+	{
+		generateBridgeStats();
+	}
+}
+
 }
@@ -1,6 +1,8 @@
 #ifndef AUTOGLUE_CLANG_BACKEND_HH
 #define AUTOGLUE_CLANG_BACKEND_HH
 
+#include <autoglue/clang/GlueOptions.hh>
+
 #include <autoglue/Backend.hh>
 #include <autoglue/ClassEntity.hh>
 #include <autoglue/ScopeEntity.hh>
@@ -20,6 +22,11 @@ public:
 
 	std::string getInclusion(const std::string& path);
 
+	/// Gets the options that are used when the glue code is generated.
+	///
+	/// \return The options that are used when the glue code is generated.
+	GlueOptions& getGlueOptions();
+
 protected:
 	void generateGlue() override;
 
@@ -28,6 +35,8 @@ private:
 
 	std::unique_ptr <::clang::tooling::JSONCompilationDatabase> database;
 	std::vector <std::string> includePaths;
+
+	GlueOptions glueOptions;
 };
 
 }
@@ -1,9 +1,16 @@
 #ifndef AUTOGLUE_CLANG_GLUE_GENERATOR_HH
 #define AUTOGLUE_CLANG_GLUE_GENERATOR_HH
 
+#include <autoglue/clang/GlueOptions.hh>
+
 #include <autoglue/BindingGenerator.hh>
+#include <autoglue/ClassEntity.hh>
 
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
 
 namespace ag::clang
 {
@@ -15,9 +22,14 @@ class GlueGenerator : public BindingGenerator
 public:
 	GlueGenerator(Backend& backend);
 
+	/// Generates the table of function pointers to every bridge function.
+	/// This should be called once the bindings have been generated.
+	void generateBridgeTable();
+
 private:
 	void generateTypeReference(TypeReferenceEntity& entity) override;
 	void generateFunction(FunctionEntity& entity) override;
+	void generateField(FieldEntity& entity) override;
 	void generateNamedScope(ScopeEntity& entity) override;
 	void generateClass(ClassEntity& entity) override;
 	void generateArgumentSeparator() override;
@@ -26,9 +38,128 @@ private:
 	void generateBridgeCall(FunctionEntity& target) override;
 	void generateInterceptionFunction(FunctionEntity& target, ClassEntity& parentClass) override;
 	void generateInterceptionContext(ClassEntity& entity) override;
+	void finishGeneration() override;
+
+	/// Gets the path of the glue source file containing the given shard.
+	///
+	/// \param index The index of the shard.
+	/// \return The path of the glue source file.
+	std::string getShardPath(size_t index);
+
+	/// Makes the bridge functions be written to the given shard.
+	///
+	/// \param index The index of the shard to write to.
+	void openShard(size_t index);
+
+	/// Generates a bridge function that calls the given batched function for an
+	/// array of objects. Each parameter is an array that has an element for each
+	/// object, unless the corresponding bit in the broadcast mask is set in which
+	/// case the first element is passed to every call.
+	///
+	/// \param entity The batched function to generate a bridge for.
+	void generateBatchedBridge(FunctionEntity& entity);
+
+	/// Generates a bridge function that queues a call of the given asynchronous
+	/// function to the worker pool and returns immediately. Once the call is done,
+	/// the worker passes the result or the message of the thrown exception to the
+	/// given completion function along with the given context.
+	///
+	/// \param entity The asynchronous function to generate a bridge for.
+	void generateAsyncBridge(FunctionEntity& entity);
+
+	/// Generates a bridge function that takes each buffer as a pointer and a size
+	/// and passes them on to the usual bridge function of the given function.
+	///
+	/// \param entity The function to generate an unpacked bridge for.
+	void generateUnpackedBridge(FunctionEntity& entity);
+
+	/// Makes the current bridge function count its calls if call counters are enabled.
+	///
+	/// \param bridgeName The name of the bridge function that the counters are reported for.
+	void generateCallCounter(const std::string& bridgeName);
+
+	/// Generates the counter registry and the functions that report the call counts
+	/// of the bridge functions to shard 0. This should be called once every counted
+	/// bridge function has been generated.
+	void generateBridgeStats();
+
+	/// Adds the error slot parameter to the captured signature if the given function can throw.
+	///
+	/// \param entity The function whose bridge function is generated.
+	/// \param separate If true, the parameter is preceded by a separator.
+	void generateErrorParameter(FunctionEntity& entity, bool separate);
+
+	/// Opens a try block if the given function can throw.
+	///
+	/// \param entity The function whose bridge function is generated.
+	void beginErrorHandling(FunctionEntity& entity);
+
+	/// Closes the try block opened by beginErrorHandling with a handler that
+	/// reports the caught exception through the error slot.
+	///
+	/// \param entity The function whose bridge function is generated.
+	/// \param returnsValue If true, a value initialized result is returned after the handler.
+	void endErrorHandling(FunctionEntity& entity, bool returnsValue);
+
+	/// Generates the bridge function that returns an object to caller provided
+	/// storage, or that destroys an object in place if the function is a destructor.
+	///
+	/// \param entity The function to generate the storage bridge function for.
+	void generateStorageBridge(FunctionEntity& entity);
+
+	/// Generates the bridge functions that return the size and the alignment of a storable class.
+	///
+	/// \param entity The storable class to generate the bridge functions for.
+	void generateStorageLayout(ClassEntity& entity);
+
+	/// Generates a CMake fragment that lists the glue sources and the
+	/// headers that can be precompiled for them.
+	///
+	/// \param includes The headers that the glue code includes.
+	void generateCMakeFragment(const std::set <std::string>& includes);
+
+	/// Gets the stream that types and parameters should be written to.
+	///
+	/// \return The captured signature or the current shard.
+	std::ostream& getOutput();
+
+	/// Takes the signature captured so far.
+	///
+	/// \return The captured signature.
+	std::string takeSignature();
+
+	/// Adds a bridge function to the bridge table.
+	///
+	/// \param name The name of the bridge function.
+	/// \param returnType The return type of the bridge function.
+	/// \param parameters The parameters of the bridge function.
+	void addBridge(const std::string& name, const std::string& returnType, const std::string& parameters);
+
+	struct Bridge
+	{
+		std::string name;
+		std::string returnType;
+		std::string parameters;
+	};
+
+	std::vector <Bridge> bridges;
+
+	/// The bridge functions that count their calls, indexed by their counters.
+	std::vector <std::string> countedBridges;
+
+	/// The value types whose mirror structs are shared by the glue headers.
+	std::vector <std::shared_ptr <ClassEntity>> valueTypes;
+
+	std::ostringstream signature;
+	bool inSignature = false;
+
+	GlueOptions options;
+	size_t nextShard = 0;
 
 	std::ofstream file;
 	bool onlyParameterNames = false;
+	bool unpackBuffers = false;
+	bool copyStrings = false;
 };
 
 }
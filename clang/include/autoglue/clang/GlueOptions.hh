@@ -0,0 +1,44 @@
+#ifndef AUTOGLUE_CLANG_GLUE_OPTIONS_HH
+#define AUTOGLUE_CLANG_GLUE_OPTIONS_HH
+
+#include <cstddef>
+
+namespace ag::clang
+{
+
+/// GlueOptions controls how the glue code is laid out by GlueGenerator.
+struct GlueOptions
+{
+	/// The amount of source files that the bridge functions are split into.
+	/// Every top level class goes to a single shard so that shards can be
+	/// compiled in parallel or grouped into unity builds.
+	size_t shards = 1;
+
+	/// If true, the bridge functions are given hidden visibility and only
+	/// AG_getBridgeTable is exported from the glue code. Foreign bindings
+	/// then have to be generated so that they use the bridge table.
+	bool hideBridges = false;
+
+	/// If true, objects that the glue code creates for foreign code are allocated
+	/// from per-thread free lists instead of the global heap, and their destructor
+	/// bridges return them there. AG_getAllocationStats reports the allocation counts.
+	/// Classes annotated with "autoglue::pool" are pooled even if this is false.
+	bool poolAllocations = false;
+
+	/// The amount of native worker threads that run asynchronous functions. The workers
+	/// are started when the first asynchronous call is made. If zero, there's a worker
+	/// for each hardware thread.
+	size_t asyncWorkers = 0;
+
+	/// If true, every bridge function counts its calls in per-thread counters. The
+	/// glue code exports AG_getBridgeStats and AG_resetBridgeStats that sum them up.
+	bool callCounters = false;
+
+	/// If nonzero, every Nth call of each bridge function on a thread is timed and
+	/// recorded in a latency histogram. Only used when callCounters is set.
+	size_t latencySampling = 0;
+};
+
+}
+
+#endif
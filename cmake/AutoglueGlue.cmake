@@ -0,0 +1,53 @@
+# Creates a library target out of glue code generated by Autoglue.
+#
+# autoglue_add_glue(<target> <glue directory>
+#                   [SHARED | STATIC | OBJECT]
+#                   [UNITY_BATCH_SIZE <size>]
+#                   [NO_PRECOMPILE_HEADERS])
+#
+# The glue directory should contain glue.cmake which is generated alongside
+# the glue sources. Unless NO_PRECOMPILE_HEADERS is given, the headers that
+# the glue includes are precompiled. If UNITY_BATCH_SIZE is given, the glue
+# shards are combined into unity sources of the given size.
+#
+# Link the target against the library that the glue was generated for
+# by using target_link_libraries.
+function(autoglue_add_glue target directory)
+	cmake_parse_arguments(AG "SHARED;STATIC;OBJECT;NO_PRECOMPILE_HEADERS" "UNITY_BATCH_SIZE" "" ${ARGN})
+
+	set(fragment "${directory}/glue.cmake")
+	if(NOT EXISTS "${fragment}")
+		message(FATAL_ERROR "autoglue_add_glue: ${fragment} doesn't exist. Generate the glue first.")
+	endif()
+
+	# Reconfigure when the glue is regenerated with different shards.
+	set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${fragment}")
+	include("${fragment}")
+
+	set(library_type SHARED)
+	if(AG_STATIC)
+		set(library_type STATIC)
+	elseif(AG_OBJECT)
+		set(library_type OBJECT)
+	endif()
+
+	add_library(${target} ${library_type} ${AUTOGLUE_GLUE_SOURCES})
+	target_include_directories(${target} PRIVATE "${AUTOGLUE_GLUE_DIRECTORY}")
+
+	# Precompiled headers and unity builds need CMake 3.16.
+	if(CMAKE_VERSION VERSION_LESS 3.16)
+		return()
+	endif()
+
+	if(NOT AG_NO_PRECOMPILE_HEADERS AND AUTOGLUE_GLUE_PRECOMPILE_HEADERS)
+		target_precompile_headers(${target} PRIVATE ${AUTOGLUE_GLUE_PRECOMPILE_HEADERS})
+	endif()
+
+	if(AG_UNITY_BATCH_SIZE)
+		set_target_properties(
+			${target} PROPERTIES
+			UNITY_BUILD ON
+			UNITY_BUILD_BATCH_SIZE ${AG_UNITY_BATCH_SIZE}
+		)
+	endif()
+endfunction()
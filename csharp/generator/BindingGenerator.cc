@@ -7,6 +7,9 @@
 #include <autoglue/ScopeEntity.hh>
 #include <autoglue/FunctionGroupEntity.hh>
 #include <autoglue/FunctionEntity.hh>
+#include <autoglue/FieldEntity.hh>
+#include <autoglue/CallableTypeEntity.hh>
+#include <autoglue/BridgeTable.hh>
 
 #include <string_view>
 #include <filesystem>
@@ -98,6 +101,126 @@ BindingGenerator::BindingGenerator(ag::Backend& backend, std::string_view libNam
 	namespaces.emplace("gencs");
 }
 
+void BindingGenerator::setCallMode(CallMode mode)
+{
+	callMode = mode;
+}
+
+void BindingGenerator::setBlittableSignatures(bool value)
+{
+	blittableSignatures = value;
+}
+
+void BindingGenerator::setIdentityCache(bool value)
+{
+	identityCache = value;
+}
+
+void BindingGenerator::setBridgeStats(bool value)
+{
+	bridgeStats = value;
+}
+
+bool BindingGenerator::usesBridgeStubs()
+{
+	return callMode != CallMode::DllImport || blittableSignatures;
+}
+
+static const char* getUnmanagedType(PrimitiveEntity::Type type)
+{
+	switch(type)
+	{
+		// C# bool and char don't match the size of their C++ counterparts,
+		// so they are passed as bytes when no marshalling is done.
+		case PrimitiveEntity::Type::Boolean: return "byte";
+		case PrimitiveEntity::Type::Character: return "byte";
+		case PrimitiveEntity::Type::Integer: return "int";
+		case PrimitiveEntity::Type::Int8: return "sbyte";
+		case PrimitiveEntity::Type::Int16: return "short";
+		case PrimitiveEntity::Type::Int64: return "long";
+		case PrimitiveEntity::Type::UInt8: return "byte";
+		case PrimitiveEntity::Type::UInt16: return "ushort";
+		case PrimitiveEntity::Type::UInt32: return "uint";
+		case PrimitiveEntity::Type::UInt64: return "ulong";
+		case PrimitiveEntity::Type::IntPtr: return "nint";
+		case PrimitiveEntity::Type::UIntPtr: return "nuint";
+		case PrimitiveEntity::Type::Float: return "float";
+		case PrimitiveEntity::Type::Double: return "double";
+		case PrimitiveEntity::Type::String: return "gencs.AG_String";
+		case PrimitiveEntity::Type::Buffer: return "gencs.AG_Buffer";
+		case PrimitiveEntity::Type::Void: return "void";
+		case PrimitiveEntity::Type::ObjectHandle: return "nint";
+	}
+
+	return "";
+}
+
+static bool isView(PrimitiveEntity::Type type)
+{
+	return type == PrimitiveEntity::Type::String || type == PrimitiveEntity::Type::Buffer;
+}
+
+static bool isView(TypeReferenceEntity entity)
+{
+	// Value types are the only POD types that aren't primitives.
+	return entity.isPrimitive() && isView(entity.getPrimitiveType().getType());
+}
+
+static bool passesViews(FunctionEntity& entity)
+{
+	if(entity.returnsValue() && isView(entity.getReturnType(true)))
+	{
+		return true;
+	}
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		if(isView(entity.getParameter(i).getAsPOD()))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool passesCallables(FunctionEntity& entity)
+{
+	if(entity.returnsValue() && entity.getReturnType(true).isCallable())
+	{
+		return true;
+	}
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		if(entity.getParameter(i).getAsPOD().isCallable())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool hasStorableBase(ClassEntity& entity)
+{
+	for(size_t i = 0; i < entity.getBaseTypeCount(); i++)
+	{
+		auto& base = entity.getBaseType(i);
+		if(base.getType() == TypeEntity::Type::Class && static_cast <ClassEntity&> (base).isStorable())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static std::string getBufferElement(TypeReferenceEntity& entity)
+{
+	return getUnmanagedType(entity.getPrimitiveType().getElementType());
+}
+
 void BindingGenerator::generateClass(ClassEntity& entity)
 {
 	// Generate a file for each top level class.
@@ -106,14 +229,31 @@ void BindingGenerator::generateClass(ClassEntity& entity)
 		openFile(entity);
 	}
 
+	// Value types are structs with the same layout as the C++ class.
+	if(entity.isValueType())
+	{
+		generateValueType(entity);
+		return;
+	}
+
 	file << "public ";
 
+	// Function pointers and pointers to strings require an unsafe context. Interception
+	// functions use them in every call mode, so the classes are always unsafe.
+	file << "unsafe ";
+
 	auto ctx = getCSharpContext(entity);
 	if(entity.isAbstract())
 	{
 		file << "abstract ";
 	}
 
+	// LibraryImport generates the other part of the class.
+	if(callMode == CallMode::LibraryImport)
+	{
+		file << "partial ";
+	}
+
 	file << "class " << sanitizeName(entity);
 
 	entity.generateBaseTypes(*this);
@@ -126,6 +266,24 @@ void BindingGenerator::generateClass(ClassEntity& entity)
 
 		file << "public static IntPtr AG_getObjectHandle(" << getTypeLocation(entity) << " obj)" <<
 				"\n{\nreturn obj.mObjectHandle;\n}\n";
+
+		// Objects consumed by the native code give up their handle so that they can't be used again.
+		file << "public static IntPtr AG_takeObjectHandle(" << getTypeLocation(entity) << " obj)" <<
+				"\n{\nIntPtr handle = obj.mObjectHandle;\nobj.mObjectHandle = IntPtr.Zero;\nreturn handle;\n}\n";
+	}
+
+	// Callers providing storage for returned objects need the layout of the class.
+	if(entity.isStorable())
+	{
+		const char* hides = hasStorableBase(entity) ? "new " : "";
+
+		file << "public " << hides << "const int StorageSize = " << entity.getStorageSize() << ";\n";
+		file << "public " << hides << "const int StorageAlignment = " << entity.getStorageAlignment() << ";\n";
+	}
+
+	if(identityCache)
+	{
+		generateIdentityCache(entity);
 	}
 
 	// Define a constructor for object handle initialization.
@@ -188,6 +346,74 @@ void BindingGenerator::generateClass(ClassEntity& entity)
 	}
 }
 
+void BindingGenerator::generateIdentityCache(ClassEntity& entity)
+{
+	auto type = getTypeLocation(entity);
+	auto created = "new " + (entity.isAbstract() ? type + ".ConcreteType" : type) + "(handle)";
+
+	file << "private static readonly System.Collections.Generic.Dictionary <IntPtr, WeakReference <" << type <<
+			">> AG_wrappers = new System.Collections.Generic.Dictionary <IntPtr, WeakReference <" << type << ">> ();\n";
+	file << "private static int AG_wrapperLimit = 64;\n";
+
+	file << "public static " << (entity.hasBaseTypes() ? "new " : "") << type << " AG_wrap(IntPtr handle)\n{\n";
+	file << "if(handle == IntPtr.Zero)\n{\nreturn " << created << ";\n}\n";
+	file << "lock(AG_wrappers)\n{\n";
+
+	// A wrapper that gave up its handle no longer represents the native object.
+	file << "if(AG_wrappers.TryGetValue(handle, out var weak) && weak.TryGetTarget(out var existing) && " <<
+			"existing.mObjectHandle == handle)\n{\nreturn existing;\n}\n";
+
+	// Entries of collected wrappers are removed once the map has doubled in size.
+	file << "if(AG_wrappers.Count >= AG_wrapperLimit)\n{\n";
+	file << "foreach(var entry in AG_wrappers)\n{\n";
+	file << "if(!entry.Value.TryGetTarget(out var alive) || alive.mObjectHandle != entry.Key)\n{\n";
+	file << "AG_wrappers.Remove(entry.Key);\n}\n}\n";
+	file << "AG_wrapperLimit = Math.Max(64, AG_wrappers.Count * 2);\n}\n";
+
+	file << "var created = " << created << ";\n";
+	file << "AG_wrappers[handle] = new WeakReference <" << type << "> (created);\n";
+	file << "return created;\n}\n}\n";
+}
+
+void BindingGenerator::generateValueType(ClassEntity& entity)
+{
+	file << "[StructLayout(LayoutKind.Sequential, Size = " << entity.getValueSize() << ")]\n";
+	file << "public struct " << sanitizeName(entity) << "\n{\n";
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		file << "public " << getUnmanagedType(field.type->getType()) << ' ' << field.name << ";\n";
+	}
+
+	// Initialize every field in the order that they were declared in.
+	file << "public " << sanitizeName(entity) << '(';
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		file << (i > 0 ? ", " : "") << getUnmanagedType(field.type->getType()) << ' ' << field.name;
+	}
+
+	file << ")\n{\n";
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		file << "this." << field.name << " = " << field.name << ";\n";
+	}
+
+	file << "}\n";
+	file << "}\n";
+
+	// Close the opened file if this is a top level class.
+	if(getClassDepth() == 1)
+	{
+		assert(file.is_open());
+		file.close();
+	}
+}
+
 void BindingGenerator::generateEnum(EnumEntity& entity)
 {
 	// If no class is active, generate an enum to its own file.
@@ -294,6 +520,110 @@ std::shared_ptr <FunctionEntity> getOverriddenInCompositeBase(FunctionEntity& en
 	return nullptr;
 }
 
+static std::string getUnmanagedValue(TypeReferenceEntity& entity, const std::string& value)
+{
+	switch(entity.getPrimitiveType().getType())
+	{
+		case PrimitiveEntity::Type::Boolean: return "(byte)(" + value + " ? 1 : 0)";
+		case PrimitiveEntity::Type::Character: return "(byte)" + value;
+		default: return value;
+	}
+}
+
+static std::string getManagedValue(TypeReferenceEntity& entity, const std::string& value)
+{
+	switch(entity.getPrimitiveType().getType())
+	{
+		case PrimitiveEntity::Type::Boolean: return value + " != 0";
+		case PrimitiveEntity::Type::Character: return "(char)" + value;
+		default: return value;
+	}
+}
+
+void BindingGenerator::generateCallableType(CallableTypeEntity& entity)
+{
+	ensureCallableHelpers();
+	openFile(entity);
+
+	auto name = entity.getName();
+	auto returnType = entity.getReturnType().getPrimitiveType().getType();
+
+	// Callables are presented as delegates so that lambdas can be passed.
+	file << "public delegate ";
+	generateTypeReference(entity.getReturnType());
+	file << name << '(';
+
+	std::string pointerType = "delegate* unmanaged[Cdecl]<IntPtr";
+	std::string parameters;
+	std::string managedArguments;
+	std::string unmanagedArguments;
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		auto paramName = sanitizeName(param);
+
+		file << (i > 0 ? ", " : "");
+		generateTypeReference(param);
+
+		pointerType += std::string(", ") + getUnmanagedType(param.getPrimitiveType().getType());
+		parameters += std::string(", ") + getUnmanagedType(param.getPrimitiveType().getType()) + ' ' + paramName;
+		managedArguments += (i > 0 ? ", " : "") + getManagedValue(param, paramName);
+		unmanagedArguments += ", " + getUnmanagedValue(param, paramName);
+	}
+
+	file << ");\n";
+	pointerType += std::string(", ") + getUnmanagedType(returnType) + '>';
+
+	file << "internal static unsafe class AG_" << name << "\n{\n";
+
+	// Delegates are called by the glue code through a trampoline whose context is a handle to the delegate.
+	file << "[UnmanagedCallersOnly(CallConvs = new[] { typeof(System.Runtime.CompilerServices.CallConvCdecl) })]\n";
+	file << "private static " << getUnmanagedType(returnType) << " Invoke(IntPtr context" << parameters << ")\n{\n";
+
+	std::string call = "((" + name + ")GCHandle.FromIntPtr(context).Target)(" + managedArguments + ')';
+	file << (entity.returnsValue() ? "return " + getUnmanagedValue(entity.getReturnType(), call) : call) << ";\n}\n";
+
+	file << "public static gencs.AG_Callable ToNative(" << name << " value)\n{\n";
+	file << "if(value == null)\n{\nreturn default;\n}\n";
+	file << "return new gencs.AG_Callable((IntPtr)(" << pointerType << ")&Invoke, " <<
+			"gencs.AG_CallablePool.Acquire(value), gencs.AG_CallablePool.Releaser);\n}\n";
+
+	// Callables returned by the glue code are called through their trampoline. The owner
+	// releases the context once the delegate can no longer be called.
+	file << "public static " << name << " FromNative(gencs.AG_Callable value)\n{\n";
+	file << "if(value.Invoke == IntPtr.Zero)\n{\nreturn null;\n}\n";
+	file << "var owner = new gencs.AG_NativeCallable(value);\n";
+	file << "return (";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		file << (i > 0 ? ", " : "") << sanitizeName(entity.getParameter(i));
+	}
+
+	file << ") =>\n{\n";
+
+	call = "((" + pointerType + ")owner.Invoke)(owner.Context" + unmanagedArguments + ')';
+
+	if(entity.returnsValue())
+	{
+		file << "var result = " << call << ";\n";
+		file << "GC.KeepAlive(owner);\n";
+		file << "return " << getManagedValue(entity.getReturnType(), "result") << ";\n";
+	}
+
+	else
+	{
+		file << call << ";\n";
+		file << "GC.KeepAlive(owner);\n";
+	}
+
+	file << "};\n}\n";
+	file << "}\n";
+
+	file.close();
+}
+
 void BindingGenerator::generateFunction(FunctionEntity& entity)
 {
 	if(entity.getOverloadedOperator() != FunctionEntity::OverloadedOperator::None)
@@ -301,8 +631,14 @@ void BindingGenerator::generateFunction(FunctionEntity& entity)
 		return;
 	}
 
+	// Objects are only destroyed explicitly when they are in caller provided storage.
 	if(entity.getType() == FunctionEntity::Type::Destructor)
 	{
+		if(entity.hasStorageBridge())
+		{
+			generateStorageFunction(entity);
+		}
+
 		return;
 	}
 
@@ -313,17 +649,7 @@ void BindingGenerator::generateFunction(FunctionEntity& entity)
 
 	if(!entity.isInterface())
 	{
-		file << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
-		file << "private static extern ";
-
-		// Represent strings as IntPtr when returning from externed functions.
-		convertStringType = true;
-		entity.generateReturnType(*this, true);
-		convertStringType = false;
-
-		file << entity.getBridgeName() << '(';
-		entity.generateParameters(*this, true, true);
-		file << ");\n";
+		generateBridgeImport(entity);
 	}
 
 	file << (isOverloadProtected(entity) ? "protected " : "public ");
@@ -406,95 +732,724 @@ void BindingGenerator::generateFunction(FunctionEntity& entity)
 	}
 
 	file << "}\n";
-}
 
-void BindingGenerator::generateTypeReference(TypeReferenceEntity& entity)
-{
-	if(onlyParameterNames)
+	if(entity.isBatched())
 	{
-		if(delegateInterception)
-		{
-			file << sanitizeName(entity);
-			return;
-		}
+		generateBatchedFunction(entity);
+	}
 
-		// If a parameter pass is being generated for an interception function,
-		// follow the same logic as when returning values. This works because an
-		// interception function accepts POD types and converts them to C# types,
-		// much like when returning values.
-		if(inIntercept)
-		{
-			bool closeParenthesis = generateBridgeToCSharp(entity);
-			file << sanitizeName(entity);
+	if(entity.hasStorageBridge())
+	{
+		generateStorageFunction(entity);
+	}
 
-			if(closeParenthesis)
-			{
-				file << ')';
-			}
-		}
+	if(entity.isAsync())
+	{
+		generateAsyncFunction(entity);
+	}
+}
 
-		else
-		{
-			bool closeParenthesis = generateCSharpToBridge(entity);
-			file << sanitizeName(entity);
+void BindingGenerator::generateStorageFunction(FunctionEntity& entity)
+{
+	inStorage = true;
+	generateBridgeImport(entity);
 
-			if(closeParenthesis)
-			{
-				file << ')';
-			}
-		}
+	// The object is destroyed, but the storage is left for the caller to free or reuse.
+	if(entity.getType() == FunctionEntity::Type::Destructor)
+	{
+		file << "public " << (hasStorableBase(static_cast <ClassEntity&> (entity.getParent())) ? "new " : "") <<
+				"void destroyInPlace()\n{\n";
+		file << entity.getStorageBridgeName() << "(mObjectHandle);\n";
+		file << "mObjectHandle = IntPtr.Zero;\n}\n";
 	}
 
+	// The storage overload returns an object that doesn't own its storage.
 	else
 	{
-		if(entity.isPrimitive())
-		{
-			const char* primitive = "";
-
-			switch(entity.getPrimitiveType().getType())
-			{
-				case PrimitiveEntity::Type::Boolean: primitive = "bool"; break;
-				case PrimitiveEntity::Type::Character: primitive = "char"; break;
-				case PrimitiveEntity::Type::Integer: primitive = "int"; break;
-				case PrimitiveEntity::Type::Float: primitive = "float"; break;
-				case PrimitiveEntity::Type::Double: primitive = "double"; break;
-				case PrimitiveEntity::Type::String: primitive = convertStringType ? "IntPtr" : "string"; break;
-				case PrimitiveEntity::Type::Void: primitive = "void"; break;
-				case PrimitiveEntity::Type::ObjectHandle: primitive = "IntPtr"; break;
-			}
+		file << (isOverloadProtected(entity) ? "protected " : "public ") << (entity.isStatic() ? "static " : "");
+		entity.generateReturnType(*this, false);
+		file << sanitizeName(entity) << '(';
+		entity.generateParameters(*this, false, false);
+		file << (entity.getParameterCount() > 0 ? ", " : "") << "IntPtr storage)\n{\n";
 
-			file << primitive << ' ' << sanitizeName(entity);
-		}
+		bool closeParenthesis = entity.generateReturnStatement(*this, false);
+		entity.generateBridgeCall(*this);
 
-		else
+		if(closeParenthesis)
 		{
-			auto location = getTypeLocation(entity.getReferred());
-			sanitizeName(location);
-
-			file << location << ' ' << sanitizeName(entity);
+			file << ')';
 		}
+
+		file << ";\n}\n";
 	}
+
+	inStorage = false;
 }
 
-void BindingGenerator::generateTypeAlias(TypeAliasEntity&)
+void BindingGenerator::generateStorageParameter(FunctionEntity& entity)
 {
-	// TODO: Implement type aliases with class inheritance?
+	// Destructors destroy objects in place and take no storage.
+	if(!inStorage || entity.getType() == FunctionEntity::Type::Destructor)
+	{
+		return;
+	}
 
-	//if(getClassDepth() == 0)
-	//{
-	//	openFile(entity);
-	//}
+	switch(stubPart)
+	{
+		case StubPart::Prepare:
+		case StubPart::Cleanup: return;
 
-	//else
-	//{
-	//	return;
-	//}
+		case StubPart::Types: file << "IntPtr"; break;
+		case StubPart::Arguments: file << "storage"; break;
+		default: file << (onlyParameterNames ? "storage" : "IntPtr storage");
+	}
 
-	//auto underlying = entity.getUnderlying()->getHierarchy(".");
-	//sanitizeName(underlying);
+	if(entity.getParameterCount(true) > 0)
+	{
+		file << ", ";
+	}
+}
 
-	//file << "using " << sanitizeName(entity) << " = " << underlying << ";\n";
-	////file << "public class " << sanitizeName(entity) << "{}\n";
+void BindingGenerator::generateErrorParameter(FunctionEntity& entity)
+{
+	// Interception functions are called by the glue code without an error slot.
+	if(!entity.isThrowing() || inIntercept)
+	{
+		return;
+	}
+
+	// The error slot is passed after every other parameter.
+	const char* separator = entity.getParameterCount(true) > 0 ||
+		(inStorage && entity.getType() != FunctionEntity::Type::Destructor) ? ", " : "";
+
+	switch(stubPart)
+	{
+		case StubPart::Types: file << separator << "gencs.AG_Error*"; break;
+		case StubPart::Declaration: file << separator << "gencs.AG_Error* AG_error"; break;
+		case StubPart::Arguments: file << separator << "&AG_error"; break;
+		default: break;
+	}
+}
+
+std::string BindingGenerator::getBridgeName(FunctionEntity& entity)
+{
+	return inStorage ? entity.getStorageBridgeName() : entity.getBridgeName();
+}
+
+void BindingGenerator::generateBatchedFunction(FunctionEntity& entity)
+{
+	auto bridgeName = entity.getBatchBridgeName();
+	std::string results = entity.returnsValue() ?
+		getUnmanagedType(entity.getReturnType(true).getPrimitiveType().getType()) : "";
+
+	std::string types = "IntPtr*, nuint, ulong";
+	std::string declaration = "IntPtr* AG_objects, nuint AG_count, ulong AG_broadcast";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		std::string type = getUnmanagedType(param.getAsPOD().getPrimitiveType().getType());
+
+		types += ", " + type + '*';
+		declaration += ", " + type + "* " + sanitizeName(param);
+	}
+
+	if(!results.empty())
+	{
+		types += ", " + results + '*';
+		declaration += ", " + results + "* AG_results";
+	}
+
+	if(entity.isThrowing())
+	{
+		ensureErrorHelpers();
+		types += ", gencs.AG_Error*";
+		declaration += ", gencs.AG_Error* AG_error";
+	}
+
+	// A batch may take a while, so the GC transition is never suppressed.
+	if(callMode == CallMode::BridgeTable)
+	{
+		file << "private static readonly delegate* unmanaged[Cdecl]<" << types << ", void> AG_bridge_" << bridgeName <<
+				" = (delegate* unmanaged[Cdecl]<" << types << ", void>)gencs.AG_BridgeTable.Get(" <<
+				getBridgeIndex(bridgeName) << ");\n";
+	}
+
+	else if(callMode == CallMode::LibraryImport)
+	{
+		generateLibraryImport(bridgeName, false);
+		file << "private static partial void AG_bridge_" << bridgeName << '(' << declaration << ");\n";
+	}
+
+	else
+	{
+		file << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl, EntryPoint = \"" <<
+				bridgeName << "\")]\n";
+		file << "private static extern void AG_bridge_" << bridgeName << '(' << declaration << ");\n";
+	}
+
+	// The caller collects the object handles and the results.
+	auto objectType = getTypeLocation(static_cast <TypeEntity&> (entity.getParent()));
+
+	std::string returnType = results.empty() ? "void" : results + "[]";
+
+	file << "private static " << returnType << ' ' << bridgeName << '(' << objectType << "[] objects, ulong AG_broadcast";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		file << ", " << getUnmanagedType(param.getAsPOD().getPrimitiveType().getType()) << "* " << sanitizeName(param);
+	}
+
+	file << ")\n{\n";
+	file << "var AG_handles = new IntPtr[objects.Length];\n";
+	file << "for(int AG_i = 0; AG_i < objects.Length; AG_i++)\n{\n";
+	file << "AG_handles[AG_i] = objects[AG_i].mObjectHandle;\n}\n";
+
+	if(!results.empty())
+	{
+		file << "var AG_results = new " << results << "[objects.Length];\n";
+	}
+
+	if(entity.isThrowing())
+	{
+		file << "gencs.AG_Error AG_error = default;\n";
+	}
+
+	file << "fixed(IntPtr* AG_pHandles = AG_handles)\n";
+
+	if(!results.empty())
+	{
+		file << "fixed(" << results << "* AG_pResults = AG_results)\n";
+	}
+
+	file << "{\nAG_bridge_" << bridgeName << "(AG_pHandles, (nuint)objects.Length, AG_broadcast";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		file << ", " << sanitizeName(entity.getParameter(i));
+	}
+
+	file << (results.empty() ? "" : ", AG_pResults") << (entity.isThrowing() ? ", &AG_error" : "") << ");\n}\n";
+	file << "GC.KeepAlive(objects);\n";
+
+	if(entity.isThrowing())
+	{
+		file << "gencs.AG_Error.Check(AG_error);\n";
+	}
+
+	if(!results.empty())
+	{
+		file << "return AG_results;\n";
+	}
+
+	file << "}\n";
+
+	// Every argument is either an array with an element for each object or a
+	// single value that is broadcast to every object.
+	for(bool broadcast : { false, true })
+	{
+		if(broadcast && entity.getParameterCount() == 0)
+		{
+			break;
+		}
+
+		file << "public static " << returnType << ' ' << sanitizeName(entity) << "Batch(" << objectType << "[] objects";
+		for(size_t i = 0; i < entity.getParameterCount(); i++)
+		{
+			auto& param = entity.getParameter(i);
+			file << ", " << getUnmanagedType(param.getAsPOD().getPrimitiveType().getType()) <<
+					(broadcast ? " " : "[] ") << sanitizeName(param);
+		}
+
+		file << ")\n{\n";
+
+		if(!broadcast)
+		{
+			for(size_t i = 0; i < entity.getParameterCount(); i++)
+			{
+				auto name = sanitizeName(entity.getParameter(i));
+				file << "if(" << name << ".Length != objects.Length)\n{\n";
+				file << "throw new ArgumentException(\"" << name << " doesn't have an element for each object\");\n}\n";
+			}
+
+			for(size_t i = 0; i < entity.getParameterCount(); i++)
+			{
+				auto& param = entity.getParameter(i);
+				file << "fixed(" << getUnmanagedType(param.getAsPOD().getPrimitiveType().getType()) << "* AG_" <<
+						sanitizeName(param) << " = " << sanitizeName(param) << ")\n";
+			}
+
+			file << "{\n";
+		}
+
+		file << (results.empty() ? "" : "return ") << bridgeName << "(objects, " <<
+				(broadcast ? ~0ULL >> (64 - entity.getParameterCount()) : 0) << "UL";
+
+		for(size_t i = 0; i < entity.getParameterCount(); i++)
+		{
+			file << ", " << (broadcast ? "&" : "AG_") << sanitizeName(entity.getParameter(i));
+		}
+
+		file << ");\n";
+
+		if(!broadcast)
+		{
+			file << "}\n";
+		}
+
+		file << "}\n";
+	}
+}
+
+void BindingGenerator::generateAsyncFunction(FunctionEntity& entity)
+{
+	ensureAsyncHelpers();
+
+	auto bridgeName = entity.getAsyncBridgeName();
+	auto returned = entity.getReturnType(true);
+
+	// Functions returning nothing complete a task whose result is ignored.
+	auto returnType = entity.returnsValue() ? returned.getPrimitiveType().getType() : PrimitiveEntity::Type::Void;
+	std::string result = returnType == PrimitiveEntity::Type::Void ? "bool" :
+						returnType == PrimitiveEntity::Type::Boolean ? "bool" :
+						returnType == PrimitiveEntity::Type::Character ? "char" : getUnmanagedType(returnType);
+
+	std::string completionType = "delegate* unmanaged[Cdecl]<IntPtr, IntPtr" +
+		(entity.returnsValue() ? std::string(", ") + getUnmanagedType(returnType) : "") + ", void>";
+
+	// The worker thread calls the completion function with the context and the message of the
+	// exception that the function threw, or null if it succeeded.
+	file << "[UnmanagedCallersOnly(CallConvs = new[] { typeof(System.Runtime.CompilerServices.CallConvCdecl) })]\n";
+	file << "private static void AG_complete_" << bridgeName << "(IntPtr context, IntPtr error" <<
+			(entity.returnsValue() ? std::string(", ") + getUnmanagedType(returnType) + " result" : "") << ")\n{\n";
+	file << "gencs.AG_Async<" << result << ">.Complete(context, error, " <<
+			(entity.returnsValue() ? getManagedValue(returned, "result") : "true") << ");\n}\n";
+
+	const char* separator = entity.getParameterCount(true) > 0 ? ", " : "";
+
+	// The call only queues the function, so the GC transition is never suppressed.
+	if(callMode == CallMode::BridgeTable)
+	{
+		file << "private static readonly delegate* unmanaged[Cdecl]<";
+		stubPart = StubPart::Types;
+		entity.generateParameters(*this, true, true);
+		stubPart = StubPart::None;
+		file << separator << "IntPtr, IntPtr, void> AG_bridge_" << bridgeName << " = (delegate* unmanaged[Cdecl]<";
+		stubPart = StubPart::Types;
+		entity.generateParameters(*this, true, true);
+		stubPart = StubPart::None;
+		file << separator << "IntPtr, IntPtr, void>)gencs.AG_BridgeTable.Get(" << getBridgeIndex(bridgeName) << ");\n";
+	}
+
+	else
+	{
+		if(callMode == CallMode::LibraryImport)
+		{
+			generateLibraryImport(bridgeName, false);
+			file << "private static partial void";
+		}
+
+		else
+		{
+			file << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl, EntryPoint = \"" <<
+					bridgeName << "\")]\n";
+			file << "private static extern void";
+		}
+
+		file << " AG_bridge_" << bridgeName << '(';
+		stubPart = StubPart::Declaration;
+		entity.generateParameters(*this, true, true);
+		stubPart = StubPart::None;
+		file << separator << "IntPtr AG_complete, IntPtr AG_context);\n";
+	}
+
+	// The task keeps the object alive until the call has completed.
+	file << (isOverloadProtected(entity) ? "protected " : "public ") << (entity.isStatic() ? "static " : "") <<
+			(returnType == PrimitiveEntity::Type::Void ? "Task" : "Task<" + result + '>') << ' ' <<
+			sanitizeName(entity) << "Async(";
+	entity.generateParameters(*this, false, false);
+	file << ")\n{\n";
+
+	file << "var AG_context = gencs.AG_Async<" << result << ">.Start(" << (entity.isStatic() ? "null" : "this") <<
+			", out var AG_task);\n";
+
+	// Strings are encoded like in regular calls and copied by the glue code for the worker.
+	stubPart = StubPart::Prepare;
+	entity.generateParameters(*this, true, true);
+	stubPart = StubPart::None;
+
+	file << "AG_bridge_" << bridgeName << '(';
+
+	onlyParameterNames = true;
+	stubPart = StubPart::Arguments;
+	entity.generateParameters(*this, true, true);
+	stubPart = StubPart::None;
+	onlyParameterNames = false;
+
+	file << separator << "(IntPtr)(" << completionType << ")&AG_complete_" << bridgeName << ", AG_context);\n";
+
+	stubPart = StubPart::Cleanup;
+	entity.generateParameters(*this, true, true);
+	stubPart = StubPart::None;
+
+	file << "return AG_task;\n}\n";
+}
+
+void BindingGenerator::generateField(FieldEntity& entity)
+{
+	auto& getter = entity.getGetter();
+
+	// Fields that can't be accessed directly are accessed through bridge functions.
+	if(!entity.hasOffset())
+	{
+		generateBridgeImport(getter);
+
+		if(!entity.isReadOnly())
+		{
+			generateBridgeImport(entity.getSetter());
+		}
+	}
+
+	file << "public ";
+
+	// If this field hides another defined in a base class, mark it as new.
+	if(hidesEntity(entity, entity.getParent()))
+	{
+		file << "new ";
+	}
+
+	getter.generateReturnType(*this, false);
+	file << sanitizeName(entity) << "\n{\nget\n{\n";
+
+	// The field is read from its offset within the object without a call.
+	// Booleans and characters are stored as bytes.
+	std::string address;
+	PrimitiveEntity::Type primitive = PrimitiveEntity::Type::Void;
+
+	if(entity.hasOffset())
+	{
+		address = "((byte*)mObjectHandle + " + std::to_string(entity.getOffset()) + ')';
+		primitive = getter.getReturnType(true).getPrimitiveType().getType();
+
+		file << "return ";
+
+		switch(primitive)
+		{
+			case PrimitiveEntity::Type::Boolean: file << "*" << address << " != 0"; break;
+			case PrimitiveEntity::Type::Character: file << "(char)*" << address; break;
+			default: file << "*(" << getUnmanagedType(primitive) << "*)" << address; break;
+		}
+
+		file << ";\n";
+	}
+
+	else
+	{
+		bool closeParenthesis = getter.generateReturnStatement(*this, false);
+		getter.generateBridgeCall(*this);
+
+		if(closeParenthesis)
+		{
+			file << ')';
+		}
+
+		file << ";\n";
+	}
+
+	file << "}\n";
+
+	if(!entity.isReadOnly())
+	{
+		file << "set\n{\n";
+
+		if(entity.hasOffset())
+		{
+			switch(primitive)
+			{
+				case PrimitiveEntity::Type::Boolean: file << "*" << address << " = (byte)(value ? 1 : 0)"; break;
+				case PrimitiveEntity::Type::Character: file << "*" << address << " = (byte)value"; break;
+				default: file << "*(" << getUnmanagedType(primitive) << "*)" << address << " = value"; break;
+			}
+		}
+
+		else
+		{
+			entity.getSetter().generateBridgeCall(*this);
+		}
+
+		file << ";\n}\n";
+	}
+
+	file << "}\n";
+}
+
+void BindingGenerator::generateTypeReference(TypeReferenceEntity& entity)
+{
+	if(entity.isPrimitive() && isView(entity.getPrimitiveType().getType()))
+	{
+		ensureViewHelpers();
+	}
+
+	else if(entity.isCallable())
+	{
+		ensureCallableHelpers();
+	}
+
+	// Parts of bridge function callers only deal with POD types.
+	if(stubPart != StubPart::None)
+	{
+		// Callables are converted to AG_Callable when they are passed.
+		if(entity.isCallable())
+		{
+			if(stubPart == StubPart::Types || stubPart == StubPart::Declaration)
+			{
+				file << "gencs.AG_Callable";
+			}
+
+			if(stubPart == StubPart::Declaration)
+			{
+				file << ' ' << sanitizeName(entity);
+			}
+
+			else if(stubPart == StubPart::Arguments)
+			{
+				file << "gencs.AG_" << entity.getCallableType().getName() << ".ToNative(" << sanitizeName(entity) << ')';
+			}
+
+			return;
+		}
+
+		// Value types are blittable as they are.
+		if(!entity.isPrimitive())
+		{
+			assert(entity.getType() == TypeEntity::Type::Class && entity.getClassType().isValueType());
+
+			if(stubPart == StubPart::Types || stubPart == StubPart::Declaration)
+			{
+				auto location = getTypeLocation(entity.getReferred());
+				sanitizeName(location);
+
+				file << location;
+			}
+
+			if(stubPart == StubPart::Declaration)
+			{
+				file << ' ';
+			}
+
+			if(stubPart == StubPart::Declaration || stubPart == StubPart::Arguments)
+			{
+				file << sanitizeName(entity);
+			}
+
+			return;
+		}
+
+		auto primitive = entity.getPrimitiveType().getType();
+
+		switch(stubPart)
+		{
+			case StubPart::Types:
+			{
+				file << getUnmanagedType(primitive);
+				break;
+			}
+
+			case StubPart::Declaration:
+			{
+				file << getUnmanagedType(primitive) << ' ' << sanitizeName(entity);
+				break;
+			}
+
+			case StubPart::Arguments:
+			{
+				if(primitive == PrimitiveEntity::Type::String)
+				{
+					file << "new gencs.AG_String(" << sanitizeName(entity) << " == null ? null : AG_" <<
+							sanitizeName(entity) << ", AG_length_" << sanitizeName(entity) << ')';
+				}
+
+				else if(primitive == PrimitiveEntity::Type::Buffer)
+				{
+					file << "new gencs.AG_Buffer(AG_" << sanitizeName(entity) << ", " << sanitizeName(entity) << ".Length)";
+				}
+
+				else if(primitive == PrimitiveEntity::Type::Boolean)
+				{
+					file << "(byte)(" << sanitizeName(entity) << " ? 1 : 0)";
+				}
+
+				else if(primitive == PrimitiveEntity::Type::Character)
+				{
+					file << "(byte)" << sanitizeName(entity);
+				}
+
+				else
+				{
+					file << sanitizeName(entity);
+				}
+
+				break;
+			}
+
+			// Strings are passed as null terminated UTF-8 along with their length.
+			// Short strings are encoded on the stack so that no allocation is needed.
+			case StubPart::Prepare:
+			{
+				if(primitive == PrimitiveEntity::Type::String)
+				{
+					auto name = sanitizeName(entity);
+
+					file << "int AG_size_" << name << " = " << name << " == null ? 1 : " <<
+							"System.Text.Encoding.UTF8.GetMaxByteCount(" << name << ".Length) + 1;\n";
+					file << "Span<byte> AG_buffer_" << name << " = AG_size_" << name << " <= " << stackStringSize <<
+							" ? stackalloc byte[" << stackStringSize << "] : new byte[AG_size_" << name << "];\n";
+					file << "int AG_length_" << name << " = " << name << " == null ? 0 : " <<
+							"System.Text.Encoding.UTF8.GetBytes(" << name << ", AG_buffer_" << name << ");\n";
+					file << "AG_buffer_" << name << "[AG_length_" << name << "] = 0;\n";
+					file << "fixed(byte* AG_" << name << " = AG_buffer_" << name << ")\n{\n";
+				}
+
+				// Buffers are pinned for the duration of the call instead of being copied.
+				else if(primitive == PrimitiveEntity::Type::Buffer)
+				{
+					file << "fixed(" << getBufferElement(entity) << "* AG_" << sanitizeName(entity) << " = " <<
+							sanitizeName(entity) << ")\n{\n";
+				}
+
+				break;
+			}
+
+			// Close the fixed statements.
+			case StubPart::Cleanup:
+			{
+				if(isView(primitive))
+				{
+					file << "}\n";
+				}
+
+				break;
+			}
+
+			case StubPart::None: {}
+		}
+
+		return;
+	}
+
+	if(onlyParameterNames)
+	{
+		if(delegateInterception)
+		{
+			file << sanitizeName(entity);
+			return;
+		}
+
+		// If a parameter pass is being generated for an interception function,
+		// follow the same logic as when returning values. This works because an
+		// interception function accepts POD types and converts them to C# types,
+		// much like when returning values.
+		if(inIntercept)
+		{
+			// Interception functions receive blittable types from the glue code.
+			if(entity.isPrimitive())
+			{
+				switch(entity.getPrimitiveType().getType())
+				{
+					case PrimitiveEntity::Type::Boolean: file << sanitizeName(entity) << " != 0"; return;
+					case PrimitiveEntity::Type::Character: file << "(char)" << sanitizeName(entity); return;
+					case PrimitiveEntity::Type::String: file << sanitizeName(entity) << ".Decode()"; return;
+
+					// The buffer stays valid while the interception function runs.
+					case PrimitiveEntity::Type::Buffer:
+						file << sanitizeName(entity) << ".AsSpan<" << getBufferElement(entity) << ">()";
+						return;
+					default: break;
+				}
+			}
+
+			bool closeParenthesis = generateBridgeToCSharp(entity);
+			file << sanitizeName(entity);
+
+			if(closeParenthesis)
+			{
+				file << ')';
+			}
+		}
+
+		else
+		{
+			bool closeParenthesis = generateCSharpToBridge(entity);
+			file << sanitizeName(entity);
+
+			if(closeParenthesis)
+			{
+				file << ')';
+			}
+		}
+	}
+
+	else
+	{
+		if(entity.isPrimitive())
+		{
+			std::string primitive;
+
+			switch(entity.getPrimitiveType().getType())
+			{
+				// Buffer parameters can be anything that converts to a span, and returned buffers are copied
+				// unless they are borrowed. Return types are the only type references without a name.
+				case PrimitiveEntity::Type::Buffer:
+				{
+					primitive = !entity.getName().empty() ? "Span<" + getBufferElement(entity) + '>' :
+								entity.isReference() ? "ReadOnlySpan<" + getBufferElement(entity) + '>' :
+								getBufferElement(entity) + "[]";
+					break;
+				}
+
+				case PrimitiveEntity::Type::Boolean: primitive = "bool"; break;
+				case PrimitiveEntity::Type::Character: primitive = "char"; break;
+				case PrimitiveEntity::Type::Float: primitive = "float"; break;
+				case PrimitiveEntity::Type::Double: primitive = "double"; break;
+				case PrimitiveEntity::Type::String: primitive = "string"; break;
+				case PrimitiveEntity::Type::Void: primitive = "void"; break;
+				case PrimitiveEntity::Type::ObjectHandle: primitive = "IntPtr"; break;
+
+				// Integers are the same type on both sides.
+				default: primitive = getUnmanagedType(entity.getPrimitiveType().getType()); break;
+			}
+
+			file << primitive << ' ' << sanitizeName(entity);
+		}
+
+		else
+		{
+			auto location = getTypeLocation(entity.getReferred());
+			sanitizeName(location);
+
+			file << location << ' ' << sanitizeName(entity);
+		}
+	}
+}
+
+void BindingGenerator::generateTypeAlias(TypeAliasEntity&)
+{
+	// TODO: Implement type aliases with class inheritance?
+
+	//if(getClassDepth() == 0)
+	//{
+	//	openFile(entity);
+	//}
+
+	//else
+	//{
+	//	return;
+	//}
+
+	//auto underlying = entity.getUnderlying()->getHierarchy(".");
+	//sanitizeName(underlying);
+
+	//file << "using " << sanitizeName(entity) << " = " << underlying << ";\n";
+	////file << "public class " << sanitizeName(entity) << "{}\n";
 
 	//if(getClassDepth() == 0)
 	//{
@@ -626,6 +1581,12 @@ void BindingGenerator::generateNamedScope(ScopeEntity& entity)
 
 void BindingGenerator::generateArgumentSeparator()
 {
+	// Preparation and cleanup statements are not separated.
+	if(stubPart == StubPart::Prepare || stubPart == StubPart::Cleanup)
+	{
+		return;
+	}
+
 	file << ", ";
 }
 
@@ -637,9 +1598,23 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity& entity, Func
 		return false;
 	}
 
+	// Interception functions return blittable types to the glue code.
 	if(inIntercept)
 	{
 		file << "return ";
+
+		if(entity.isPrimitive())
+		{
+			switch(entity.getPrimitiveType().getType())
+			{
+				case PrimitiveEntity::Type::Boolean: file << "Convert.ToByte("; return true;
+				case PrimitiveEntity::Type::Character: file << "(byte)"; return false;
+				case PrimitiveEntity::Type::String: file << "gencs.AG_String.Return("; return true;
+				case PrimitiveEntity::Type::Buffer: file << "gencs.AG_Buffer.Return<" << getBufferElement(entity) << ">("; return true;
+				default: break;
+			}
+		}
+
 		return generateCSharpToBridge(entity);
 	}
 
@@ -649,6 +1624,13 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity& entity, Func
 		target.generateBridgeCall(*this);
 		file << ")\n{\n";
 
+		// Objects created by foreign code are the wrappers of their native objects.
+		if(identityCache)
+		{
+			file << "lock(AG_wrappers)\n{\nAG_wrappers[mObjectHandle] = new WeakReference <" <<
+					getTypeLocation(static_cast <TypeEntity&> (target.getParent())) << "> (this);\n}\n";
+		}
+
 		if(target.shouldPrepareClass())
 		{
 			file << "AG_initializeInterceptionContext();\n";
@@ -683,6 +1665,19 @@ bool BindingGenerator::generateBridgeToCSharp(TypeReferenceEntity& entity)
 
 		case TypeEntity::Type::Class:
 		{
+			// Value types are passed as they are.
+			if(entity.getClassType().isValueType())
+			{
+				break;
+			}
+
+			// The identity cache returns the existing wrapper of the object if there is one.
+			if(identityCache)
+			{
+				file << getTypeLocation(entity.getReferred()) << ".AG_wrap(";
+				return true;
+			}
+
 			if(entity.getClassType().isAbstract())
 			{
 				file << "new " << getTypeLocation(entity.getReferred()) << ".ConcreteType(";
@@ -697,26 +1692,16 @@ bool BindingGenerator::generateBridgeToCSharp(TypeReferenceEntity& entity)
 		}
 
 		case TypeEntity::Type::Enum:
-		{
-			file << "(" << getTypeLocation(entity.getReferred()) << ")";
-			break;
-		}
-
-		case TypeEntity::Type::Primitive:
-		{
-			if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
-			{
-				// TODO: This doesn't support UTF-8?
-				file << "Marshal.PtrToStringAnsi(";
-				return true;
-			}
-
+		{
+			file << "(" << getTypeLocation(entity.getReferred()) << ")";
 			break;
 		}
 
+		// Strings are decoded by the bridge function callers.
+		case TypeEntity::Type::Primitive:
 		case TypeEntity::Type::Callable:
 		{
-			// TODO: Something here?
+			break;
 		}
 	}
 
@@ -740,7 +1725,14 @@ bool BindingGenerator::generateCSharpToBridge(TypeReferenceEntity& entity)
 
 		case TypeEntity::Type::Class:
 		{
-			file << getTypeLocation(entity.getReferred()) << ".AG_getObjectHandle(";
+			// Value types are passed as they are.
+			if(entity.getClassType().isValueType())
+			{
+				break;
+			}
+
+			file << getTypeLocation(entity.getReferred()) << (entity.isConsumed() ?
+					".AG_takeObjectHandle(" : ".AG_getObjectHandle(");
 			return true;
 		}
 
@@ -762,8 +1754,9 @@ bool BindingGenerator::generateCSharpToBridge(TypeReferenceEntity& entity)
 
 void BindingGenerator::generateBridgeCall(FunctionEntity& entity)
 {
-	file << entity.getBridgeName() << '(';
+	file << getBridgeName(entity) << '(';
 	onlyParameterNames = true;
+	generateStorageParameter(entity);
 	entity.generateParameters(*this, false, true);
 	onlyParameterNames = false;
 	file << ')';
@@ -776,7 +1769,35 @@ void BindingGenerator::generateInterceptionFunction(FunctionEntity& entity, Clas
 	// Are we already in an interception context (The initialization function)
 	if(inIntercept)
 	{
-		if(onlyParameterNames)
+		// The names are used to find out which interception functions are overridden.
+		// Functions without a name are assumed to be overridden. Overrides of composition
+		// base functions are implemented in classes that don't derive the generated class.
+		if(listInterceptedNames)
+		{
+			if(entity.getOverloadedOperator() != FunctionEntity::OverloadedOperator::None ||
+				entity.getType() == FunctionEntity::Type::Destructor || overridden)
+			{
+				file << "null, ";
+			}
+
+			else
+			{
+				file << '"' << sanitizeName(entity) << "\", ";
+			}
+		}
+
+		// The interception functions are passed to the bridge table as pointers.
+		else if(stubPart == StubPart::Types)
+		{
+			file << ", IntPtr";
+		}
+
+		else if(stubPart == StubPart::Arguments)
+		{
+			file << ", AG_intercept_" << entity.getBridgeName(true);
+		}
+
+		else if(onlyParameterNames)
 		{
 			// FIXME: Once operator overloads are generated, pass them in correctly.
 			if(entity.getOverloadedOperator() != FunctionEntity::OverloadedOperator::None)
@@ -786,13 +1807,11 @@ void BindingGenerator::generateInterceptionFunction(FunctionEntity& entity, Clas
 
 			else
 			{
-				// TODO: If creating a interception function for overridden, use its bridge name instead.
-				file << ", Marshal.GetFunctionPointerForDelegate(new AG_delegate_intercept_" <<
-						entity.getBridgeName(true) << "(AG_intercept_" << entity.getBridgeName(true) << "))";
+				file << ", AG_interceptor_" << entity.getBridgeName(true);
 			}
 		}
 
-		// The interception delegates are treated as pointers
+		// The interception functions are treated as pointers
 		else
 		{
 			file << ", IntPtr AG_intercept_" << entity.getBridgeName(true);
@@ -814,45 +1833,71 @@ void BindingGenerator::generateInterceptionFunction(FunctionEntity& entity, Clas
 	}
 
 	inIntercept = true;
+	auto shortName = entity.getBridgeName(true);
 
-	file << "[UnmanagedFunctionPointer(CallingConvention.Cdecl)]\n";
-    file << "private delegate ";
+	// The interception function is called directly from the glue code. The object
+	// handle is the GCHandle passed as the foreign object of the interception context.
+	file << "[UnmanagedCallersOnly(CallConvs = new[] { typeof(System.Runtime.CompilerServices.CallConvCdecl) })]\n";
+	file << "private static ";
+	stubPart = StubPart::Types;
 	entity.generateReturnType(*this, true);
-	file << "AG_delegate_intercept_" << entity.getBridgeName(true) << '(';
+	file << " AG_intercept_" << shortName << '(';
+	stubPart = StubPart::Declaration;
 	entity.generateParameters(*this, true, true);
-	file << ");\n";
+	stubPart = StubPart::None;
+	file << ")\n{\n";
 
+	file << (entity.returnsValue() ? "return " : "") << "AG_invoke_" << shortName <<
+			"(((GCHandle)ObjectHandle).Target";
+	generateInterceptionArguments(entity);
+	file << ");\n}\n";
+
+	// The pointer to the interception function is created once per class.
+	file << "private static readonly IntPtr AG_interceptor_" << shortName << " = (IntPtr)(";
+	generateBridgePointerType(entity);
+	file << ")&AG_intercept_" << shortName << ";\n";
+
+	// Interception functions can't be called from C#, so the target object is
+	// passed to a separate function that interception functions of derived classes
+	// can call as well.
 	file << "internal static ";
+	stubPart = StubPart::Types;
 	entity.generateReturnType(*this, true);
-	file << "AG_intercept_" << entity.getBridgeName(true) << '(';
+	file << " AG_invoke_" << shortName << "(object AG_target";
 
-	entity.generateParameters(*this, true, true);
+	if(entity.getParameterCount() > 0)
+	{
+		file << ", ";
+	}
+
+	stubPart = StubPart::Declaration;
+	entity.generateParameters(*this, true, false);
+	stubPart = StubPart::None;
 	file << ")\n{\n";
 
 	delegateInterception = static_cast <bool> (overridden);
 	bool closeParenthesis = entity.generateReturnStatement(*this, false);
 
-	// If the overridden function is from a composition base class, call another
-	// interception function from the member representing the base class.
+	// If the overridden function is from a composition base class, call the
+	// invocation function of the base class with the member representing it.
 	if(overridden)
 	{
-		file << "var AG_BaseHandle = GCHandle.Alloc(" << "((((GCHandle)ObjectHandle" <<
-				").Target) as " << sanitizeName(parentClass) << ").base" << sanitizeName(overridden->getParent()) << ");\n";
-
 		assert(ClassEntity::matchType(overridden->getParent()));
 		file << getTypeLocation(static_cast <ClassEntity&> (overridden->getParent())) <<
-				".AG_intercept_" << overridden->getBridgeName(true) << '(';
+				".AG_invoke_" << overridden->getBridgeName(true) << "((AG_target as " <<
+				sanitizeName(parentClass) << ").base" << sanitizeName(overridden->getParent());
+
+		generateInterceptionArguments(entity);
 	}
 
 	else
 	{
-		file << "((((GCHandle)" << getObjectHandleName() << ").Target) as " <<
-				sanitizeName(parentClass) << ")." << sanitizeName(entity) << '(';
-	}
+		file << "(AG_target as " << sanitizeName(parentClass) << ")." << sanitizeName(entity) << '(';
 
-	onlyParameterNames = true;
-	entity.generateParameters(*this, false, delegateInterception);
-	onlyParameterNames = false;
+		onlyParameterNames = true;
+		entity.generateParameters(*this, false, false);
+		onlyParameterNames = false;
+	}
 
 	if(closeParenthesis)
 	{
@@ -861,29 +1906,57 @@ void BindingGenerator::generateInterceptionFunction(FunctionEntity& entity, Clas
 
 	file << ");\n";
 
-	// If parameters were delegated, destroy the temporarily created GCHandle.
-	if(delegateInterception)
-	{
-		file << "AG_BaseHandle.Free();\n";
-	}
-
 	file << "}\n";
 	inIntercept = false;
 	delegateInterception = false;
 }
 
+void BindingGenerator::generateInterceptionArguments(FunctionEntity& entity)
+{
+	if(entity.getParameterCount() > 0)
+	{
+		file << ", ";
+	}
+
+	bool wasDelegating = delegateInterception;
+	delegateInterception = true;
+	onlyParameterNames = true;
+	entity.generateParameters(*this, true, false);
+	onlyParameterNames = false;
+	delegateInterception = wasDelegating;
+}
+
 void BindingGenerator::generateInterceptionContext(ClassEntity& entity)
 {
 	inIntercept = true;
 
-	file << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
-	file << "private static extern void " << entity.getHierarchy() << "_AG_initializeInterceptionContext(IntPtr ObjectHandle, IntPtr AG_foreignObject";
+	if(callMode != CallMode::DllImport)
+	{
+		generateInterceptionContextStub(entity);
+	}
+
+	else
+	{
+		file << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
+		file << "private static extern void " << entity.getHierarchy() << "_AG_initializeInterceptionContext(" <<
+				"IntPtr ObjectHandle, IntPtr AG_foreignObject, ulong AG_overrides";
+		entity.generateInterceptionFunctions(*this);
+		file << ");\n";
+	}
+
+	// The glue code calls the base implementation directly for functions that
+	// the runtime type of the object doesn't override.
+	ensureInterceptionHelper();
+	file << "private static readonly string[] AG_interceptedNames = { ";
+	listInterceptedNames = true;
 	entity.generateInterceptionFunctions(*this);
-	file << ");\n";
+	listInterceptedNames = false;
+	file << "};\n";
 
 	file << "private void AG_initializeInterceptionContext()\n{\n";
 	file << entity.getHierarchy() << "_AG_initializeInterceptionContext(";
-	file << "mObjectHandle, (IntPtr)GCHandle.Alloc(this)";
+	file << "mObjectHandle, (IntPtr)GCHandle.Alloc(this), gencs.AG_Interception.GetOverrides(GetType(), typeof(" <<
+			getTypeLocation(entity) << "), AG_interceptedNames)";
 
 	onlyParameterNames = true;
 	entity.generateInterceptionFunctions(*this);
@@ -895,13 +1968,6 @@ void BindingGenerator::generateInterceptionContext(ClassEntity& entity)
 
 std::string_view BindingGenerator::getObjectHandleName()
 {
-	// When parameters of an interception functions are delegated to another,
-	// cast the created GCHandle pointing to a composition base to a pointer.
-	if(delegateInterception)
-	{
-		return "(IntPtr)AG_BaseHandle";
-	}
-
 	return onlyParameterNames ? "mObjectHandle" : "ObjectHandle";
 }
 
@@ -985,7 +2051,7 @@ void BindingGenerator::openFile(TypeEntity& entity)
 	assert(!file.is_open());
 	file.open(directory + "/" + entity.getName() + ".cs");
 
-	if(entity.getType() == TypeEntity::Type::Class)
+	if(entity.getType() == TypeEntity::Type::Class || entity.getType() == TypeEntity::Type::Callable)
 	{
 		file << "using System.Runtime.InteropServices;\n";
 	}
@@ -993,6 +2059,413 @@ void BindingGenerator::openFile(TypeEntity& entity)
 	file << "namespace " << namespaces.top() << ";\n";
 }
 
+void BindingGenerator::generateBridgeImport(FunctionEntity& entity)
+{
+	// Strings and buffers are passed as views that DllImport can't create,
+	// and callables are converted to trampolines in the bridge function caller.
+	// The caller also checks the error slot of potentially throwing functions.
+	if(usesBridgeStubs() || passesViews(entity) || passesCallables(entity) || entity.isThrowing())
+	{
+		generateBridgeStub(entity);
+		return;
+	}
+
+	if(suppressesGCTransition(entity))
+	{
+		file << "[SuppressGCTransition]\n";
+	}
+
+	file << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
+	file << "private static extern ";
+	entity.generateReturnType(*this, true);
+
+	file << getBridgeName(entity) << '(';
+	generateStorageParameter(entity);
+	entity.generateParameters(*this, true, true);
+	file << ");\n";
+}
+
+void BindingGenerator::generateBridgeStub(FunctionEntity& entity)
+{
+	auto bridgeName = getBridgeName(entity);
+
+	if(callMode == CallMode::BridgeTable)
+	{
+		file << "private static readonly ";
+		generateBridgePointerType(entity);
+		file << " AG_bridge_" << bridgeName << " = (";
+		generateBridgePointerType(entity);
+		file << ")gencs.AG_BridgeTable.Get(" << getBridgeIndex(bridgeName) << ");\n";
+	}
+
+	else
+	{
+		if(callMode == CallMode::LibraryImport)
+		{
+			generateLibraryImport(bridgeName, suppressesGCTransition(entity));
+			file << "private static partial ";
+		}
+
+		else
+		{
+			if(suppressesGCTransition(entity))
+			{
+				file << "[SuppressGCTransition]\n";
+			}
+
+			file << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl, EntryPoint = \"" <<
+					bridgeName << "\")]\n";
+			file << "private static extern ";
+		}
+
+		stubPart = StubPart::Types;
+		entity.generateReturnType(*this, true);
+
+		file << " AG_bridge_" << bridgeName << '(';
+		stubPart = StubPart::Declaration;
+		generateStorageParameter(entity);
+		entity.generateParameters(*this, true, true);
+		generateErrorParameter(entity);
+		stubPart = StubPart::None;
+		file << ");\n";
+	}
+
+	// The caller has the same signature that a marshalled bridge function would have.
+	file << "private static ";
+	entity.generateReturnType(*this, true);
+
+	file << bridgeName << '(';
+	generateStorageParameter(entity);
+	entity.generateParameters(*this, true, true);
+	file << ")\n{\n";
+
+	// The error slot is zeroed and only written to if an exception was caught.
+	if(entity.isThrowing())
+	{
+		ensureErrorHelpers();
+		file << "gencs.AG_Error AG_error = default;\n";
+	}
+
+	stubPart = StubPart::Prepare;
+	entity.generateParameters(*this, true, true);
+	stubPart = StubPart::None;
+
+	// Value types are returned as they are.
+	auto podReturn = entity.getReturnType(true);
+	auto returnType = podReturn.isPrimitive() ? podReturn.getPrimitiveType().getType() : PrimitiveEntity::Type::Void;
+
+	if(entity.returnsValue())
+	{
+		file << "return ";
+
+		if(returnType == PrimitiveEntity::Type::Character)
+		{
+			file << "(char)";
+		}
+
+		else if(podReturn.isCallable())
+		{
+			file << "gencs.AG_" << podReturn.getCallableType().getName() << ".FromNative(";
+		}
+	}
+
+	// The returned value is passed through the error check so that it's only used on success.
+	if(entity.isThrowing() && entity.returnsValue())
+	{
+		file << "gencs.AG_Error.Check(";
+	}
+
+	file << "AG_bridge_" << bridgeName << '(';
+	stubPart = StubPart::Arguments;
+	generateStorageParameter(entity);
+	entity.generateParameters(*this, true, true);
+	generateErrorParameter(entity);
+	stubPart = StubPart::None;
+	file << ')';
+
+	if(entity.isThrowing())
+	{
+		file << (entity.returnsValue() ? ", AG_error)" : ";\ngencs.AG_Error.Check(AG_error)");
+	}
+
+	if(entity.returnsValue() && returnType == PrimitiveEntity::Type::Boolean)
+	{
+		file << " != 0";
+	}
+
+	else if(entity.returnsValue() && returnType == PrimitiveEntity::Type::String)
+	{
+		file << ".Decode()";
+	}
+
+	// Borrowed buffers refer to the original elements which the span must not outlive.
+	else if(entity.returnsValue() && returnType == PrimitiveEntity::Type::Buffer)
+	{
+		file << (podReturn.isReference() ? ".AsSpan<" : ".ToArray<") << getBufferElement(podReturn) << ">()";
+	}
+
+	else if(entity.returnsValue() && podReturn.isCallable())
+	{
+		file << ')';
+	}
+
+	file << ";\n";
+
+	stubPart = StubPart::Cleanup;
+	entity.generateParameters(*this, true, true);
+	stubPart = StubPart::None;
+
+	file << "}\n";
+}
+
+void BindingGenerator::generateBridgePointerType(FunctionEntity& entity)
+{
+	file << "delegate* unmanaged[Cdecl" << (suppressesGCTransition(entity) ? ", SuppressGCTransition" : "") << "]<";
+
+	stubPart = StubPart::Types;
+	generateStorageParameter(entity);
+	entity.generateParameters(*this, true, true);
+	generateErrorParameter(entity);
+
+	if(entity.getParameterCount(true) > 0 || (inStorage && entity.getType() != FunctionEntity::Type::Destructor) ||
+		(entity.isThrowing() && !inIntercept))
+	{
+		file << ", ";
+	}
+
+	entity.generateReturnType(*this, true);
+	stubPart = StubPart::None;
+
+	file << '>';
+}
+
+void BindingGenerator::generateInterceptionContextStub(ClassEntity& entity)
+{
+	auto bridgeName = entity.getHierarchy() + "_AG_initializeInterceptionContext";
+
+	if(callMode == CallMode::LibraryImport)
+	{
+		generateLibraryImport(bridgeName, false);
+		file << "private static partial void AG_bridge_" << bridgeName <<
+				"(IntPtr ObjectHandle, IntPtr AG_foreignObject, ulong AG_overrides";
+		entity.generateInterceptionFunctions(*this);
+		file << ");\n";
+	}
+
+	else
+	{
+		file << "private static readonly delegate* unmanaged[Cdecl]<IntPtr, IntPtr, ulong";
+		stubPart = StubPart::Types;
+		entity.generateInterceptionFunctions(*this);
+		stubPart = StubPart::None;
+		file << ", void> AG_bridge_" << bridgeName << " = (delegate* unmanaged[Cdecl]<IntPtr, IntPtr, ulong";
+		stubPart = StubPart::Types;
+		entity.generateInterceptionFunctions(*this);
+		stubPart = StubPart::None;
+		file << ", void>)gencs.AG_BridgeTable.Get(" << getBridgeIndex(bridgeName) << ");\n";
+	}
+
+	file << "private static void " << bridgeName << "(IntPtr ObjectHandle, IntPtr AG_foreignObject, ulong AG_overrides";
+	entity.generateInterceptionFunctions(*this);
+	file << ")\n{\n";
+
+	file << "AG_bridge_" << bridgeName << "(ObjectHandle, AG_foreignObject, AG_overrides";
+	stubPart = StubPart::Arguments;
+	entity.generateInterceptionFunctions(*this);
+	stubPart = StubPart::None;
+	file << ");\n}\n";
+}
+
+void BindingGenerator::generateLibraryImport(const std::string& bridgeName, bool leaf)
+{
+	file << "[LibraryImport(\"" << libName << "\", EntryPoint = \"" << bridgeName << "\")]\n";
+	file << "[UnmanagedCallConv(CallConvs = new[] { typeof(System.Runtime.CompilerServices.CallConvCdecl) })]\n";
+
+	if(leaf)
+	{
+		file << "[SuppressGCTransition]\n";
+	}
+}
+
+bool BindingGenerator::suppressesGCTransition(FunctionEntity& entity)
+{
+	// Overridable functions might end up calling an override written in C#,
+	// which isn't allowed when the GC transition is suppressed.
+	return entity.isLeaf() && !entity.isOverridable() && !entity.isOverride();
+}
+
+size_t BindingGenerator::getBridgeIndex(const std::string& bridgeName)
+{
+	ensureBridgeTableLoader();
+
+	size_t index = getBackend().getBridgeTable().getIndex(bridgeName);
+	assert(index != BridgeTable::npos);
+
+	return index;
+}
+
+void BindingGenerator::finishGeneration()
+{
+	if(bridgeStats)
+	{
+		generateBridgeStats();
+	}
+}
+
+void BindingGenerator::generateBridgeStats()
+{
+	std::ofstream stats("gencs/BridgeStats.cs");
+
+	stats << "using System.Runtime.InteropServices;\n";
+	stats << "namespace gencs;\n";
+
+	// The reporting functions are exported even when the bridge functions are hidden.
+	stats << "public static class BridgeStats\n{\n";
+	stats << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
+	stats << "private static extern nuint AG_getBridgeCount();\n";
+	stats << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
+	stats << "private static extern IntPtr AG_getBridgeName(nuint index);\n";
+	stats << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
+	stats << "private static extern void AG_getBridgeStats([Out] ulong[] stats);\n";
+	stats << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
+	stats << "private static extern void AG_resetBridgeStats();\n";
+
+	// Latency bucket 0 counts calls shorter than 64 ns, and each following bucket
+	// doubles the limit. The last bucket counts every call from about 1 ms up.
+	stats << "public const int LatencyBuckets = 16;\n";
+	stats << "public readonly record struct Entry(string Name, ulong Calls, ulong[] Latencies);\n";
+	stats << "private static readonly string[] names = LoadNames();\n";
+
+	stats << "private static string[] LoadNames()\n{\n";
+	stats << "var result = new string[(int)AG_getBridgeCount()];\n";
+	stats << "for(int i = 0; i < result.Length; i++)\n{\n";
+	stats << "result[i] = Marshal.PtrToStringUTF8(AG_getBridgeName((nuint)i));\n}\n";
+	stats << "return result;\n}\n";
+
+	// Each entry of AG_BridgeStats is the call count followed by the latency buckets.
+	stats << "public static Entry[] Snapshot()\n{\n";
+	stats << "var counts = new ulong[names.Length * (LatencyBuckets + 1)];\n";
+	stats << "AG_getBridgeStats(counts);\n";
+	stats << "var result = new Entry[names.Length];\n";
+	stats << "for(int i = 0; i < result.Length; i++)\n{\n";
+	stats << "int offset = i * (LatencyBuckets + 1);\n";
+	stats << "result[i] = new Entry(names[i], counts[offset], counts[(offset + 1)..(offset + 1 + LatencyBuckets)]);\n}\n";
+	stats << "return result;\n}\n";
+
+	stats << "public static void Reset()\n{\n";
+	stats << "AG_resetBridgeStats();\n}\n";
+	stats << "}\n";
+}
+
+void BindingGenerator::ensureBridgeTableLoader()
+{
+	if(bridgeTableLoaderGenerated)
+	{
+		return;
+	}
+
+	bridgeTableLoaderGenerated = true;
+	auto& table = getBackend().getBridgeTable();
+
+	std::ofstream loader("gencs/AG_BridgeTable.cs");
+
+	loader << "using System.Runtime.InteropServices;\n";
+	loader << "namespace gencs;\n";
+
+	loader << "internal static unsafe class AG_BridgeTable\n{\n";
+	loader << "[DllImport(\"" << libName << "\", CallingConvention = CallingConvention.Cdecl)]\n";
+	loader << "private static extern IntPtr AG_getBridgeTable();\n";
+
+	loader << "private const uint Version = " << table.getVersion() << ";\n";
+	loader << "private const uint Count = " << table.getCount() << ";\n";
+	loader << "private static readonly IntPtr* bridges = Load();\n";
+
+	// The table starts with the version and the bridge count which are followed by the bridges.
+	loader << "private static IntPtr* Load()\n{\n";
+	loader << "uint* header = (uint*)AG_getBridgeTable();\n";
+	loader << "if(header[0] != Version || header[1] != Count)\n{\n";
+	loader << "throw new InvalidOperationException(\"The bridge table of " << libName <<
+			" doesn't match the generated bindings\");\n}\n";
+	loader << "return (IntPtr*)(header + 2);\n}\n";
+
+	loader << "public static IntPtr Get(int index)\n{\n";
+	loader << "return bridges[index];\n}\n";
+	loader << "}\n";
+}
+
+void BindingGenerator::ensureInterceptionHelper()
+{
+	if(interceptionHelperGenerated)
+	{
+		return;
+	}
+
+	interceptionHelperGenerated = true;
+	std::ofstream helper("gencs/AG_Interception.cs");
+
+	helper << "using System.Reflection;\n";
+	helper << "using System.Collections.Concurrent;\n";
+	helper << "namespace gencs;\n";
+
+	helper << "internal static class AG_Interception\n{\n";
+	helper << "private static readonly ConcurrentDictionary<(Type, Type), ulong> masks = new();\n";
+
+	// The mask is only computed once for each runtime type and generated class.
+	helper << "public static ulong GetOverrides(Type type, Type generated, string[] names)\n{\n";
+	helper << "return masks.GetOrAdd((type, generated), static (key, names) => Compute(key.Item1, key.Item2, names), names);\n}\n";
+
+	// A function is considered overridden when a class deriving the generated
+	// class declares a function of the same name.
+	helper << "private static ulong Compute(Type type, Type generated, string[] names)\n{\n";
+	helper << "ulong mask = 0;\n";
+	helper << "var methods = type.GetMethods(BindingFlags.Instance | BindingFlags.Public | BindingFlags.NonPublic);\n";
+	helper << "for(int i = 0; i < names.Length && i < 64; i++)\n{\n";
+	helper << "if(names[i] == null)\n{\n";
+	helper << "mask |= 1ul << i;\n";
+	helper << "continue;\n}\n";
+	helper << "foreach(var method in methods)\n{\n";
+	helper << "if(method.Name == names[i] && method.DeclaringType != generated && method.DeclaringType.IsSubclassOf(generated))\n{\n";
+	helper << "mask |= 1ul << i;\n";
+	helper << "break;\n}\n}\n}\n";
+	helper << "return mask;\n}\n";
+	helper << "}\n";
+}
+
+void BindingGenerator::ensureReturnBuffer()
+{
+	if(returnBufferGenerated)
+	{
+		return;
+	}
+
+	returnBufferGenerated = true;
+	std::ofstream helper("gencs/AG_ReturnBuffer.cs");
+
+	helper << "using System;\n";
+	helper << "using System.Runtime.InteropServices;\n";
+	helper << "namespace gencs;\n";
+
+	// Strings and buffers returned to the glue code are copied by it right away, so each
+	// thread reuses a single block of native memory for them. The block is freed once the
+	// thread has exited and the collector finalizes it.
+	helper << "internal sealed unsafe class AG_ReturnBuffer\n{\n";
+	helper << "[ThreadStatic]\nprivate static AG_ReturnBuffer current;\n";
+	helper << "private void* data;\n";
+	helper << "private nuint capacity;\n";
+
+	helper << "public static void* Reserve(nuint size)\n{\n";
+	helper << "if(current == null)\n{\n";
+	helper << "current = new AG_ReturnBuffer();\n}\n";
+	helper << "if(size > current.capacity || current.data == null)\n{\n";
+	helper << "current.capacity = Math.Max(size, 256);\n";
+	helper << "current.data = NativeMemory.Realloc(current.data, current.capacity);\n}\n";
+	helper << "return current.data;\n}\n";
+
+	helper << "~AG_ReturnBuffer()\n{\n";
+	helper << "NativeMemory.Free(data);\n}\n";
+	helper << "}\n";
+}
+
 bool BindingGenerator::hidesEntity(Entity& entity, Entity& containing)
 {
 	// The containing entity should only be a class.
@@ -1062,4 +2535,214 @@ bool BindingGenerator::hidesEntity(Entity& entity, Entity& containing)
 	return false;
 }
 
+void BindingGenerator::ensureViewHelpers()
+{
+	if(viewHelpersGenerated)
+	{
+		return;
+	}
+
+	viewHelpersGenerated = true;
+	ensureReturnBuffer();
+	std::ofstream helper("gencs/AG_Views.cs");
+
+	helper << "using System;\n";
+	helper << "using System.Runtime.InteropServices;\n";
+	helper << "namespace gencs;\n";
+
+	// The layout matches AG_String of the glue code.
+	helper << "[StructLayout(LayoutKind.Sequential)]\n";
+	helper << "internal unsafe struct AG_String\n{\n";
+	helper << "public byte* Data;\n";
+	helper << "public nuint Size;\n";
+
+	helper << "public AG_String(byte* data, int size)\n{\n";
+	helper << "Data = data;\n";
+	helper << "Size = (nuint)size;\n}\n";
+
+	// The length is known, so decoding doesn't have to look for the null terminator.
+	helper << "public string Decode()\n{\n";
+	helper << "return Data == null ? null : System.Text.Encoding.UTF8.GetString(Data, (int)Size);\n}\n";
+
+	// Returned strings are null terminated like the strings passed to the glue code.
+	helper << "public static AG_String Return(string value)\n{\n";
+	helper << "if(value == null)\n{\n";
+	helper << "return default;\n}\n";
+	helper << "int size = System.Text.Encoding.UTF8.GetByteCount(value);\n";
+	helper << "byte* data = (byte*)AG_ReturnBuffer.Reserve((nuint)size + 1);\n";
+	helper << "System.Text.Encoding.UTF8.GetBytes(value, new Span<byte>(data, size));\n";
+	helper << "data[size] = 0;\n";
+	helper << "return new AG_String(data, size);\n}\n";
+	helper << "}\n";
+
+	// The layout matches AG_Buffer of the glue code.
+	helper << "[StructLayout(LayoutKind.Sequential)]\n";
+	helper << "internal unsafe struct AG_Buffer\n{\n";
+	helper << "public void* Data;\n";
+	helper << "public nuint Size;\n";
+
+	helper << "public AG_Buffer(void* data, int size)\n{\n";
+	helper << "Data = data;\n";
+	helper << "Size = (nuint)size;\n}\n";
+
+	helper << "public Span<T> AsSpan<T>() where T : unmanaged\n{\n";
+	helper << "return new Span<T>(Data, (int)Size);\n}\n";
+
+	helper << "public T[] ToArray<T>() where T : unmanaged\n{\n";
+	helper << "return new ReadOnlySpan<T>(Data, (int)Size).ToArray();\n}\n";
+
+	helper << "public static AG_Buffer Return<T>(T[] value) where T : unmanaged\n{\n";
+	helper << "if(value == null)\n{\n";
+	helper << "return default;\n}\n";
+	helper << "void* data = AG_ReturnBuffer.Reserve((nuint)(value.Length * sizeof(T)));\n";
+	helper << "value.AsSpan().CopyTo(new Span<T>(data, value.Length));\n";
+	helper << "return new AG_Buffer(data, value.Length);\n}\n";
+	helper << "}\n";
+}
+
+void BindingGenerator::ensureAsyncHelpers()
+{
+	if(asyncHelpersGenerated)
+	{
+		return;
+	}
+
+	asyncHelpersGenerated = true;
+	std::ofstream helper("gencs/AG_Async.cs");
+
+	helper << "using System.Runtime.InteropServices;\n";
+	helper << "namespace gencs;\n";
+
+	// The context of an asynchronous call is a handle to its state, which is freed when the call
+	// completes. Tasks are completed on a native worker thread, so continuations are run asynchronously.
+	helper << "internal sealed class AG_Async<T>\n{\n";
+	helper << "private readonly TaskCompletionSource<T> source = new(TaskCreationOptions.RunContinuationsAsynchronously);\n";
+	helper << "private object owner;\n";
+
+	helper << "public static IntPtr Start(object owner, out Task<T> task)\n{\n";
+	helper << "var state = new AG_Async<T> { owner = owner };\n";
+	helper << "task = state.source.Task;\n";
+	helper << "return GCHandle.ToIntPtr(GCHandle.Alloc(state));\n}\n";
+
+	helper << "public static void Complete(IntPtr context, IntPtr error, T result)\n{\n";
+	helper << "var handle = GCHandle.FromIntPtr(context);\n";
+	helper << "var state = (AG_Async<T>)handle.Target;\n";
+	helper << "handle.Free();\n";
+	helper << "GC.KeepAlive(state.owner);\n";
+	helper << "if(error != IntPtr.Zero)\n{\n";
+	helper << "state.source.SetException(new InvalidOperationException(Marshal.PtrToStringUTF8(error)));\n}\n";
+	helper << "else\n{\n";
+	helper << "state.source.SetResult(result);\n}\n}\n";
+	helper << "}\n";
+}
+
+void BindingGenerator::ensureErrorHelpers()
+{
+	if(errorHelpersGenerated)
+	{
+		return;
+	}
+
+	errorHelpersGenerated = true;
+	std::ofstream helper("gencs/AG_Error.cs");
+
+	helper << "using System.Runtime.InteropServices;\n";
+	helper << "namespace gencs;\n";
+
+	// The error slot that potentially throwing bridge functions write a caught exception to.
+	// The kind tells which C++ exception was caught, and the message stays valid until
+	// the next exception on the same thread.
+	helper << "[StructLayout(LayoutKind.Sequential)]\n";
+	helper << "internal struct AG_Error\n{\n";
+	helper << "public int kind;\n";
+	helper << "public IntPtr message;\n";
+
+	helper << "public static void Check(in AG_Error error)\n{\n";
+	helper << "if(error.kind != 0)\n{\nthrow error.ToException();\n}\n}\n";
+
+	helper << "public static T Check<T>(T result, in AG_Error error)\n{\n";
+	helper << "if(error.kind != 0)\n{\nthrow error.ToException();\n}\n";
+	helper << "return result;\n}\n";
+
+	helper << "private readonly Exception ToException()\n{\n";
+	helper << "var text = Marshal.PtrToStringUTF8(message);\n";
+	helper << "return kind switch\n{\n";
+	helper << "2 => new ArgumentException(text),\n";
+	helper << "3 => new ArgumentOutOfRangeException(null, text),\n";
+	helper << "4 => new OutOfMemoryException(text),\n";
+	helper << "_ => new InvalidOperationException(text)\n};\n}\n";
+	helper << "}\n";
+}
+
+void BindingGenerator::ensureCallableHelpers()
+{
+	if(callableHelpersGenerated)
+	{
+		return;
+	}
+
+	callableHelpersGenerated = true;
+	std::ofstream helper("gencs/AG_Callable.cs");
+
+	helper << "using System.Runtime.InteropServices;\n";
+	helper << "namespace gencs;\n";
+
+	// The layout matches AG_Callable of the glue code.
+	helper << "[StructLayout(LayoutKind.Sequential)]\n";
+	helper << "internal struct AG_Callable\n{\n";
+	helper << "public IntPtr Invoke;\n";
+	helper << "public IntPtr Context;\n";
+	helper << "public IntPtr Release;\n";
+
+	helper << "public AG_Callable(IntPtr invoke, IntPtr context, IntPtr release)\n{\n";
+	helper << "Invoke = invoke;\n";
+	helper << "Context = context;\n";
+	helper << "Release = release;\n}\n";
+	helper << "}\n";
+
+	// Passing the same delegate again reuses its handle, which is
+	// freed once the glue code has released every copy of it.
+	helper << "internal static unsafe class AG_CallablePool\n{\n";
+	helper << "private sealed class Entry\n{\n";
+	helper << "public GCHandle Handle;\n";
+	helper << "public int Count;\n}\n";
+
+	helper << "private static readonly Dictionary<Delegate, Entry> entries = new(ReferenceEqualityComparer.Instance);\n";
+	helper << "public static readonly IntPtr Releaser = (IntPtr)(delegate* unmanaged[Cdecl]<IntPtr, void>)&Release;\n";
+
+	helper << "public static IntPtr Acquire(Delegate value)\n{\n";
+	helper << "lock(entries)\n{\n";
+	helper << "if(!entries.TryGetValue(value, out var entry))\n{\n";
+	helper << "entry = new Entry { Handle = GCHandle.Alloc(value) };\n";
+	helper << "entries.Add(value, entry);\n}\n";
+	helper << "entry.Count++;\n";
+	helper << "return GCHandle.ToIntPtr(entry.Handle);\n}\n}\n";
+
+	helper << "[UnmanagedCallersOnly(CallConvs = new[] { typeof(System.Runtime.CompilerServices.CallConvCdecl) })]\n";
+	helper << "private static void Release(IntPtr context)\n{\n";
+	helper << "lock(entries)\n{\n";
+	helper << "var handle = GCHandle.FromIntPtr(context);\n";
+	helper << "var value = (Delegate)handle.Target;\n";
+	helper << "if(--entries[value].Count == 0)\n{\n";
+	helper << "entries.Remove(value);\n";
+	helper << "handle.Free();\n}\n}\n}\n";
+	helper << "}\n";
+
+	// Callables returned by the glue code own their context until they are collected.
+	helper << "internal sealed unsafe class AG_NativeCallable\n{\n";
+	helper << "public readonly IntPtr Invoke;\n";
+	helper << "public readonly IntPtr Context;\n";
+	helper << "private readonly IntPtr release;\n";
+
+	helper << "public AG_NativeCallable(AG_Callable value)\n{\n";
+	helper << "Invoke = value.Invoke;\n";
+	helper << "Context = value.Context;\n";
+	helper << "release = value.Release;\n}\n";
+
+	helper << "~AG_NativeCallable()\n{\n";
+	helper << "if(release != IntPtr.Zero)\n{\n";
+	helper << "((delegate* unmanaged[Cdecl]<IntPtr, void>)release)(Context);\n}\n}\n";
+	helper << "}\n";
+}
+
 }
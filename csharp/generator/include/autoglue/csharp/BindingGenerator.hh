@@ -14,13 +14,61 @@ namespace ag::csharp
 class BindingGenerator : public ag::BindingGenerator
 {
 public:
+	/// CallMode determines how the generated bindings call the bridge functions.
+	/// The generated classes are unsafe in every mode since interception, asynchronous
+	/// calls and strings use unmanaged function pointers and pointers, so the project
+	/// has to allow unsafe blocks.
+	enum class CallMode
+	{
+		/// Each bridge function is looked up by name with DllImport.
+		DllImport,
+
+		/// The bridge functions are called through unmanaged function pointers that
+		/// are read once from the table returned by AG_getBridgeTable.
+		BridgeTable,
+
+		/// Each bridge function is imported with a blittable LibraryImport signature
+		/// whose stub is generated at compile time. The generated classes are partial.
+		LibraryImport
+	};
+
 	BindingGenerator(ag::Backend& backend, std::string_view libName);
 
+	/// Sets how the generated bindings call the bridge functions.
+	///
+	/// \param mode The call mode to use.
+	void setCallMode(CallMode mode);
+
+	/// Sets whether bridge functions imported with DllImport should have blittable
+	/// signatures. Booleans are then passed as bytes and object handles as nint,
+	/// and the conversions happen in the generated C# code. The other call modes
+	/// always do this, as do functions passing strings in any mode.
+	///
+	/// \param value If true, DllImport signatures are blittable.
+	void setBlittableSignatures(bool value);
+
+	/// Sets whether object handles returned by the glue code are wrapped through an
+	/// identity cache. Each class then keeps a weak map from object handles to the
+	/// objects wrapping them, so that the same native object is always represented
+	/// by the same C# object while it's reachable.
+	///
+	/// \param value If true, the identity cache is used.
+	void setIdentityCache(bool value);
+
+	/// Sets whether gencs.BridgeStats is generated. It reads the call counts and the
+	/// latency histograms of the bridge functions, so the glue code has to be generated
+	/// with ag::clang::GlueOptions::callCounters set.
+	///
+	/// \param value If true, gencs.BridgeStats is generated.
+	void setBridgeStats(bool value);
+
 private:
 	void generateClass(ClassEntity& entity) override;
 	void generateEnum(EnumEntity& entity) override;
 	void generateEnumEntry(EnumEntryEntity& entity) override;
+	void generateCallableType(CallableTypeEntity& entity) override;
 	void generateFunction(FunctionEntity& entity) override;
+	void generateField(FieldEntity& entity) override;
 	void generateTypeReference(TypeReferenceEntity& entity) override;
 	void generateTypeAlias(TypeAliasEntity& entity) override;
 	bool generateBaseType(TypeEntity& entity, size_t index) override;
@@ -32,6 +80,7 @@ private:
 	void generateInterceptionContext(ClassEntity& entity) override;
 	std::string_view getObjectHandleName() override;
 	void initializeGenerationContext(Entity& entity) override;
+	void finishGeneration() override;
 
 	bool hidesEntity(Entity& entity, Entity& containing);
 	bool generateBridgeToCSharp(TypeReferenceEntity& entity);
@@ -39,6 +88,154 @@ private:
 
 	void openFile(TypeEntity& entity);
 
+	/// Generates a struct that has the same layout as the given value type.
+	///
+	/// \param entity The value type to generate a struct for.
+	void generateValueType(ClassEntity& entity);
+
+	/// Generates the identity cache of a class and AG_wrap which looks objects up from it.
+	///
+	/// \param entity The class to generate the identity cache for.
+	void generateIdentityCache(ClassEntity& entity);
+
+	/// Generates the import of a bridge function in the current call mode.
+	///
+	/// \param entity The function to import the bridge function of.
+	void generateBridgeImport(FunctionEntity& entity);
+
+	/// Generates static methods that call a batched function for an array of objects
+	/// with a single call to the batched bridge function.
+	///
+	/// \param entity The batched function to generate the methods for.
+	void generateBatchedFunction(FunctionEntity& entity);
+
+	/// Generates a method returning a task that is completed once the asynchronous
+	/// bridge function has called the function on a native worker thread.
+	///
+	/// \param entity The asynchronous function to generate the method for.
+	void generateAsyncFunction(FunctionEntity& entity);
+
+	/// Generates the overload that returns an object to caller provided storage,
+	/// or destroyInPlace if the function is the destructor of a storable class.
+	///
+	/// \param entity The function that has a storage bridge function.
+	void generateStorageFunction(FunctionEntity& entity);
+
+	/// Generates the storage parameter of a storage bridge function in the current stub part.
+	///
+	/// \param entity The function whose storage bridge function is called.
+	void generateStorageParameter(FunctionEntity& entity);
+
+	/// Generates the error slot parameter of a potentially throwing bridge function in the current stub part.
+	///
+	/// \param entity The function whose bridge function is called.
+	void generateErrorParameter(FunctionEntity& entity);
+
+	/// Gets the name of the bridge function that is currently being called.
+	///
+	/// \param entity The function to get the bridge function name of.
+	/// \return The name of the storage bridge function when generating one, or the bridge function otherwise.
+	std::string getBridgeName(FunctionEntity& entity);
+
+	/// Generates a function that calls a bridge function from the bridge table.
+	///
+	/// \param entity The function to generate the bridge function caller for.
+	void generateBridgeStub(FunctionEntity& entity);
+
+	/// Generates the unmanaged function pointer type of a bridge function.
+	///
+	/// \param entity The function to generate the function pointer type for.
+	void generateBridgePointerType(FunctionEntity& entity);
+
+	/// Generates the attributes for a bridge function imported with LibraryImport.
+	///
+	/// \param bridgeName The name of the imported bridge function.
+	/// \param leaf If true, the bridge function is called without a GC transition.
+	void generateLibraryImport(const std::string& bridgeName, bool leaf);
+
+	/// Checks whether a bridge function can be called without a GC transition.
+	///
+	/// \param entity The function to check.
+	/// \return True if the GC transition can be suppressed.
+	bool suppressesGCTransition(FunctionEntity& entity);
+
+	/// Generates a bridge function caller for the interception context initialization.
+	///
+	/// \param entity The class to generate the bridge function caller for.
+	void generateInterceptionContextStub(ClassEntity& entity);
+
+	/// Generates the parameter names of an interception function as arguments
+	/// that follow the target object.
+	///
+	/// \param entity The intercepted function.
+	void generateInterceptionArguments(FunctionEntity& entity);
+
+	/// Checks whether bridge functions are called through generated callers
+	/// that convert the parameters to blittable types.
+	///
+	/// \return True if bridge functions are called through generated callers.
+	bool usesBridgeStubs();
+
+	/// Gets the index of a bridge function within the bridge table.
+	///
+	/// \param bridgeName The name of the bridge function.
+	/// \return The index of the bridge function.
+	size_t getBridgeIndex(const std::string& bridgeName);
+
+	/// Generates gencs.BridgeStats which reads the call counters of the glue code.
+	void generateBridgeStats();
+
+	/// Ensures that the class reading the bridge table is generated.
+	void ensureBridgeTableLoader();
+
+	/// Ensures that the class holding values returned to the glue code is generated.
+	void ensureReturnBuffer();
+
+	/// Ensures that the class finding out which interception functions
+	/// are overridden is generated.
+	void ensureInterceptionHelper();
+
+	/// Ensures that the structs representing strings and buffers
+	/// passed to and from the glue code are generated.
+	void ensureViewHelpers();
+
+	/// Ensures that AG_Callable and the classes managing the
+	/// lifetime of passed callables are generated.
+	void ensureCallableHelpers();
+
+	/// Ensures that the class completing the tasks of asynchronous calls is generated.
+	void ensureAsyncHelpers();
+
+	/// Ensures that the error slot translating exceptions caught by the glue code is generated.
+	void ensureErrorHelpers();
+
+	/// Used to generate the parts of bridge function callers.
+	enum class StubPart
+	{
+		None,
+		Types,
+		Declaration,
+		Arguments,
+		Prepare,
+		Cleanup
+	};
+
+	/// Strings that fit in this many bytes are encoded on the stack.
+	static constexpr size_t stackStringSize = 256;
+
+	CallMode callMode = CallMode::DllImport;
+	bool blittableSignatures = false;
+	bool identityCache = false;
+	bool bridgeStats = false;
+	StubPart stubPart = StubPart::None;
+	bool bridgeTableLoaderGenerated = false;
+	bool returnBufferGenerated = false;
+	bool interceptionHelperGenerated = false;
+	bool viewHelpersGenerated = false;
+	bool callableHelpersGenerated = false;
+	bool asyncHelpersGenerated = false;
+	bool errorHelpersGenerated = false;
+
 	std::ofstream file;
 	std::string libName;
 
@@ -47,9 +244,13 @@ private:
 	/// Used to only write parameter names when a bridge function is called.
 	bool onlyParameterNames = false;
 
+	/// Used to pass the parameters of an interception function as they are.
 	bool delegateInterception = false;
-	bool convertStringType = false;
 	bool inIntercept = false;
+	bool listInterceptedNames = false;
+
+	/// Used to call the storage bridge function of a function.
+	bool inStorage = false;
 
 	std::shared_ptr <ClassEntity> compositionBaseTarget;
 	bool inBaseInitialization = false;
@@ -3,11 +3,14 @@
 #include <autoglue/TypeAliasEntity.hh>
 #include <autoglue/FunctionGroupEntity.hh>
 #include <autoglue/FunctionEntity.hh>
+#include <autoglue/FieldEntity.hh>
+#include <autoglue/CallableTypeEntity.hh>
 #include <autoglue/ClassEntity.hh>
 #include <autoglue/EnumEntity.hh>
 #include <autoglue/EnumEntryEntity.hh>
 #include <autoglue/TypeEntity.hh>
 #include <autoglue/ScopeEntity.hh>
+#include <autoglue/BridgeTable.hh>
 
 #include <algorithm>
 #include <filesystem>
@@ -54,21 +57,857 @@ static std::string getFunctionNameJNI(FunctionEntity& entity)
 	return getEntityPathJNI(entity.getParent()) + "_" + getEscapedNameJNI(entity.getBridgeName(true));
 }
 
+static std::string getClassPathJNI(Entity& entity)
+{
+	// Once a non-class entity is found, return its path as a directory hierarchy.
+	if(entity.getType() != Entity::Type::Type)
+	{
+		return entity.getHierarchy("/");
+	}
+
+	auto parentPath = getClassPathJNI(entity.getParent());
+	if(parentPath.empty())
+	{
+		return entity.getName();
+	}
+
+	// Nested classes are separated with "$".
+	return parentPath + (entity.getParent().getType() == Entity::Type::Type ? "$" : "/") + entity.getName();
+}
+
+static const char* getArrayNameJNI(PrimitiveEntity::Type element)
+{
+	switch(element)
+	{
+		case PrimitiveEntity::Type::Integer: return "Int";
+		case PrimitiveEntity::Type::Float: return "Float";
+		case PrimitiveEntity::Type::Double: return "Double";
+
+		// C++ char is a single byte unlike Java char.
+		case PrimitiveEntity::Type::Character: return "Byte";
+		default: {}
+	}
+
+	return "";
+}
+
+static std::string getArrayTypeJNI(PrimitiveEntity::Type element)
+{
+	std::string name = getArrayNameJNI(element);
+	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+	return 'j' + name + "Array";
+}
+
+static const char* getBatchedElementJava(PrimitiveEntity::Type type)
+{
+	switch(type)
+	{
+		case PrimitiveEntity::Type::Integer: return "int";
+		case PrimitiveEntity::Type::Float: return "float";
+		case PrimitiveEntity::Type::Double: return "double";
+		default: {}
+	}
+
+	return "";
+}
+
+static PrimitiveEntity::Type getBatchedElement(TypeReferenceEntity& entity)
+{
+	return entity.getAsPOD().getPrimitiveType().getType();
+}
+
+static const char* getBoxedNameJava(PrimitiveEntity::Type type)
+{
+	switch(type)
+	{
+		case PrimitiveEntity::Type::Integer: case PrimitiveEntity::Type::UInt32: return "Integer";
+		case PrimitiveEntity::Type::Int8: case PrimitiveEntity::Type::UInt8: return "Byte";
+		case PrimitiveEntity::Type::Int16: case PrimitiveEntity::Type::UInt16: return "Short";
+		case PrimitiveEntity::Type::Int64: case PrimitiveEntity::Type::UInt64: return "Long";
+		case PrimitiveEntity::Type::IntPtr: case PrimitiveEntity::Type::UIntPtr: return "Long";
+		case PrimitiveEntity::Type::Character: return "Character";
+		case PrimitiveEntity::Type::Boolean: return "Boolean";
+		case PrimitiveEntity::Type::Float: return "Float";
+		case PrimitiveEntity::Type::Double: return "Double";
+		case PrimitiveEntity::Type::Void: return "Void";
+		default: {}
+	}
+
+	return "";
+}
+
+static bool isValueType(TypeReferenceEntity& entity)
+{
+	return entity.getType() == TypeEntity::Type::Class && entity.getClassType().isValueType();
+}
+
+static std::string getValueNameJNI(ClassEntity& entity)
+{
+	return "AG_Value_" + entity.getHierarchy("_");
+}
+
+static const char* getPrimitiveNameJNI(PrimitiveEntity::Type type, bool external)
+{
+	switch(type)
+	{
+		case PrimitiveEntity::Type::ObjectHandle: return external ? "void*" : "jlong";
+		case PrimitiveEntity::Type::Integer: return external ? "int" : "jint";
+		case PrimitiveEntity::Type::Int8: return external ? "int8_t" : "jbyte";
+		case PrimitiveEntity::Type::Int16: return external ? "int16_t" : "jshort";
+		case PrimitiveEntity::Type::Int64: return external ? "int64_t" : "jlong";
+		case PrimitiveEntity::Type::UInt8: return external ? "uint8_t" : "jbyte";
+		case PrimitiveEntity::Type::UInt16: return external ? "uint16_t" : "jshort";
+		case PrimitiveEntity::Type::UInt32: return external ? "uint32_t" : "jint";
+		case PrimitiveEntity::Type::UInt64: return external ? "uint64_t" : "jlong";
+		case PrimitiveEntity::Type::IntPtr: return external ? "intptr_t" : "jlong";
+		case PrimitiveEntity::Type::UIntPtr: return external ? "uintptr_t" : "jlong";
+		case PrimitiveEntity::Type::Character: return external ? "char" : "jchar";
+		case PrimitiveEntity::Type::Boolean: return external ? "bool" : "jboolean";
+		case PrimitiveEntity::Type::Float: return external ? "float" : "jfloat";
+		case PrimitiveEntity::Type::Double: return external ? "double" : "jdouble";
+		case PrimitiveEntity::Type::Void: return "void";
+		case PrimitiveEntity::Type::String: return external ? "AG_String" : "jstring";
+
+		// Java arrays depend on the element type.
+		case PrimitiveEntity::Type::Buffer: return external ? "AG_Buffer" : "";
+	}
+
+	return "";
+}
+
+static const char* getByteBufferGetter(PrimitiveEntity::Type type)
+{
+	switch(type)
+	{
+		case PrimitiveEntity::Type::Int8: case PrimitiveEntity::Type::UInt8: return "get";
+		case PrimitiveEntity::Type::Int16: case PrimitiveEntity::Type::UInt16: return "getShort";
+		case PrimitiveEntity::Type::Integer: case PrimitiveEntity::Type::UInt32: return "getInt";
+		case PrimitiveEntity::Type::Int64: case PrimitiveEntity::Type::UInt64: return "getLong";
+		case PrimitiveEntity::Type::IntPtr: case PrimitiveEntity::Type::UIntPtr: return "getLong";
+		case PrimitiveEntity::Type::Float: return "getFloat";
+		case PrimitiveEntity::Type::Double: return "getDouble";
+		default: {}
+	}
+
+	return "";
+}
+
+static const char* getCallNameJNI(PrimitiveEntity::Type type)
+{
+	switch(type)
+	{
+		case PrimitiveEntity::Type::Integer: case PrimitiveEntity::Type::UInt32: return "Int";
+		case PrimitiveEntity::Type::Int8: case PrimitiveEntity::Type::UInt8: return "Byte";
+		case PrimitiveEntity::Type::Int16: case PrimitiveEntity::Type::UInt16: return "Short";
+		case PrimitiveEntity::Type::Int64: case PrimitiveEntity::Type::UInt64: return "Long";
+		case PrimitiveEntity::Type::IntPtr: case PrimitiveEntity::Type::UIntPtr: return "Long";
+		case PrimitiveEntity::Type::Character: return "Char";
+		case PrimitiveEntity::Type::Boolean: return "Boolean";
+		case PrimitiveEntity::Type::Float: return "Float";
+		case PrimitiveEntity::Type::Double: return "Double";
+		case PrimitiveEntity::Type::Void: return "Void";
+		default: {}
+	}
+
+	return "";
+}
+
+static const char* getViewTypeJava(PrimitiveEntity::Type element)
+{
+	switch(element)
+	{
+		case PrimitiveEntity::Type::Integer: return "java.nio.IntBuffer";
+		case PrimitiveEntity::Type::Float: return "java.nio.FloatBuffer";
+		case PrimitiveEntity::Type::Double: return "java.nio.DoubleBuffer";
+		case PrimitiveEntity::Type::Character: return "java.nio.ByteBuffer";
+		default: {}
+	}
+
+	return "";
+}
+
+static bool isBorrowedBuffer(TypeReferenceEntity& entity)
+{
+	// Only return types can be borrowed buffers.
+	return entity.getName().empty() && entity.isReference() && entity.isPrimitive() &&
+			entity.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer;
+}
+
+static std::string getTypeDescriptorJNI(TypeReferenceEntity& entity, const std::string& packagePath)
+{
+	auto pod = entity.getAsPOD();
+
+	// Callables are passed as the Java object implementing the functional interface.
+	if(pod.getType() == TypeEntity::Type::Callable)
+	{
+		return 'L' + packagePath + '/' + pod.getReferred().getName() + ';';
+	}
+
+	// Value types are passed to Java as their fields.
+	if(isValueType(pod))
+	{
+		std::string descriptor;
+		auto& value = pod.getClassType();
+
+		for(size_t i = 0; i < value.getValueFieldCount(); i++)
+		{
+			TypeReferenceEntity field(value.getValueField(i).name, value.getValueField(i).type, false);
+			descriptor += getTypeDescriptorJNI(field, packagePath);
+		}
+
+		return descriptor;
+	}
+
+	switch(pod.getPrimitiveType().getType())
+	{
+		case PrimitiveEntity::Type::Buffer:
+		{
+			switch(pod.getPrimitiveType().getElementType())
+			{
+				case PrimitiveEntity::Type::Integer: return "[I";
+				case PrimitiveEntity::Type::Float: return "[F";
+				case PrimitiveEntity::Type::Double: return "[D";
+				case PrimitiveEntity::Type::Character: return "[B";
+				default: return "";
+			}
+		}
+
+		case PrimitiveEntity::Type::ObjectHandle: return "J";
+		case PrimitiveEntity::Type::Integer: return "I";
+
+		// Java has no unsigned integers, so they are passed as signed integers of the same width.
+		case PrimitiveEntity::Type::Int8: case PrimitiveEntity::Type::UInt8: return "B";
+		case PrimitiveEntity::Type::Int16: case PrimitiveEntity::Type::UInt16: return "S";
+		case PrimitiveEntity::Type::UInt32: return "I";
+		case PrimitiveEntity::Type::Int64: case PrimitiveEntity::Type::UInt64: return "J";
+		case PrimitiveEntity::Type::IntPtr: case PrimitiveEntity::Type::UIntPtr: return "J";
+
+		case PrimitiveEntity::Type::Character: return "C";
+		case PrimitiveEntity::Type::Boolean: return "Z";
+		case PrimitiveEntity::Type::Float: return "F";
+		case PrimitiveEntity::Type::Double: return "D";
+		case PrimitiveEntity::Type::String: return "Ljava/lang/String;";
+		case PrimitiveEntity::Type::Void: return "V";
+	}
+
+	return "";
+}
+
+static std::string getMethodDescriptorJNI(FunctionEntity& entity, const std::string& packagePath, bool storage = false)
+{
+	// Storage for returned objects is passed as a direct byte buffer.
+	std::string descriptor(storage ? "(Ljava/nio/ByteBuffer;" : "(");
+
+	// Object handles are passed as longs.
+	if(entity.needsThisHandle())
+	{
+		descriptor += 'J';
+	}
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		descriptor += getTypeDescriptorJNI(entity.getParameter(i), packagePath);
+	}
+
+	// Value types are returned to Java as the bytes of their mirror struct,
+	// and callables as the fields of AG_Callable.
+	auto returnType = entity.getReturnType(true);
+	if(isValueType(returnType))
+	{
+		return descriptor + ")[B";
+	}
+
+	if(returnType.getType() == TypeEntity::Type::Callable)
+	{
+		return descriptor + ")[J";
+	}
+
+	// Borrowed buffers are returned as direct byte buffers.
+	if(isBorrowedBuffer(returnType))
+	{
+		return descriptor + ")Ljava/nio/ByteBuffer;";
+	}
+
+	return descriptor + ')' + getTypeDescriptorJNI(returnType, packagePath);
+}
+
 BindingGenerator::BindingGenerator(Backend& backend, std::string_view packagePrefix)
-	: ag::BindingGenerator(backend), jni("jni_glue.cpp"), packagePrefix(packagePrefix)
+	: BindingGenerator(backend, packagePrefix, true)
+{
+}
+
+BindingGenerator::BindingGenerator(Backend& backend, std::string_view packagePrefix, bool jniGlue)
+	: ag::BindingGenerator(backend), packagePrefix(packagePrefix)
 {
 	// Create a directory to put the java classes in.
 	std::filesystem::remove_all(this->packagePrefix);
 	std::filesystem::create_directory(this->packagePrefix);
 	package.emplace(this->packagePrefix);
 
+	if(!jniGlue)
+	{
+		return;
+	}
+
+	flattenValues = true;
+
+	jni.open("jni_glue.cpp");
 	jni << "#include <jni.h>\n";
+	jni << "#include <cstddef>\n";
+	jni << "#include <cstdint>\n";
+	jni << "#include <cstring>\n";
+	jni << "#include <string>\n";
+	jni << "#include <vector>\n";
+
+	// Strings are passed to and from the glue code as UTF-8 data and its length.
+	jni << "#ifndef AG_STRING_DEFINED\n";
+	jni << "#define AG_STRING_DEFINED\n";
+	jni << "struct AG_String\n{\nconst char* data;\nsize_t size;\n};\n";
+	jni << "#endif\n";
+
+	// Buffers are passed as a pointer to their elements and the count of elements.
+	jni << "#ifndef AG_BUFFER_DEFINED\n";
+	jni << "#define AG_BUFFER_DEFINED\n";
+	jni << "struct AG_Buffer\n{\nvoid* data;\nsize_t size;\n};\n";
+	jni << "#endif\n";
+
+	// Callables are passed as a trampoline, the context it is called with and a function releasing the context.
+	jni << "#ifndef AG_CALLABLE_DEFINED\n";
+	jni << "#define AG_CALLABLE_DEFINED\n";
+	jni << "struct AG_Callable\n{\nvoid* invoke;\nvoid* context;\nvoid (*release)(void*);\n};\n";
+	jni << "#endif\n";
+
+	// Potentially throwing bridge functions report caught exceptions through an error slot.
+	jni << "#ifndef AG_ERROR_DEFINED\n";
+	jni << "#define AG_ERROR_DEFINED\n";
+	jni << "struct AG_Error\n{\nint32_t kind;\nconst char* message;\n};\n";
+	jni << "#endif\n";
+
+	// The error slot is checked once the call and the conversion of its result are done,
+	// and a reported exception is thrown in Java when the native method returns.
+	jni << "struct JavaError\n{\npublic:\n";
+	jni << "JavaError(JNIEnv* env) : env(env) {}\n";
+	jni << "~JavaError()\n{\n";
+	jni << "if(error.kind == 0) { return; }\n";
+	jni << "const char* type = \"java/lang/RuntimeException\";\n";
+	jni << "if(error.kind == 2) { type = \"java/lang/IllegalArgumentException\"; }\n";
+	jni << "else if(error.kind == 3) { type = \"java/lang/IndexOutOfBoundsException\"; }\n";
+	jni << "else if(error.kind == 4) { type = \"java/lang/OutOfMemoryError\"; }\n";
+	jni << "env->ThrowNew(env->FindClass(type), error.message);\n}\n";
+	jni << "AG_Error error {};\n\n";
+	jni << "private:\n";
+	jni << "JNIEnv* env;\n};\n";
+
+	// Java strings aren't stored as UTF-8, so they have to be converted. Short strings
+	// are converted on the stack so that passing them doesn't allocate.
+	jni << "struct JavaString\n{\npublic:\n";
+	jni << "JavaString(JNIEnv* env, jstring value) : buffer(stackBuffer)\n{\n";
+	jni << "if(!value) { view = { nullptr, 0 }; return; }\n";
+	jni << "jsize size = env->GetStringUTFLength(value);\n";
+	jni << "if(size >= static_cast <jsize> (sizeof(stackBuffer))) { buffer = new char[size + 1]; }\n";
+	jni << "env->GetStringUTFRegion(value, 0, env->GetStringLength(value), buffer);\n";
+	jni << "buffer[size] = 0;\n";
+	jni << "view = { buffer, static_cast <size_t> (size) };\n}\n";
+	jni << "~JavaString() { if(buffer != stackBuffer) { delete[] buffer; } }\n";
+	jni << "AG_String view;\n";
+	jni << "char stackBuffer[" << stackStringSize << "];\n";
+	jni << "char* buffer;\n};\n";
+
+	// NewStringUTF needs a null terminated string which the returned view might not be.
+	jni << "static jstring toJavaString(JNIEnv* env, AG_String value)\n{\n";
+	jni << "if(!value.data) { return nullptr; }\n";
+	jni << "if(value.size < " << stackStringSize << ")\n{\n";
+	jni << "char buffer[" << stackStringSize << "];\n";
+	jni << "memcpy(buffer, value.data, value.size);\n";
+	jni << "buffer[value.size] = 0;\n";
+	jni << "return env->NewStringUTF(buffer);\n}\n";
+	jni << "return env->NewStringUTF(std::string(value.data, value.size).c_str());\n}\n";
+
+	// Buffers refer to the elements of Java arrays. Leaf functions access the elements
+	// directly in a critical region, and other functions get the elements with a
+	// function that is allowed to copy them since they might call back into Java.
+	for(auto element : { PrimitiveEntity::Type::Integer, PrimitiveEntity::Type::Float,
+						PrimitiveEntity::Type::Double, PrimitiveEntity::Type::Character })
+	{
+		std::string name = getArrayNameJNI(element);
+		std::string type = getArrayTypeJNI(element);
+		std::string elementType = type.substr(0, type.size() - 5);
+
+		jni << "static void* getElements(JNIEnv* env, " << type << " array) { return env->Get" <<
+				name << "ArrayElements(array, nullptr); }\n";
+		jni << "static void releaseElements(JNIEnv* env, " << type << " array, void* elements) { env->Release" <<
+				name << "ArrayElements(array, static_cast <" << elementType << "*> (elements), 0); }\n";
+
+		jni << "static " << type << " toJava" << name << "Array(JNIEnv* env, AG_Buffer value)\n{\n";
+		jni << type << " array = env->New" << name << "Array(static_cast <jsize> (value.size));\n";
+		jni << "env->Set" << name << "ArrayRegion(array, 0, static_cast <jsize> (value.size), static_cast <const " <<
+				elementType << "*> (value.data));\n";
+		jni << "return array;\n}\n";
+	}
+
+	// Borrowed buffers are returned as direct byte buffers that refer to the original elements.
+	jni << "template <typename T>\n";
+	jni << "static jobject toJavaView(JNIEnv* env, AG_Buffer value)\n{\n";
+	jni << "return value.data ? env->NewDirectByteBuffer(value.data, static_cast <jlong> (value.size * sizeof(T))) : nullptr;\n}\n";
+
+	jni << "template <typename Array>\n";
+	jni << "struct JavaArray\n{\npublic:\n";
+	jni << "JavaArray(JNIEnv* env, Array value, bool critical) : env(env), array(value), critical(critical)\n{\n";
+	jni << "view = { nullptr, 0 };\n";
+	jni << "if(!value) { return; }\n";
+	jni << "view.size = static_cast <size_t> (env->GetArrayLength(value));\n";
+	jni << "view.data = critical ? env->GetPrimitiveArrayCritical(value, nullptr) : getElements(env, value);\n}\n";
+	jni << "~JavaArray()\n{\n";
+	jni << "if(!view.data) { return; }\n";
+	jni << "if(critical) { env->ReleasePrimitiveArrayCritical(array, view.data, 0); }\n";
+	jni << "else { releaseElements(env, array, view.data); }\n}\n";
+	jni << "AG_Buffer view;\n";
+	jni << "JNIEnv* env;\nArray array;\nbool critical;\n};\n";
+
+	// Value types are returned as the bytes of their mirror struct which Java decodes.
+	jni << "template <typename T>\n";
+	jni << "static jbyteArray toJavaValue(JNIEnv* env, const T& value)\n{\n";
+	jni << "jbyteArray array = env->NewByteArray(static_cast <jsize> (sizeof(T)));\n";
+	jni << "env->SetByteArrayRegion(array, 0, static_cast <jsize> (sizeof(T)), reinterpret_cast <const jbyte*> (&value));\n";
+	jni << "return array;\n}\n";
+}
+
+void BindingGenerator::setCallMode(CallMode mode)
+{
+	callMode = mode;
+}
+
+void BindingGenerator::setIdentityCache(bool value)
+{
+	identityCache = value;
+}
 
-	jni << "struct JavaString\n{\npublic:\n" <<
-			"JavaString(JNIEnv* env, jstring value)" <<
-			" : env(env), javaString(value), cString(env->GetStringUTFChars(value, 0)) {}\n" <<
-			"~JavaString() { env->ReleaseStringUTFChars(javaString, cString); }\n" <<
-			"JNIEnv* env;\njstring javaString;\nconst char* cString;\n};\n";
+void BindingGenerator::setBridgeStats(bool value)
+{
+	bridgeStats = value;
+}
+
+void BindingGenerator::ensureBridgeTableAccess()
+{
+	if(bridgeTableAccessGenerated)
+	{
+		return;
+	}
+
+	bridgeTableAccessGenerated = true;
+
+	jni << "#include \"glue_table.hh\"\n";
+	jni << "#include <cstdio>\n";
+	jni << "#include <cstdlib>\n";
+
+	// Make sure that the JNI glue is compiled against the same glue code that it was generated for.
+	jni << "static_assert(AG_BRIDGE_TABLE_VERSION == " << getBackend().getBridgeTable().getVersion() <<
+			"u, \"glue_table.hh doesn't match the JNI glue\");\n";
+
+	// The table is looked up once, after which bridge calls are plain indirect calls.
+	jni << "static const AG_BridgeTable& AG_getBridges()\n{\n" <<
+			"static const AG_BridgeTable* table = AG_getBridgeTable();\n" <<
+			"if(table->version != AG_BRIDGE_TABLE_VERSION)\n{\n" <<
+			"std::fprintf(stderr, \"The loaded glue code doesn't match the JNI glue\\n\");\n" <<
+			"std::abort();\n}\n" <<
+			"return *table;\n}\n\n";
+}
+
+void BindingGenerator::ensureValueTypesJNI(FunctionEntity& entity)
+{
+	std::vector <TypeReferenceEntity> types;
+
+	if(entity.returnsValue())
+	{
+		types.push_back(entity.getReturnType(true));
+	}
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		types.push_back(entity.getParameter(i).getAsPOD());
+	}
+
+	for(auto& type : types)
+	{
+		if(!isValueType(type) || !valueTypesJNI.emplace(&type.getClassType()).second)
+		{
+			continue;
+		}
+
+		// The mirror struct matches the one in the glue code, which also defines it in glue_table.hh.
+		auto& value = type.getClassType();
+		auto name = getValueNameJNI(value);
+
+		jni << "#ifndef " << name << "_DEFINED\n";
+		jni << "#define " << name << "_DEFINED\n";
+		jni << "struct alignas(" << value.getValueAlignment() << ") " << name << "\n{\n";
+
+		for(size_t i = 0; i < value.getValueFieldCount(); i++)
+		{
+			auto& field = value.getValueField(i);
+			jni << getPrimitiveNameJNI(field.type->getType(), true) << ' ' << field.name << ";\n";
+		}
+
+		jni << "};\n";
+		jni << "#endif\n";
+	}
+}
+
+void BindingGenerator::addNative(FunctionEntity& entity, const std::string& functionName)
+{
+	auto packagePath = packagePrefix;
+	std::replace(packagePath.begin(), packagePath.end(), '.', '/');
+
+	auto classPath = packagePrefix + '/' + getClassPathJNI(entity.getParent());
+	std::replace(classPath.begin(), classPath.end(), '.', '/');
+
+	addNative(classPath, { inStorage ? entity.getStorageBridgeName(true) : entity.getBridgeName(true),
+				getMethodDescriptorJNI(entity, packagePath, takesStorage(entity)), functionName });
+}
+
+void BindingGenerator::addNative(const std::string& classPath, Native&& native)
+{
+	// Natives of a class are generated one after another, so only the last class needs to be checked.
+	if(natives.empty() || natives.back().first != classPath)
+	{
+		natives.emplace_back(classPath, std::vector <Native> ());
+	}
+
+	natives.back().second.push_back(std::move(native));
+}
+
+int BindingGenerator::getDestructorIndex(ClassEntity& entity)
+{
+	for(size_t i = 0; i < destructors.size(); i++)
+	{
+		if(destructors[i].first == &entity)
+		{
+			return i;
+		}
+	}
+
+	// Classes that can't be deleted by the glue code have no used destructor.
+	auto result = entity.resolve("Destructor");
+	if(!result || result->getType() != Entity::Type::FunctionGroup || result->getUsages() == 0)
+	{
+		return -1;
+	}
+
+	auto& group = static_cast <FunctionGroupEntity&> (*result);
+	if(group.getOverloadCount() == 0)
+	{
+		return -1;
+	}
+
+	destructors.emplace_back(&entity, group.getOverload(0).getBridgeName());
+	return destructors.size() - 1;
+}
+
+void BindingGenerator::generateLifetime()
+{
+	auto packagePath = packagePrefix;
+	std::replace(packagePath.begin(), packagePath.end(), '.', '/');
+
+	std::ofstream lifetime(packagePath + "/AG_Lifetime.java");
+
+	lifetime << "package " << packagePrefix << ";\n\n";
+	lifetime << "import java.lang.ref.Cleaner;\n\n";
+
+	// Owned objects are released when they are closed or when the cleaner
+	// finds them unreachable, unless a scope releases them first.
+	lifetime << "public final class AG_Lifetime {\n";
+	lifetime << "private static final Cleaner cleaner = Cleaner.create();\n\n";
+
+	generateLifetimeNatives(lifetime);
+	lifetime << "private AG_Lifetime() {\n}\n\n";
+
+	// The cleaning action can't refer to the owner, or it would never become unreachable.
+	lifetime << "private static final class Release implements Runnable {\n";
+	lifetime << "private final long handle;\nprivate final int destructor;\n\n";
+	lifetime << "Release(long handle, int destructor) {\n";
+	lifetime << "this.handle = handle;\nthis.destructor = destructor;\n}\n\n";
+	lifetime << "public void run() {\ndestroy(handle, destructor);\n}\n}\n\n";
+
+	lifetime << "public static Cleaner.Cleanable own(Object owner, long handle, int destructor) {\n";
+	lifetime << "Scope scope = Scope.current.get();\n";
+	lifetime << "if(scope != null) {\nreturn scope.add(handle, destructor);\n}\n\n";
+	lifetime << "return cleaner.register(owner, new Release(handle, destructor));\n}\n\n";
+
+	// Other native resources, such as the context of a callable, are released with the same cleaner.
+	lifetime << "public static Cleaner.Cleanable onUnreachable(Object owner, Runnable action) {\n";
+	lifetime << "return cleaner.register(owner, action);\n}\n\n";
+
+	// Actions that depend on an owned object, such as unregistering it from the glue code,
+	// run once the object is closed or the scope that owns it is closed.
+	lifetime << "public static Cleaner.Cleanable onRelease(Cleaner.Cleanable cleanable, Runnable action) {\n";
+	lifetime << "Scope scope = Scope.current.get();\n";
+	lifetime << "if(scope != null) {\nscope.actions.add(action);\n}\n\n";
+	lifetime << "return () -> {\n";
+	lifetime << "try {\n";
+	lifetime << "if(cleanable != null) {\ncleanable.clean();\n}\n";
+	lifetime << "} finally {\n";
+	lifetime << "action.run();\n}\n};\n}\n\n";
+
+	// A scope collects the objects owned while it is open on the current thread,
+	// and releases the ones that are still alive with a single native call.
+	lifetime << "public static final class Scope implements AutoCloseable {\n";
+	lifetime << "private static final ThreadLocal <Scope> current = new ThreadLocal <> ();\n";
+	lifetime << "private final Scope previous;\n";
+	lifetime << "private long[] handles = new long[16];\n";
+	lifetime << "private int[] destructors = new int[16];\n";
+	lifetime << "private int count = 0;\n";
+	lifetime << "private final java.util.ArrayList <Runnable> actions = new java.util.ArrayList <> ();\n";
+	lifetime << "private boolean closed = false;\n\n";
+
+	lifetime << "public Scope() {\nprevious = current.get();\ncurrent.set(this);\n}\n\n";
+
+	lifetime << "private Cleaner.Cleanable add(long handle, int destructor) {\n";
+	lifetime << "if(count == handles.length) {\n";
+	lifetime << "handles = java.util.Arrays.copyOf(handles, count * 2);\n";
+	lifetime << "destructors = java.util.Arrays.copyOf(destructors, count * 2);\n}\n\n";
+	lifetime << "int index = count++;\n";
+	lifetime << "handles[index] = handle;\n";
+	lifetime << "destructors[index] = destructor;\n";
+	lifetime << "return () -> release(index);\n}\n\n";
+
+	lifetime << "private void release(int index) {\n";
+	lifetime << "if(!closed && handles[index] != 0) {\n";
+	lifetime << "long handle = handles[index];\n";
+	lifetime << "handles[index] = 0;\n";
+	lifetime << "destroy(handle, destructors[index]);\n}\n}\n\n";
+
+	lifetime << "@Override\npublic void close() {\n";
+	lifetime << "if(closed) {\nreturn;\n}\n\n";
+	lifetime << "closed = true;\n";
+	lifetime << "current.set(previous);\n";
+	lifetime << "destroyAll(handles, destructors, count);\n\n";
+	lifetime << "for(Runnable action : actions) {\naction.run();\n}\n}\n}\n}\n";
+}
+
+void BindingGenerator::generateLifetimeNatives(std::ofstream& lifetime)
+{
+	lifetime << "private static native void destroy(long handle, int destructor);\n";
+	lifetime << "private static native void destroyAll(long[] handles, int[] destructors, int count);\n\n";
+
+	// The destructors are called through a single function that selects the bridge.
+	if(callMode == CallMode::BridgeTable)
+	{
+		ensureBridgeTableAccess();
+	}
+
+	else
+	{
+		for(auto& destructor : destructors)
+		{
+			jni << "extern \"C\" void " << destructor.second << "(void* objectHandle);\n";
+		}
+	}
+
+	jni << "static void AG_destroy(void* handle, jint destructor)\n{\n";
+	jni << "switch(destructor)\n{\n";
+
+	for(size_t i = 0; i < destructors.size(); i++)
+	{
+		jni << "case " << i << ": " << (callMode == CallMode::BridgeTable ? "AG_getBridges()." : "") <<
+				destructors[i].second << "(handle); break;\n";
+	}
+
+	jni << "}\n}\n\n";
+
+	auto prefix = "Java_" + packagePrefix + "_AG_1Lifetime_";
+
+	jni << "static void JNICALL " << prefix << "destroy(JNIEnv*, jclass, jlong handle, jint destructor)\n{\n";
+	jni << "AG_destroy(reinterpret_cast <void*> (handle), destructor);\n}\n\n";
+
+	jni << "static void JNICALL " << prefix << "destroyAll(JNIEnv* env, jclass, jlongArray handles, jintArray destructors, jint count)\n{\n";
+	jni << "jlong* handleElements = env->GetLongArrayElements(handles, nullptr);\n";
+	jni << "jint* destructorElements = env->GetIntArrayElements(destructors, nullptr);\n\n";
+	jni << "for(jint i = 0; i < count; i++)\n{\n";
+	jni << "if(handleElements[i] != 0)\n{\n";
+	jni << "AG_destroy(reinterpret_cast <void*> (handleElements[i]), destructorElements[i]);\n}\n}\n\n";
+	jni << "env->ReleaseLongArrayElements(handles, handleElements, JNI_ABORT);\n";
+	jni << "env->ReleaseIntArrayElements(destructors, destructorElements, JNI_ABORT);\n}\n\n";
+
+	auto classPath = packagePrefix + "/AG_Lifetime";
+	std::replace(classPath.begin(), classPath.end(), '.', '/');
+
+	addNative(classPath, { "destroy", "(JI)V", prefix + "destroy" });
+	addNative(classPath, { "destroyAll", "([J[II)V", prefix + "destroyAll" });
+}
+
+void BindingGenerator::generateBridgeStats()
+{
+	auto packagePath = packagePrefix;
+	std::replace(packagePath.begin(), packagePath.end(), '.', '/');
+
+	std::ofstream stats(packagePath + "/BridgeStats.java");
+
+	stats << "package " << packagePrefix << ";\n\n";
+	stats << "public final class BridgeStats {\n";
+
+	// Latency bucket 0 counts calls shorter than 64 ns, and each following bucket
+	// doubles the limit. The last bucket counts every call from about 1 ms up.
+	stats << "public static final int LATENCY_BUCKETS = 16;\n\n";
+
+	stats << "public static final class Entry {\n";
+	stats << "public final String name;\n";
+	stats << "public final long calls;\n";
+	stats << "public final long[] latencies;\n\n";
+	stats << "Entry(String name, long calls, long[] latencies) {\n";
+	stats << "this.name = name;\nthis.calls = calls;\nthis.latencies = latencies;\n}\n}\n\n";
+
+	generateBridgeStatsNatives(stats);
+	stats << "private static final String[] names = getNames();\n\n";
+	stats << "private BridgeStats() {\n}\n\n";
+
+	// Each entry of AG_BridgeStats is the call count followed by the latency buckets.
+	stats << "public static Entry[] snapshot() {\n";
+	stats << "long[] counts = getCounts(names.length);\n";
+	stats << "Entry[] result = new Entry[names.length];\n";
+	stats << "for(int i = 0; i < names.length; i++) {\n";
+	stats << "int offset = i * (LATENCY_BUCKETS + 1);\n";
+	stats << "result[i] = new Entry(names[i], counts[offset], " <<
+			"java.util.Arrays.copyOfRange(counts, offset + 1, offset + 1 + LATENCY_BUCKETS));\n}\n\n";
+	stats << "return result;\n}\n\n";
+
+	stats << "public static void reset() {\n";
+	stats << "resetCounts();\n}\n}\n";
+}
+
+void BindingGenerator::generateBridgeStatsNatives(std::ofstream& stats)
+{
+	stats << "private static native String[] getNames();\n";
+	stats << "private static native long[] getCounts(int count);\n";
+	stats << "private static native void resetCounts();\n\n";
+
+	// The reporting functions are exported even when the bridge functions are hidden.
+	jni << "#ifndef AG_BRIDGE_STATS_DEFINED\n";
+	jni << "#define AG_BRIDGE_STATS_DEFINED\n";
+	jni << "struct AG_BridgeStats\n{\nuint64_t calls;\nuint64_t latencies[16];\n};\n";
+	jni << "#endif\n";
+	jni << "extern \"C\" size_t AG_getBridgeCount();\n";
+	jni << "extern \"C\" const char* AG_getBridgeName(size_t index);\n";
+	jni << "extern \"C\" void AG_getBridgeStats(AG_BridgeStats* stats);\n";
+	jni << "extern \"C\" void AG_resetBridgeStats();\n\n";
+
+	auto prefix = "Java_" + packagePrefix + "_BridgeStats_";
+
+	jni << "static jobjectArray JNICALL " << prefix << "getNames(JNIEnv* env, jclass)\n{\n";
+	jni << "jsize count = static_cast <jsize> (AG_getBridgeCount());\n";
+	jni << "jobjectArray names = env->NewObjectArray(count, env->FindClass(\"java/lang/String\"), nullptr);\n";
+	jni << "for(jsize i = 0; i < count; i++)\n{\n";
+	jni << "jstring name = env->NewStringUTF(AG_getBridgeName(i));\n";
+	jni << "env->SetObjectArrayElement(names, i, name);\n";
+	jni << "env->DeleteLocalRef(name);\n}\n\n";
+	jni << "return names;\n}\n\n";
+
+	// The entries are plain 64-bit counters, so they are copied to Java as they are.
+	jni << "static jlongArray JNICALL " << prefix << "getCounts(JNIEnv* env, jclass, jint count)\n{\n";
+	jni << "std::vector <AG_BridgeStats> stats(count);\n";
+	jni << "AG_getBridgeStats(stats.data());\n";
+	jni << "jsize size = static_cast <jsize> (stats.size() * sizeof(AG_BridgeStats) / sizeof(jlong));\n";
+	jni << "jlongArray counts = env->NewLongArray(size);\n";
+	jni << "env->SetLongArrayRegion(counts, 0, size, reinterpret_cast <const jlong*> (stats.data()));\n";
+	jni << "return counts;\n}\n\n";
+
+	jni << "static void JNICALL " << prefix << "resetCounts(JNIEnv*, jclass)\n{\n";
+	jni << "AG_resetBridgeStats();\n}\n\n";
+
+	auto classPath = packagePrefix + "/BridgeStats";
+	std::replace(classPath.begin(), classPath.end(), '.', '/');
+
+	addNative(classPath, { "getNames", "()[Ljava/lang/String;", prefix + "getNames" });
+	addNative(classPath, { "getCounts", "(I)[J", prefix + "getCounts" });
+	addNative(classPath, { "resetCounts", "()V", prefix + "resetCounts" });
+}
+
+void BindingGenerator::generateOnLoad()
+{
+	// Registering every native up front avoids the JVM looking up each
+	// JNI function by name when it is first called.
+	jni << "extern \"C\" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void*)\n{\n";
+	jni << "JNIEnv* env;\n";
+	jni << "if(vm->GetEnv(reinterpret_cast <void**> (&env), JNI_VERSION_1_6) != JNI_OK)\n{\n";
+	jni << "return JNI_ERR;\n}\n\n";
+
+	if(callableAccessGenerated)
+	{
+		jni << "AG_javaVM = vm;\n\n";
+	}
+
+	// Refuse to load when the loaded glue code doesn't match.
+	if(bridgeTableAccessGenerated)
+	{
+		jni << "if(AG_getBridgeTable()->version != AG_BRIDGE_TABLE_VERSION)\n{\n";
+		jni << "return JNI_ERR;\n}\n\n";
+	}
+
+	for(auto& [classPath, methods] : natives)
+	{
+		jni << "{\n";
+		jni << "static const JNINativeMethod methods[] =\n{\n";
+
+		for(auto& method : methods)
+		{
+			jni << "{ const_cast <char*> (\"" << method.name << "\"), const_cast <char*> (\"" <<
+					method.signature << "\"), reinterpret_cast <void*> (" << method.function << ") },\n";
+		}
+
+		jni << "};\n\n";
+
+		jni << "jclass cls = env->FindClass(\"" << classPath << "\");\n";
+		jni << "if(!cls || env->RegisterNatives(cls, methods, " << methods.size() << ") != JNI_OK)\n{\n";
+		jni << "return JNI_ERR;\n}\n\n";
+		jni << "env->DeleteLocalRef(cls);\n";
+		jni << "}\n\n";
+	}
+
+	// The trampolines of Java callables call the interface method through a cached method ID.
+	for(auto& [name, descriptor] : callableMethods)
+	{
+		auto classPath = packagePrefix + '/' + name;
+		std::replace(classPath.begin(), classPath.end(), '.', '/');
+
+		jni << "{\n";
+		jni << "jclass cls = env->FindClass(\"" << classPath << "\");\n";
+		jni << "if(!cls || !(AG_" << name << "_method = env->GetMethodID(cls, \"invoke\", \"" << descriptor << "\")))\n{\n";
+		jni << "return JNI_ERR;\n}\n\n";
+		jni << "env->DeleteLocalRef(cls);\n";
+		jni << "}\n\n";
+	}
+
+	// Asynchronous calls are completed through a static method of the class calling the function.
+	for(auto& [classPath, completion] : asyncCompletions)
+	{
+		jni << "{\n";
+		jni << "jclass cls = env->FindClass(\"" << classPath << "\");\n";
+		jni << "if(!cls || !(" << completion.function << "_method = env->GetStaticMethodID(cls, \"" <<
+				completion.name << "\", \"" << completion.signature << "\")))\n{\n";
+		jni << "return JNI_ERR;\n}\n\n";
+		jni << completion.function << "_class = static_cast <jclass> (env->NewGlobalRef(cls));\n";
+		jni << "env->DeleteLocalRef(cls);\n";
+		jni << "}\n\n";
+	}
+
+	jni << "return JNI_VERSION_1_6;\n}\n";
+}
+
+void BindingGenerator::finishGeneration()
+{
+	generateLifetime();
+
+	if(bridgeStats)
+	{
+		generateBridgeStats();
+	}
+
+	generateOnLoad();
+
+	natives.clear();
+	destructors.clear();
+	callableMethods.clear();
+	asyncCompletions.clear();
 }
 
 void BindingGenerator::openFile(Entity& entity)
@@ -91,6 +930,12 @@ void BindingGenerator::generateClass(ClassEntity& entity)
 		openFile(entity);
 	}
 
+	if(entity.isValueType())
+	{
+		generateValueType(entity);
+		return;
+	}
+
 	// TODO: Use protected if necessary.
 	file << "public ";
 
@@ -120,18 +965,46 @@ void BindingGenerator::generateClass(ClassEntity& entity)
 	// Add the object handle if this class has no base classes.
 	if(!entity.hasBaseTypes())
 	{
-		file << " {\n";
+		file << "implements AutoCloseable {\n";
 
 		// Store a pointer to the "this" object.
-		file << "protected long mObjectHandle;\n\n";
+		file << "protected " << getHandleType() << " mObjectHandle;\n";
+
+		// Owned objects release the native object once they are closed or unreachable.
+		file << "protected java.lang.ref.Cleaner.Cleanable mCleanable;\n\n";
 
 		// Define a constructor that constructs an object using an existing pointer.
-		file << "public " + entity.getName() + "(long objectHandle) {\n";
-		file << "mObjectHandle = objectHandle;\n}\n";
+		// The pointer is borrowed, so the native object is never released through it.
+		file << "public " + entity.getName() + "(" << getHandleType() << " objectHandle) {\n";
+		file << "this(objectHandle, false);\n}\n";
+
+		file << "public " + entity.getName() + "(" << getHandleType() << " objectHandle, boolean owned) {\n";
+		file << "mObjectHandle = objectHandle;\n\n";
+		file << "if(owned && AG_getDestructor() >= 0) {\n";
+		file << "mCleanable = " << packagePrefix << ".AG_Lifetime.own(this, " <<
+				getHandleAddress("objectHandle") << ", AG_getDestructor());\n}\n}\n";
 
 		// Define a public getter for the object handle.
-		file << "public long getObjectHandle() {\n";
+		file << "public " << getHandleType() << " getObjectHandle() {\n";
 		file << "return mObjectHandle;\n}\n\n";
+
+		// Objects consumed by the native code give up their handle so that they can't be used again.
+		// An owned object still releases what is left of the native object.
+		file << "public " << getHandleType() << " takeObjectHandle() {\n";
+		file << getHandleType() << " handle = mObjectHandle;\n";
+		file << "mObjectHandle = " << getNullHandle() << ";\n";
+		file << "return handle;\n}\n\n";
+
+		file << "public boolean ownsHandle() {\n";
+		file << "return mCleanable != null;\n}\n\n";
+
+		file << "@Override\npublic void close() {\n";
+		file << "if(mCleanable != null) {\n";
+		file << "mCleanable.clean();\n";
+		file << "mCleanable = null;\n}\n}\n\n";
+
+		file << "protected int AG_getDestructor() {\n";
+		file << "return " << getDestructorIndex(entity) << ";\n}\n\n";
 	}
 
 	// If there are base classes, add a constructor that calls super.
@@ -140,10 +1013,34 @@ void BindingGenerator::generateClass(ClassEntity& entity)
 		file << "{\n";
 
 		// Call the pointer initialization constructor of the first base class.
-		file << "public " + entity.getName() + "(long objectHandle) {\n";
+		file << "public " + entity.getName() + "(" << getHandleType() << " objectHandle) {\n";
 		file << "super(objectHandle);\n}\n";
+
+		file << "public " + entity.getName() + "(" << getHandleType() << " objectHandle, boolean owned) {\n";
+		file << "super(objectHandle, owned);\n}\n";
+
+		// The base class releases owned objects with the destructor of the most derived class.
+		file << "@Override\nprotected int AG_getDestructor() {\n";
+		file << "return " << getDestructorIndex(entity) << ";\n}\n\n";
 	}
 
+	// Abstract classes can't be instantiated, so they have nothing to cache.
+	if(identityCache && !entity.isAbstract())
+	{
+		generateIdentityCache(entity);
+	}
+
+	// Callers providing storage for returned objects need the layout of the class.
+	if(entity.isStorable())
+	{
+		file << "public static final long STORAGE_SIZE = " << entity.getStorageSize() << ";\n";
+		file << "public static final long STORAGE_ALIGNMENT = " << entity.getStorageAlignment() << ";\n\n";
+	}
+
+	// Generators that support interception generate it here.
+	entity.generateInterceptionFunctions(*this);
+	entity.generateInterceptionContext(*this);
+
 	// Generate the nested entities of this class.
 	entity.generateNested(*this);
 
@@ -158,6 +1055,112 @@ void BindingGenerator::generateClass(ClassEntity& entity)
 	}
 }
 
+void BindingGenerator::generateIdentityCache(ClassEntity& entity)
+{
+	auto& name = entity.getName();
+	std::string reference = "java.lang.ref.WeakReference <" + name + '>';
+
+	file << "private static final java.util.HashMap <Long, " << reference << "> AG_wrappers = new java.util.HashMap <> ();\n";
+	file << "private static int AG_wrapperLimit = 64;\n\n";
+
+	file << "public static " << name << " AG_wrap(" << getHandleType() << " handle) {\n";
+	file << "return AG_wrap(handle, false);\n}\n\n";
+
+	file << "public static " << name << " AG_wrap(" << getHandleType() << " handle, boolean owned) {\n";
+	file << "long address = " << getHandleAddress("handle") << ";\n";
+	file << "if(address == 0) {\n";
+	file << "return new " << name << "(handle, owned);\n}\n\n";
+
+	file << "synchronized(AG_wrappers) {\n";
+	file << reference << " weak = AG_wrappers.get(address);\n";
+	file << name << " existing = weak != null ? weak.get() : null;\n\n";
+
+	// Owned objects were just created by the glue code, so an existing wrapper of the same
+	// address is stale. Neither is a wrapper that gave up its handle.
+	file << "if(!owned && existing != null && " << getHandleAddress("existing.mObjectHandle") << " == address) {\n";
+	file << "return existing;\n}\n\n";
+
+	// Entries of collected wrappers are removed once the map has doubled in size.
+	file << "if(AG_wrappers.size() >= AG_wrapperLimit) {\n";
+	file << "AG_wrappers.values().removeIf(entry -> entry.get() == null);\n";
+	file << "AG_wrapperLimit = Math.max(64, AG_wrappers.size() * 2);\n}\n\n";
+
+	file << name << " created = new " << name << "(handle, owned);\n";
+	file << "AG_wrappers.put(address, new " << reference << " (created));\n";
+	file << "return created;\n}\n}\n\n";
+}
+
+void BindingGenerator::generateValueType(ClassEntity& entity)
+{
+	// Value types are copied to plain Java objects holding their fields.
+	file << "public ";
+
+	if(getClassDepth() > 1)
+	{
+		file << "static ";
+	}
+
+	file << "final class " << entity.getName() << " {\n";
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		TypeReferenceEntity fieldType(field.name, field.type, false);
+
+		file << "public ";
+		generateTyperefJava(fieldType);
+		file << ";\n";
+	}
+
+	file << "\npublic " << entity.getName() << "() {\n}\n\n";
+	file << "public " << entity.getName() << '(';
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		TypeReferenceEntity fieldType(field.name, field.type, false);
+
+		file << (i > 0 ? ", " : "");
+		generateTyperefJava(fieldType);
+	}
+
+	file << ") {\n";
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		file << "this." << field.name << " = " << field.name << ";\n";
+	}
+
+	file << "}\n\n";
+
+	generateValueHelpers(entity);
+	file << "}\n";
+
+	if(getClassDepth() == 1)
+	{
+		assert(file.is_open());
+		file.close();
+	}
+}
+
+void BindingGenerator::generateValueHelpers(ClassEntity& entity)
+{
+	// The JNI glue returns the bytes of the mirror struct in native byte order.
+	file << "static " << entity.getName() << " AG_fromBytes(byte[] bytes) {\n";
+	file << "java.nio.ByteBuffer buffer = java.nio.ByteBuffer.wrap(bytes).order(java.nio.ByteOrder.nativeOrder());\n";
+	file << entity.getName() << " result = new " << entity.getName() << "();\n";
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		file << "result." << field.name << " = buffer." << getByteBufferGetter(field.type->getType()) <<
+				'(' << field.offset << ");\n";
+	}
+
+	file << "return result;\n}\n";
+}
+
 void BindingGenerator::generateEnum(EnumEntity& entity)
 {
 	// If no class has been opened, this is a top level enum which needs its own file.
@@ -175,158 +1178,974 @@ void BindingGenerator::generateEnum(EnumEntity& entity)
 	// Add a getter for the integer value.
 	file << "public int getValue() {\nreturn mValue;\n}\n\n";
 
-	// Add a method that converts an integer to the corresponding enum value.
-	file << "public static " << entity.getName() << " fromInt(int i) {\n";
-	file << "return " << entity.getName() << ".values()[i];\n}\n";
+	// Add a method that converts an integer to the corresponding enum value.
+	file << "public static " << entity.getName() << " fromInt(int i) {\n";
+	file << "return " << entity.getName() << ".values()[i];\n}\n";
+
+	// Generate a constructor for the enum that takes an integer.
+	file << "private " << entity.getName() << "(int value) {\nmValue = value;\n}\n\n";
+	file << "private int mValue;\n}\n\n";
+
+	// Since each top level enum goes to its own file,
+	// close the current file if a top level enum is being ended.
+	if(getClassDepth() == 0)
+	{
+		assert(file.is_open());
+		file.close();
+	}
+}
+
+void BindingGenerator::generateEnumEntry(EnumEntryEntity& entity)
+{
+	// Generate enum values.
+	file << sanitizeName(entity) << '(' << entity.getValue() << ')'
+		<< (entity.isLast() ? ";\n" : ",\n");
+}
+
+void BindingGenerator::generateCallableType(CallableTypeEntity& entity)
+{
+	// Callables are presented as functional interfaces so that lambdas can be passed.
+	openFile(entity);
+
+	file << "@FunctionalInterface\n";
+	file << "public interface " << entity.getName() << " {\n";
+	generateTyperefJava(entity.getReturnType());
+	file << "invoke(";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		file << (i > 0 ? ", " : "");
+		generateTyperefJava(entity.getParameter(i));
+	}
+
+	file << ");\n}\n";
+	file.close();
+
+	generateCallableHelpers(entity);
+}
+
+void BindingGenerator::generateCallableHelpers(CallableTypeEntity& entity)
+{
+	auto packagePath = packagePrefix;
+	std::replace(packagePath.begin(), packagePath.end(), '.', '/');
+
+	auto name = entity.getName();
+	auto interfaceName = packagePrefix + '.' + name;
+
+	file.open(packagePath + "/AG_" + name + ".java");
+	file << "package " << packagePrefix << ";\n\n";
+
+	// Callables returned by the glue code are wrapped in a lambda that calls the trampoline
+	// with the context. The context is released once the lambda is unreachable.
+	file << "public final class AG_" << name << " {\n";
+	file << "private AG_" << name << "() {\n}\n\n";
+
+	std::string arguments;
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		arguments += (i > 0 ? ", " : "") + sanitizeName(entity.getParameter(i));
+	}
+
+	file << "public static " << interfaceName << " AG_fromNative(long[] value) {\n";
+	file << "if(value[0] == 0) {\nreturn null;\n}\n\n";
+	file << "long invoke = value[0];\n";
+	file << "long context = value[1];\n";
+	file << interfaceName << " result = (" << arguments << ") -> invoke(invoke, context" <<
+			(arguments.empty() ? "" : ", ") << arguments << ");\n\n";
+	file << "if(value[2] != 0) {\n";
+	file << "long release = value[2];\n";
+	file << packagePrefix << ".AG_Lifetime.onUnreachable(result, () -> release(release, context));\n}\n\n";
+	file << "return result;\n}\n\n";
+
+	file << "private static native ";
+	generateTyperefJava(entity.getReturnType());
+	file << "invoke(long invoke, long context";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		file << ", ";
+		generateTyperefJava(entity.getParameter(i));
+	}
+
+	file << ");\n";
+	file << "private static native void release(long release, long context);\n}\n";
+	file.close();
+}
+
+std::string BindingGenerator::getViewConversion(PrimitiveEntity::Type element)
+{
+	const char* method = "";
+
+	switch(element)
+	{
+		case PrimitiveEntity::Type::Integer: method = "ofInts"; break;
+		case PrimitiveEntity::Type::Float: method = "ofFloats"; break;
+		case PrimitiveEntity::Type::Double: method = "ofDoubles"; break;
+		case PrimitiveEntity::Type::Character: method = "ofBytes"; break;
+		default: {}
+	}
+
+	ensureViewHelper();
+	return packagePrefix + ".AG_View." + method;
+}
+
+void BindingGenerator::ensureViewHelper()
+{
+	if(viewHelperGenerated)
+	{
+		return;
+	}
+
+	viewHelperGenerated = true;
+
+	auto packagePath = packagePrefix;
+	std::replace(packagePath.begin(), packagePath.end(), '.', '/');
+
+	std::ofstream helper(packagePath + "/AG_View.java");
+
+	helper << "package " << packagePrefix << ";\n\n";
+	helper << "import java.nio.ByteBuffer;\n";
+	helper << "import java.nio.ByteOrder;\n\n";
+
+	// Borrowed buffers are read-only views of the native elements which must
+	// not be used after the native object holding them changes or is destroyed.
+	helper << "public final class AG_View {\n";
+	helper << "private AG_View() {\n}\n\n";
+
+	helper << "private static ByteBuffer order(ByteBuffer buffer) {\n";
+	helper << "return buffer == null ? ByteBuffer.allocate(0) : buffer.order(ByteOrder.nativeOrder());\n}\n\n";
+
+	helper << "public static java.nio.IntBuffer ofInts(ByteBuffer buffer) {\n";
+	helper << "return order(buffer).asIntBuffer().asReadOnlyBuffer();\n}\n\n";
+	helper << "public static java.nio.FloatBuffer ofFloats(ByteBuffer buffer) {\n";
+	helper << "return order(buffer).asFloatBuffer().asReadOnlyBuffer();\n}\n\n";
+	helper << "public static java.nio.DoubleBuffer ofDoubles(ByteBuffer buffer) {\n";
+	helper << "return order(buffer).asDoubleBuffer().asReadOnlyBuffer();\n}\n\n";
+	helper << "public static ByteBuffer ofBytes(ByteBuffer buffer) {\n";
+	helper << "return order(buffer).asReadOnlyBuffer();\n}\n}\n";
+}
+
+void BindingGenerator::ensureCallableAccessJNI()
+{
+	if(callableAccessGenerated)
+	{
+		return;
+	}
+
+	callableAccessGenerated = true;
+
+	// Java callables might be called from threads that the JVM doesn't know about yet.
+	jni << "static JavaVM* AG_javaVM = nullptr;\n";
+	jni << "static JNIEnv* AG_getEnv()\n{\n";
+	jni << "JNIEnv* env;\n";
+	jni << "if(AG_javaVM->GetEnv(reinterpret_cast <void**> (&env), JNI_VERSION_1_6) != JNI_OK)\n{\n";
+	jni << "AG_javaVM->AttachCurrentThreadAsDaemon(reinterpret_cast <void**> (&env), nullptr);\n}\n";
+	jni << "return env;\n}\n";
+
+	// The context of a Java callable is a global reference to the Java object.
+	jni << "static void AG_releaseJavaCallable(void* context)\n{\n";
+	jni << "AG_getEnv()->DeleteGlobalRef(static_cast <jobject> (context));\n}\n";
+
+	jni << "static jlongArray toJavaCallable(JNIEnv* env, AG_Callable value)\n{\n";
+	jni << "jlong fields[] = { reinterpret_cast <jlong> (value.invoke), reinterpret_cast <jlong> (value.context), " <<
+			"reinterpret_cast <jlong> (value.release) };\n";
+	jni << "jlongArray array = env->NewLongArray(3);\n";
+	jni << "env->SetLongArrayRegion(array, 0, 3, fields);\n";
+	jni << "return array;\n}\n";
+
+	jni << "static void JNICALL AG_releaseNativeCallable(JNIEnv*, jclass, jlong release, jlong context)\n{\n";
+	jni << "reinterpret_cast <void(*)(void*)> (release)(reinterpret_cast <void*> (context));\n}\n\n";
+}
+
+void BindingGenerator::ensureCallablesJNI(FunctionEntity& entity)
+{
+	std::vector <TypeReferenceEntity> types;
+
+	if(entity.returnsValue())
+	{
+		types.push_back(entity.getReturnType(true));
+	}
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		types.push_back(entity.getParameter(i).getAsPOD());
+	}
+
+	for(auto& type : types)
+	{
+		if(!type.isCallable() || !callablesJNI.emplace(&type.getCallableType()).second)
+		{
+			continue;
+		}
+
+		ensureCallableAccessJNI();
+
+		auto packagePath = packagePrefix;
+		std::replace(packagePath.begin(), packagePath.end(), '.', '/');
+
+		auto& callable = type.getCallableType();
+		auto name = "AG_" + callable.getName();
+		auto returnType = callable.getReturnType().getPrimitiveType().getType();
+		auto returnName = getPrimitiveNameJNI(returnType, true);
+
+		std::string descriptor;
+		std::string parameters;
+		std::string arguments;
+		std::string parametersJNI;
+		std::string argumentsJNI;
+
+		for(size_t i = 0; i < callable.getParameterCount(); i++)
+		{
+			auto& param = callable.getParameter(i);
+			auto primitive = param.getPrimitiveType().getType();
+
+			descriptor += getTypeDescriptorJNI(param, packagePath);
+			parameters += std::string(", ") + getPrimitiveNameJNI(primitive, true) + ' ' + param.getName();
+			arguments += std::string(", static_cast <") + getPrimitiveNameJNI(primitive, false) + "> (" + param.getName() + ')';
+			parametersJNI += std::string(", ") + getPrimitiveNameJNI(primitive, false) + ' ' + param.getName();
+			argumentsJNI += std::string(", static_cast <") + getPrimitiveNameJNI(primitive, true) + "> (" + param.getName() + ')';
+		}
+
+		descriptor = '(' + descriptor + ')' + getTypeDescriptorJNI(callable.getReturnType(), packagePath);
+		callableMethods.emplace_back(callable.getName(), descriptor);
+
+		// The trampoline calls the interface method of the Java object.
+		jni << "static jmethodID " << name << "_method;\n";
+		jni << "static " << returnName << ' ' << name << "_invoke(void* context" << parameters << ")\n{\n";
+
+		std::string call = "AG_getEnv()->Call" + std::string(getCallNameJNI(returnType)) +
+							"Method(static_cast <jobject> (context), " + name + "_method" + arguments + ')';
+
+		if(callable.returnsValue())
+		{
+			jni << "return static_cast <" << returnName << "> (" << call << ");\n}\n";
+		}
+
+		else
+		{
+			jni << call << ";\n}\n";
+		}
+
+		jni << "static AG_Callable " << name << "_fromJava(JNIEnv* env, jobject value)\n{\n";
+		jni << "if(!value) { return { nullptr, nullptr, nullptr }; }\n";
+		jni << "return { reinterpret_cast <void*> (&" << name << "_invoke), env->NewGlobalRef(value), &AG_releaseJavaCallable };\n}\n";
+
+		// Callables returned by the glue code are called from Java through their trampoline.
+		auto jniName = "Java_" + packagePrefix + '_' + getEscapedNameJNI(name) + "_invoke";
+
+		jni << "static " << getPrimitiveNameJNI(returnType, false) << " JNICALL " << jniName <<
+				"(JNIEnv*, jclass, jlong invoke, jlong context" << parametersJNI << ")\n{\n";
+		jni << (callable.returnsValue() ? "return " : "") << "reinterpret_cast <" << returnName << "(*)(void*" <<
+				parameters << ")> (invoke)(reinterpret_cast <void*> (context)" << argumentsJNI << ");\n}\n\n";
+
+		auto classPath = packagePath + '/' + name;
+		addNative(classPath, { "invoke", "(JJ" + descriptor.substr(1), jniName });
+		addNative(classPath, { "release", "(JJ)V", "AG_releaseNativeCallable" });
+	}
+}
+
+void BindingGenerator::generateFunction(FunctionEntity& entity)
+{
+	// TODO: Implement Java destructors.
+	// Objects are only destroyed explicitly when they are in caller provided storage.
+	if(entity.getType() == FunctionEntity::Type::Destructor)
+	{
+		if(entity.hasStorageBridge())
+		{
+			generateStorageFunction(entity);
+		}
+
+		return;
+	}
+
+	// TODO: Generate function overloads with the appropriate names.
+	if(entity.getOverloadedOperator() != FunctionEntity::OverloadedOperator::None)
+	{
+		return;
+	}
+
+	std::string nativeName = entity.getBridgeName(true);
+	generateNativeDeclaration(entity);
+
+	// Mark overriding function appropriately.
+	if(entity.isOverride())
+	{
+		file << "@Override\n";
+	}
+
+	// Write the method signature.
+	file << "public ";
+
+	if(entity.getType() != FunctionEntity::Type::Constructor)
+	{
+		if(!entity.isOverridable())
+		{
+			file << "final ";
+		}
+
+		entity.generateReturnType(*this, false);
+	}
+
+	file << getMethodName(entity) << '(';
+	entity.generateParameters(*this, false, false);
+	file << ") {\n";
+
+	bool closeParenthesis = entity.generateReturnStatement(*this, false);
+	file << nativeName << "(";
+
+	// Call the native method with the passed parameters.
+	onlyParameterNames = true;
+	entity.generateParameters(*this, false, true);
+	onlyParameterNames = false;
+	file << ")";
+
+	// Objects created by the glue code are owned by the Java object.
+	if(ownedReturn)
+	{
+		file << ", true";
+		ownedReturn = false;
+	}
+
+	if(closeParenthesis)
+	{
+		file << ")";
+	}
+
+	file << ";\n";
+
+	// Objects created by foreign code are the wrappers of their native objects.
+	if(entity.getType() == FunctionEntity::Type::Constructor && identityCache &&
+		!static_cast <ClassEntity&> (entity.getParent()).isAbstract())
+	{
+		file << "synchronized(AG_wrappers) {\n";
+		file << "AG_wrappers.put(" << getHandleAddress("mObjectHandle") << ", new java.lang.ref.WeakReference <> (this));\n}\n";
+	}
+
+	if(entity.getType() == FunctionEntity::Type::Constructor && entity.shouldPrepareClass())
+	{
+		generateInterceptionSetup(entity);
+	}
+
+	// Close the function.
+	file << "}\n\n";
+
+	// The glue code has no bridge functions for interfaces.
+	if(entity.isInterface())
+	{
+		return;
+	}
+
+	generateNativeImplementation(entity);
+
+	if(entity.isBatched())
+	{
+		generateBatchedFunction(entity);
+	}
+
+	if(entity.hasStorageBridge())
+	{
+		generateStorageFunction(entity);
+	}
+
+	if(entity.isAsync())
+	{
+		generateAsyncFunction(entity);
+	}
+}
+
+std::string BindingGenerator::getMethodName(FunctionEntity& entity)
+{
+	// Name constructors with the class name.
+	if(entity.getType() == FunctionEntity::Type::Constructor)
+	{
+		return entity.getParent().getName();
+	}
+
+	// Field accessors are named after the field and told apart by their parameters.
+	if(auto* field = entity.getAccessedField())
+	{
+		return sanitizeName(*field);
+	}
+
+	// If this class member function isn't an override, there's a possibility of a name clash.
+	if(entity.isClassMemberFunction() && !entity.isOverride())
+	{
+		auto clashing = findClashing(entity, static_cast <TypeEntity&> (entity.getParent()), 0);
+
+		if(clashing)
+		{
+			// TODO: Instead of just using the parent class name, the full
+			// hierarchy could be used since you could have mulitple classes
+			// of the same name when they are in different scopes.
+			return entity.getName() + entity.getParent().getName();
+		}
+	}
+
+	return sanitizeName(entity);
+}
+
+void BindingGenerator::generateStorageFunction(FunctionEntity& entity)
+{
+	inStorage = true;
+	generateNativeDeclaration(entity);
+
+	// The object is destroyed, but the storage is left for the caller to free or reuse.
+	if(entity.getType() == FunctionEntity::Type::Destructor)
+	{
+		file << "public void destroyInPlace() {\n";
+		file << entity.getStorageBridgeName(true) << "(mObjectHandle);\n";
+		file << "mObjectHandle = " << getNullHandle() << ";\n}\n\n";
+	}
+
+	// The storage overload returns an object that doesn't own its storage.
+	else
+	{
+		file << "public " << (entity.isOverridable() ? "" : "final ");
+		entity.generateReturnType(*this, false);
+		file << getMethodName(entity) << '(';
+		entity.generateParameters(*this, false, false);
+		file << (entity.getParameterCount() > 0 ? ", " : "") << getStorageType() << " storage) {\n";
+
+		bool closeParenthesis = entity.generateReturnStatement(*this, false);
+		ownedReturn = false;
+
+		file << entity.getStorageBridgeName(true) << '(';
+		onlyParameterNames = true;
+		generateStorageParameter(entity);
+		entity.generateParameters(*this, false, true);
+		onlyParameterNames = false;
+		file << ')';
+
+		if(closeParenthesis)
+		{
+			file << ')';
+		}
+
+		file << ";\n}\n\n";
+	}
+
+	generateNativeImplementation(entity);
+	inStorage = false;
+}
+
+bool BindingGenerator::takesStorage(FunctionEntity& entity)
+{
+	// Destructors destroy objects in place and take no storage.
+	return inStorage && entity.getType() != FunctionEntity::Type::Destructor;
+}
+
+void BindingGenerator::generateStorageParameter(FunctionEntity& entity)
+{
+	if(!takesStorage(entity))
+	{
+		return;
+	}
+
+	auto& output = inJni ? jni : file;
+
+	if(inExtern)
+	{
+		output << "void* AG_storage";
+	}
+
+	else if(inJni)
+	{
+		output << (onlyParameterNames ? "env->GetDirectBufferAddress(storage)" : "jobject storage");
+	}
+
+	else
+	{
+		output << (onlyParameterNames ? "storage" : getStorageType() + std::string(" storage"));
+	}
+
+	if(entity.getParameterCount(true) > 0)
+	{
+		output << ", ";
+	}
+}
+
+const char* BindingGenerator::getStorageType()
+{
+	return "java.nio.ByteBuffer";
+}
+
+void BindingGenerator::generateBatchedFunction(FunctionEntity& entity)
+{
+	generateBatchedNative(entity);
+
+	auto returned = entity.getReturnType(true);
+	std::string returnType = entity.returnsValue() ?
+		getBatchedElementJava(returned.getPrimitiveType().getType()) + std::string("[]") : "void";
+
+	// Every argument is either an array with an element for each object or a
+	// single value that is broadcast to every object.
+	for(bool broadcast : { false, true })
+	{
+		if(broadcast && entity.getParameterCount() == 0)
+		{
+			break;
+		}
+
+		file << "public static " << returnType << ' ' << sanitizeName(entity) << "Batch(" <<
+				packagePrefix << '.' << entity.getParent().getHierarchy(".") << "[] objects";
+
+		for(size_t i = 0; i < entity.getParameterCount(); i++)
+		{
+			auto& param = entity.getParameter(i);
+			file << ", " << getBatchedElementJava(getBatchedElement(param)) << (broadcast ? " " : "[] ") <<
+					sanitizeName(param);
+		}
+
+		file << ") {\n";
+
+		if(!broadcast)
+		{
+			for(size_t i = 0; i < entity.getParameterCount(); i++)
+			{
+				auto name = sanitizeName(entity.getParameter(i));
+				file << "if(" << name << ".length != objects.length) {\n";
+				file << "throw new IllegalArgumentException(\"" << name << " doesn't have an element for each object\");\n}\n";
+			}
+		}
+
+		file << (entity.returnsValue() ? "return " : "") << entity.getBatchBridgeName(true) << "(objects, " <<
+				(broadcast ? ~0ULL >> (64 - entity.getParameterCount()) : 0) << "L";
+
+		for(size_t i = 0; i < entity.getParameterCount(); i++)
+		{
+			auto& param = entity.getParameter(i);
+			file << ", ";
+
+			if(broadcast)
+			{
+				file << "new " << getBatchedElementJava(getBatchedElement(param)) << "[] { " << sanitizeName(param) << " }";
+			}
+
+			else
+			{
+				file << sanitizeName(param);
+			}
+		}
+
+		file << ");\n}\n\n";
+	}
+}
+
+void BindingGenerator::generateBatchedNative(FunctionEntity& entity)
+{
+	auto bridgeName = entity.getBatchBridgeName();
+	auto nativeName = entity.getBatchBridgeName(true);
+	auto returned = entity.getReturnType(true);
+
+	std::string results = entity.returnsValue() ? getBatchedElementJava(returned.getPrimitiveType().getType()) : "";
+	std::string elementsJava;
+	std::string descriptor = "([JJ";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		auto element = getBatchedElement(param);
+
+		elementsJava += std::string(", ") + getBatchedElementJava(element) + "[] " + sanitizeName(param);
+		descriptor += std::string("[") + getTypeDescriptorJNI(param, packagePrefix);
+	}
+
+	if(!results.empty())
+	{
+		descriptor += '[' + getTypeDescriptorJNI(returned, packagePrefix);
+	}
+
+	descriptor += ")V";
+
+	// The native method receives the addresses of the objects.
+	file << "private static native void " << nativeName << "(long[] objects, long broadcast" << elementsJava <<
+			(results.empty() ? "" : ", " + results + "[] results") << ");\n\n";
+
+	file << "private static " << (results.empty() ? "void" : results + "[]") << ' ' << nativeName << '(' <<
+			packagePrefix << '.' << entity.getParent().getHierarchy(".") << "[] objects, long broadcast" <<
+			elementsJava << ") {\n";
+
+	file << "long[] AG_handles = new long[objects.length];\n";
+	file << "for(int AG_i = 0; AG_i < objects.length; AG_i++) {\n";
+	file << "AG_handles[AG_i] = objects[AG_i].getObjectHandle();\n}\n\n";
+
+	if(!results.empty())
+	{
+		file << results << "[] AG_results = new " << results << "[objects.length];\n";
+	}
+
+	file << nativeName << "(AG_handles, broadcast";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		file << ", " << sanitizeName(entity.getParameter(i));
+	}
+
+	file << (results.empty() ? "" : ", AG_results") << ");\n";
+
+	// The objects own the native objects, so they have to stay alive during the call.
+	file << "java.lang.ref.Reference.reachabilityFence(objects);\n";
+
+	if(!results.empty())
+	{
+		file << "return AG_results;\n";
+	}
+
+	file << "}\n\n";
+
+	// Write the JNI glue calling the batched bridge function.
+	std::string externParameters = "void** AG_objects, size_t AG_count, uint64_t AG_broadcast";
+	std::string jniParameters = "jlongArray objects, jlong broadcast";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		auto element = getBatchedElement(param);
+
+		externParameters += std::string(", const ") + getPrimitiveNameJNI(element, true) + "* " + param.getName();
+		jniParameters += ", " + getArrayTypeJNI(element) + ' ' + param.getName();
+	}
+
+	if(!results.empty())
+	{
+		externParameters += std::string(", ") + getPrimitiveNameJNI(returned.getPrimitiveType().getType(), true) +
+							"* AG_results";
+		jniParameters += ", " + getArrayTypeJNI(returned.getPrimitiveType().getType()) + " results";
+	}
+
+	if(entity.isThrowing())
+	{
+		externParameters += ", AG_Error* AG_error";
+	}
+
+	if(callMode == CallMode::BridgeTable)
+	{
+		ensureBridgeTableAccess();
+		assert(getBackend().getBridgeTable().getIndex(bridgeName) != BridgeTable::npos);
+	}
+
+	else
+	{
+		jni << "extern \"C\" void " << bridgeName << '(' << externParameters << ");\n";
+	}
+
+	auto jniName = "Java_" + packagePrefix + "_" + getEntityPathJNI(entity.getParent()) + "_" +
+					getEscapedNameJNI(nativeName);
+
+	auto classPath = packagePrefix + '/' + getClassPathJNI(entity.getParent());
+	std::replace(classPath.begin(), classPath.end(), '.', '/');
+	addNative(classPath, { nativeName, descriptor, jniName });
+
+	jni << "static void JNICALL " << jniName << "(JNIEnv* env, jclass, " << jniParameters << ")\n{\n";
+
+	// The exception is thrown after the arrays have been released.
+	if(entity.isThrowing())
+	{
+		jni << "JavaError AG_error(env);\n";
+	}
+
+	jni << "jlong* AG_addresses = env->GetLongArrayElements(objects, nullptr);\n";
+	jni << "std::vector <void*> AG_handles(static_cast <size_t> (env->GetArrayLength(objects)));\n";
+	jni << "for(size_t AG_i = 0; AG_i < AG_handles.size(); AG_i++) { AG_handles[AG_i] = reinterpret_cast <void*> (AG_addresses[AG_i]); }\n";
+	jni << "env->ReleaseLongArrayElements(objects, AG_addresses, JNI_ABORT);\n";
+
+	// Only functions that can't call back into Java can access the arrays in a critical region.
+	const char* critical = entity.isLeaf() ? "true" : "false";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		jni << "JavaArray <" << getArrayTypeJNI(getBatchedElement(param)) << "> AG_" << param.getName() <<
+				"(env, " << param.getName() << ", " << critical << ");\n";
+	}
+
+	if(!results.empty())
+	{
+		jni << "JavaArray <" << getArrayTypeJNI(returned.getPrimitiveType().getType()) <<
+				"> AG_results(env, results, " << critical << ");\n";
+	}
+
+	jni << (callMode == CallMode::BridgeTable ? "AG_getBridges()." : "") << bridgeName <<
+			"(AG_handles.data(), AG_handles.size(), static_cast <uint64_t> (broadcast)";
 
-	// Generate a constructor for the enum that takes an integer.
-	file << "private " << entity.getName() << "(int value) {\nmValue = value;\n}\n\n";
-	file << "private int mValue;\n}\n\n";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		jni << ", static_cast <const " << getPrimitiveNameJNI(getBatchedElement(param), true) << "*> (AG_" <<
+				param.getName() << ".view.data)";
+	}
 
-	// Since each top level enum goes to its own file,
-	// close the current file if a top level enum is being ended.
-	if(getClassDepth() == 0)
+	if(!results.empty())
 	{
-		assert(file.is_open());
-		file.close();
+		jni << ", static_cast <" << getPrimitiveNameJNI(returned.getPrimitiveType().getType(), true) <<
+				"*> (AG_results.view.data)";
 	}
+
+	jni << (entity.isThrowing() ? ", &AG_error.error" : "") << ");\n}\n\n";
 }
 
-void BindingGenerator::generateEnumEntry(EnumEntryEntity& entity)
+std::string BindingGenerator::getFutureType(FunctionEntity& entity)
 {
-	// Generate enum values.
-	file << sanitizeName(entity) << '(' << entity.getValue() << ')'
-		<< (entity.isLast() ? ";\n" : ",\n");
+	auto returned = entity.getReturnType(true);
+	auto type = entity.returnsValue() ? returned.getPrimitiveType().getType() : PrimitiveEntity::Type::Void;
+
+	return "java.util.concurrent.CompletableFuture <" + std::string(getBoxedNameJava(type)) + '>';
 }
 
-void BindingGenerator::generateFunction(FunctionEntity& entity)
+void BindingGenerator::generateAsyncFunction(FunctionEntity& entity)
 {
-	// TODO: Implement Java destructors.
-	if(entity.getType() == FunctionEntity::Type::Destructor)
-	{
-		return;
-	}
+	generateAsyncNative(entity);
+	auto futureType = getFutureType(entity);
 
-	// TODO: Generate function overloads with the appropriate names.
-	if(entity.getOverloadedOperator() != FunctionEntity::OverloadedOperator::None)
+	file << "public " << (entity.isStatic() ? "static " : "final ") << futureType << ' ' <<
+			getMethodName(entity) << "Async(";
+	entity.generateParameters(*this, false, false);
+	file << ") {\n";
+
+	file << futureType << " AG_future = new java.util.concurrent.CompletableFuture <> ();\n";
+
+	// The future keeps the object alive until the call has completed.
+	if(!entity.isStatic())
 	{
-		return;
+		file << "AG_future.whenComplete((result, error) -> java.lang.ref.Reference.reachabilityFence(this));\n";
 	}
 
-	std::string nativeName = entity.getBridgeName(true);
+	file << entity.getAsyncBridgeName(true) << '(';
 
-	// Declare a native method.
-	file << "private static native ";
-	entity.generateReturnType(*this, true);
-	file << nativeName << "(";
+	onlyParameterNames = true;
+	entity.generateParameters(*this, false, true);
+	onlyParameterNames = false;
 
+	file << (entity.getParameterCount(true) > 0 ? ", " : "") << "AG_future);\n";
+	file << "return AG_future;\n}\n\n";
+}
+
+void BindingGenerator::generateAsyncNative(FunctionEntity& entity)
+{
+	auto bridgeName = entity.getAsyncBridgeName();
+	auto nativeName = entity.getAsyncBridgeName(true);
+	auto completeName = "AG_complete_" + entity.getBridgeName(true);
+	auto futureType = getFutureType(entity);
+
+	auto returned = entity.getReturnType(true);
+	auto returnType = entity.returnsValue() ? returned.getPrimitiveType().getType() : PrimitiveEntity::Type::Void;
+	const char* separator = entity.getParameterCount(true) > 0 ? ", " : "";
+
+	inNative = true;
+	file << "private static native void " << nativeName << '(';
 	entity.generateParameters(*this, true, true);
-	file << ");\n\n";
+	file << separator << futureType << " future);\n\n";
 
-	// Mark overriding function appropriately.
-	if(entity.isOverride())
+	// The JNI glue calls this on the worker thread once the call has completed.
+	file << "private static void " << completeName << '(' << futureType << " future, String error";
+
+	if(entity.returnsValue())
 	{
-		file << "@Override\n";
+		TypeReferenceEntity result("result", returned.getReferredPtr(), false);
+		file << ", ";
+		generateTyperefJava(result);
 	}
 
-	// Write the method signature.
-	file << "public ";
+	inNative = false;
 
-	if(entity.getType() != FunctionEntity::Type::Constructor)
-	{
-		if(!entity.isOverridable())
-		{
-			file << "final ";
-		}
+	file << ") {\n";
+	file << "if(error != null) {\n";
+	file << "future.completeExceptionally(new RuntimeException(error));\n";
+	file << "} else {\n";
+	file << "future.complete(" << (entity.returnsValue() ? "result" : "null") << ");\n}\n}\n\n";
 
-		entity.generateReturnType(*this, false);
-	}
+	// Write the JNI glue calling the asynchronous bridge function.
+	ensureCallableAccessJNI();
+	inJni = true;
 
-	std::string functionName;
+	std::string completion = "void (*AG_complete)(void*, const char*" +
+		(entity.returnsValue() ? std::string(", ") + getPrimitiveNameJNI(returnType, true) : "") + "), void* AG_context";
 
-	// Name constructors with the class name.
-	if(entity.getType() == FunctionEntity::Type::Constructor)
+	if(callMode == CallMode::BridgeTable)
 	{
-		functionName = entity.getParent().getName();
+		ensureBridgeTableAccess();
+		assert(getBackend().getBridgeTable().getIndex(bridgeName) != BridgeTable::npos);
 	}
 
-	// If this class member function isn't an override, there's a possibility of a name clash.
-	else if(entity.isClassMemberFunction() && !entity.isOverride())
+	else
 	{
-		auto clashing = findClashing(entity, static_cast <TypeEntity&> (entity.getParent()), 0);
-
-		if(clashing)
-		{
-			// TODO: Instead of just using the parent class name, the full
-			// hierarchy could be used since you could have mulitple classes
-			// of the same name when they are in different scopes.
-			functionName = entity.getName() + entity.getParent().getName();
-		}
+		inExtern = true;
+		jni << "extern \"C\" void " << bridgeName << '(';
+		entity.generateParameters(*this, true, true);
+		jni << separator << completion << ");\n";
+		inExtern = false;
 	}
 
-	if(functionName.empty())
+	auto variable = "AG_" + bridgeName;
+	jni << "static jclass " << variable << "_class;\n";
+	jni << "static jmethodID " << variable << "_method;\n";
+
+	// The worker thread might not be attached to the JVM yet. The future is
+	// referenced globally until the call completes.
+	jni << "static void " << variable << "_complete(void* context, const char* error" <<
+			(entity.returnsValue() ? std::string(", ") + getPrimitiveNameJNI(returnType, true) + " result" : "") << ")\n{\n";
+	jni << "JNIEnv* env = AG_getEnv();\n";
+	jni << "jstring message = error ? env->NewStringUTF(error) : nullptr;\n";
+	jni << "env->CallStaticVoidMethod(" << variable << "_class, " << variable << "_method, static_cast <jobject> (context), message";
+
+	if(entity.returnsValue())
 	{
-		functionName = sanitizeName(entity);
+		jni << ", static_cast <" << getPrimitiveNameJNI(returnType, false) << "> (result)";
 	}
 
-	file << functionName << '(';
-	entity.generateParameters(*this, false, false);
-	file << ") {\n";
+	jni << ");\n";
+	jni << "if(message) { env->DeleteLocalRef(message); }\n";
+	jni << "env->DeleteGlobalRef(static_cast <jobject> (context));\n}\n";
 
-	bool closeParenthesis = entity.generateReturnStatement(*this, false);
-	file << nativeName << "(";
+	auto jniName = "Java_" + packagePrefix + "_" + getEntityPathJNI(entity.getParent()) + "_" +
+					getEscapedNameJNI(nativeName);
+
+	jni << "static void JNICALL " << jniName << "(JNIEnv* env, jclass" << separator;
+	entity.generateParameters(*this, true, true);
+	jni << ", jobject future)\n{\n";
+
+	jni << (callMode == CallMode::BridgeTable ? "AG_getBridges()." : "") << bridgeName << '(';
 
-	// Call the native method with the passed parameters.
 	onlyParameterNames = true;
-	entity.generateParameters(*this, false, true);
+	entity.generateParameters(*this, true, true);
 	onlyParameterNames = false;
-	file << ")";
 
-	if(closeParenthesis)
+	jni << separator << '&' << variable << "_complete, env->NewGlobalRef(future));\n}\n\n";
+	inJni = false;
+
+	// The completion method is looked up when the JNI glue is loaded.
+	auto classPath = packagePrefix + '/' + getClassPathJNI(entity.getParent());
+	std::replace(classPath.begin(), classPath.end(), '.', '/');
+
+	std::string descriptor = "(";
+	if(entity.getParameterCount(true) > entity.getParameterCount())
 	{
-		file << ")";
+		descriptor += 'J';
 	}
 
-	// Close the function.
-	file << ";\n}\n\n";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		descriptor += getTypeDescriptorJNI(entity.getParameter(i), packagePrefix);
+	}
+
+	addNative(classPath, { nativeName, descriptor + "Ljava/util/concurrent/CompletableFuture;)V", jniName });
+
+	TypeReferenceEntity result("", returned.getReferredPtr(), false);
+	asyncCompletions.push_back({ classPath, { completeName, "(Ljava/util/concurrent/CompletableFuture;Ljava/lang/String;" +
+		(entity.returnsValue() ? getTypeDescriptorJNI(result, packagePrefix) : "") + ")V", variable } });
+}
+
+void BindingGenerator::generateField(FieldEntity& entity)
+{
+	// JNI can't access the memory of a native object, so fields are always accessed through bridge functions.
+	generateFunction(entity.getGetter());
+
+	if(!entity.isReadOnly())
+	{
+		generateFunction(entity.getSetter());
+	}
+}
+
+void BindingGenerator::generateNativeDeclaration(FunctionEntity& entity)
+{
+	// Declare a native method.
+	inNative = true;
+	file << "private static native ";
+	entity.generateReturnType(*this, true);
+	file << (inStorage ? entity.getStorageBridgeName(true) : entity.getBridgeName(true)) << "(";
+
+	generateStorageParameter(entity);
+	entity.generateParameters(*this, true, true);
+	file << ");\n\n";
+	inNative = false;
+}
+
+void BindingGenerator::generateInterceptionSetup(FunctionEntity&)
+{
+}
 
+void BindingGenerator::generateNativeImplementation(FunctionEntity& entity)
+{
 	// JNI is written next.
+	ensureValueTypesJNI(entity);
+	ensureCallablesJNI(entity);
 	inJni = true;
-	auto bridgeName = entity.getBridgeName();
+	auto bridgeName = inStorage ? entity.getStorageBridgeName() : entity.getBridgeName();
+
+	if(callMode == CallMode::BridgeTable)
+	{
+		ensureBridgeTableAccess();
+		assert(getBackend().getBridgeTable().getIndex(bridgeName) != BridgeTable::npos);
+	}
 
 	// Locate the external bridge function.
-	inExtern = true;
-	jni << "extern \"C\" ";
-	entity.generateReturnType(*this, true);
-	jni << ' ' << bridgeName << "(";
-	entity.generateParameters(*this, true, true);
-	inExtern = false;
-	jni << ");\n";
+	else
+	{
+		inExtern = true;
+		jni << "extern \"C\" ";
+		entity.generateReturnType(*this, true);
+		jni << ' ' << bridgeName << "(";
+		generateStorageParameter(entity);
+		entity.generateParameters(*this, true, true);
+		inExtern = false;
+
+		if(entity.isThrowing())
+		{
+			jni << (entity.getParameterCount(true) > 0 || takesStorage(entity) ? ", " : "") << "AG_Error* AG_error";
+		}
+
+		jni << ");\n";
+	}
+
+	// Declare the function in JNI. It doesn't need to be exported
+	// since JNI_OnLoad registers it with RegisterNatives.
+	auto jniName = "Java_" + packagePrefix + "_" + getFunctionNameJNI(entity) + (inStorage ? "_1AG_1storage" : "");
+	addNative(entity, jniName);
 
-	// Declare the function in JNI.
-	jni << "extern \"C\" JNIEXPORT ";
+	jni << "static ";
 	entity.generateReturnType(*this, true);
 	jni << "JNICALL ";
 
 	// Declare the JNI function with the appropriate parameters.
-	jni << "Java_" << packagePrefix << "_" << getFunctionNameJNI(entity) << "(JNIEnv* env, jclass";
+	jni << jniName << "(JNIEnv* env, jclass";
 
 	// If there are more arguments, add a comma.
-	if(entity.getParameterCount(true) > 0)
+	if(entity.getParameterCount(true) > 0 || takesStorage(entity))
 	{
 		jni << ", ";
 	}
 
+	generateStorageParameter(entity);
 	entity.generateParameters(*this, true, true);
 	jni << ")\n{\n";
 
-	closeParenthesis = entity.generateReturnStatement(*this, true);
+	// The error slot outlives the result conversion so that Java sees the exception last.
+	if(entity.isThrowing())
+	{
+		jni << "JavaError AG_error(env);\n";
+	}
+
+	bool closeParenthesis = entity.generateReturnStatement(*this, true);
+
+	if(callMode == CallMode::BridgeTable)
+	{
+		jni << "AG_getBridges().";
+	}
+
 	jni << bridgeName << '(';
 
+	// Functions that can call back into Java can't be called in a critical region.
+	criticalArrays = entity.isLeaf() && !entity.isOverridable() && !entity.isOverride();
 	onlyParameterNames = true;
+	generateStorageParameter(entity);
 	entity.generateParameters(*this, true, true);
 	onlyParameterNames = false;
 
+	if(entity.isThrowing())
+	{
+		jni << (entity.getParameterCount(true) > 0 || takesStorage(entity) ? ", " : "") << "&AG_error.error";
+	}
+
 	jni << ')';
 
 	if(closeParenthesis)
@@ -387,9 +2206,12 @@ void BindingGenerator::generateTypeAlias(TypeAliasEntity& entity)
 	// TODO: In order to make the type alias instantiable, generate constructors from the aliased type.
 	// No JNI code is required from them as they just would call super().
 
-	file << "public " << entity.getName() << "(long objectHandle) {\n";
+	file << "public " << entity.getName() << "(" << getHandleType() << " objectHandle) {\n";
 	file << "super(objectHandle);\n}\n";
 
+	file << "public " << entity.getName() << "(" << getHandleType() << " objectHandle, boolean owned) {\n";
+	file << "super(objectHandle, owned);\n}\n";
+
 	// Generate delegating constructors if the type alias points to a class.
 	if(finalUnderlying->getType() == TypeEntity::Type::Class)
 	{
@@ -489,6 +2311,30 @@ void BindingGenerator::generateTyperefJNI(TypeReferenceEntity& entity)
 	// Function calls in the JNI are always calls to bridge functions.
 	if(onlyParameterNames)
 	{
+		// Value types are put together from their fields.
+		if(isValueType(entity))
+		{
+			auto& value = entity.getClassType();
+			jni << getValueNameJNI(value) << " { ";
+
+			for(size_t i = 0; i < value.getValueFieldCount(); i++)
+			{
+				auto& field = value.getValueField(i);
+				jni << (i > 0 ? ", " : "") << "static_cast <" << getPrimitiveNameJNI(field.type->getType(), true) <<
+						"> (" << entity.getName() << '_' << field.name << ')';
+			}
+
+			jni << " }";
+			return;
+		}
+
+		// Java objects implementing a functional interface are called through a trampoline.
+		if(entity.getType() == TypeEntity::Type::Callable)
+		{
+			jni << "AG_" << entity.getReferred().getName() << "_fromJava(env, " << entity.getName() << ')';
+			return;
+		}
+
 		assert(entity.isPrimitive());
 
 		// Treat object handles as opaque pointers.
@@ -499,7 +2345,13 @@ void BindingGenerator::generateTyperefJNI(TypeReferenceEntity& entity)
 
 		else if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
 		{
-			jni << "JavaString(env, " << entity.getName() << ").cString";
+			jni << "JavaString(env, " << entity.getName() << ").view";
+		}
+
+		else if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
+		{
+			jni << "JavaArray <" << getArrayTypeJNI(entity.getPrimitiveType().getElementType()) << "> (env, " << entity.getName() << ", " <<
+					(criticalArrays ? "true" : "false") << ").view";
 		}
 
 		else
@@ -516,6 +2368,28 @@ void BindingGenerator::generateTyperefJNI(TypeReferenceEntity& entity)
 			case TypeEntity::Type::Alias:
 			case TypeEntity::Type::Class:
 			{
+				if(isValueType(entity))
+				{
+					auto& value = entity.getClassType();
+
+					// Value types are returned as bytes.
+					if(inExtern || entity.getName().empty())
+					{
+						jni << (inExtern ? getValueNameJNI(value) : "jbyteArray") << ' ' << entity.getName();
+						break;
+					}
+
+					// Value type parameters are passed as their fields.
+					for(size_t i = 0; i < value.getValueFieldCount(); i++)
+					{
+						auto& field = value.getValueField(i);
+						jni << (i > 0 ? ", " : "") << getPrimitiveNameJNI(field.type->getType(), false) << ' ' <<
+								entity.getName() << '_' << field.name;
+					}
+
+					break;
+				}
+
 				jni << (inExtern ? "void*" : "jlong ") << entity.getName();
 				break;
 			}
@@ -528,27 +2402,24 @@ void BindingGenerator::generateTyperefJNI(TypeReferenceEntity& entity)
 
 			case TypeEntity::Type::Primitive:
 			{
-				const char* typeName = "";
+				auto primitive = entity.getPrimitiveType().getType();
 
-				switch(entity.getPrimitiveType().getType())
+				if(primitive == PrimitiveEntity::Type::Buffer && !inExtern)
 				{
-					case PrimitiveEntity::Type::ObjectHandle: typeName = inExtern ? "void*" : "jlong"; break;
-					case PrimitiveEntity::Type::Integer: typeName = inExtern ? "int" : "jint"; break;
-					case PrimitiveEntity::Type::Character: typeName = inExtern ? "char" : "jchar"; break;
-					case PrimitiveEntity::Type::Boolean: typeName = inExtern ? "bool" : "jboolean"; break;
-					case PrimitiveEntity::Type::Float: typeName = inExtern ? "float" : "jfloat"; break;
-					case PrimitiveEntity::Type::Double: typeName = inExtern ? "double" : "jdouble"; break;
-					case PrimitiveEntity::Type::Void: typeName = inExtern ? "void" : "void"; break;
-					case PrimitiveEntity::Type::String: typeName = inExtern ? "const char*" : "jstring"; break;
+					jni << (isBorrowedBuffer(entity) ? "jobject" : getArrayTypeJNI(entity.getPrimitiveType().getElementType())) <<
+							' ' << entity.getName();
+					return;
 				}
 
-				jni << typeName << ' ' << entity.getName();
+				jni << getPrimitiveNameJNI(primitive, inExtern) << ' ' << entity.getName();
 				break;
 			}
 
+			// Callables are received as Java objects and returned as the fields of AG_Callable.
 			case TypeEntity::Type::Callable:
 			{
-				// TODO: Something here?
+				jni << (inExtern ? "AG_Callable " : entity.getName().empty() ? "jlongArray " : "jobject ") << entity.getName();
+				break;
 			}
 		}
 	}
@@ -577,7 +2448,21 @@ void BindingGenerator::generateTyperefJava(TypeReferenceEntity& entity)
 
 			case TypeEntity::Type::Class:
 			{
-				file << ".getObjectHandle()";
+				if(!entity.getClassType().isValueType())
+				{
+					file << (entity.isConsumed() ? ".takeObjectHandle()" : ".getObjectHandle()");
+				}
+
+				// Value types are passed to the JNI glue as their fields.
+				else if(flattenValues)
+				{
+					auto& value = entity.getClassType();
+					for(size_t i = 0; i < value.getValueFieldCount(); i++)
+					{
+						file << (i > 0 ? ", " + sanitizeName(entity) : "") << '.' << value.getValueField(i).name;
+					}
+				}
+
 				break;
 			}
 
@@ -599,19 +2484,74 @@ void BindingGenerator::generateTyperefJava(TypeReferenceEntity& entity)
 
 			switch(entity.getPrimitiveType().getType())
 			{
-				case PrimitiveEntity::Type::ObjectHandle: typeName = "long"; break;
+				case PrimitiveEntity::Type::ObjectHandle: typeName = getHandleType(); break;
 				case PrimitiveEntity::Type::Integer: typeName = "int"; break;
+				case PrimitiveEntity::Type::Int8: case PrimitiveEntity::Type::UInt8: typeName = "byte"; break;
+				case PrimitiveEntity::Type::Int16: case PrimitiveEntity::Type::UInt16: typeName = "short"; break;
+				case PrimitiveEntity::Type::UInt32: typeName = "int"; break;
+				case PrimitiveEntity::Type::Int64: case PrimitiveEntity::Type::UInt64: typeName = "long"; break;
+				case PrimitiveEntity::Type::IntPtr: case PrimitiveEntity::Type::UIntPtr: typeName = "long"; break;
 				case PrimitiveEntity::Type::Character: typeName = "char"; break;
 				case PrimitiveEntity::Type::Boolean: typeName = "boolean"; break;
 				case PrimitiveEntity::Type::Float: typeName = "float"; break;
 				case PrimitiveEntity::Type::Double: typeName = "double"; break;
 				case PrimitiveEntity::Type::String: typeName = "String"; break;
 				case PrimitiveEntity::Type::Void: typeName = "void"; break;
+
+				case PrimitiveEntity::Type::Buffer:
+				{
+					// Borrowed buffers are views of the native elements, which
+					// the native methods of the JNI glue return as byte buffers.
+					if(isBorrowedBuffer(entity))
+					{
+						typeName = inNative && flattenValues ? "java.nio.ByteBuffer" :
+									getViewTypeJava(entity.getPrimitiveType().getElementType());
+						break;
+					}
+
+					switch(entity.getPrimitiveType().getElementType())
+					{
+						case PrimitiveEntity::Type::Integer: typeName = "int[]"; break;
+						case PrimitiveEntity::Type::Float: typeName = "float[]"; break;
+						case PrimitiveEntity::Type::Double: typeName = "double[]"; break;
+						case PrimitiveEntity::Type::Character: typeName = "byte[]"; break;
+						default: break;
+					}
+
+					break;
+				}
 			}
 
 			file << typeName << ' ' << sanitizeName(entity);
 		}
 
+		// The native methods of the JNI glue return callables as the fields of AG_Callable.
+		else if(inNative && flattenValues && entity.getType() == TypeEntity::Type::Callable && entity.getName().empty())
+		{
+			file << "long[] ";
+		}
+
+		// The native methods of the JNI glue receive value types as their fields and return them as bytes.
+		else if(inNative && flattenValues && isValueType(entity))
+		{
+			auto& value = entity.getClassType();
+
+			if(entity.getName().empty())
+			{
+				file << "byte[] ";
+				return;
+			}
+
+			for(size_t i = 0; i < value.getValueFieldCount(); i++)
+			{
+				auto& field = value.getValueField(i);
+				TypeReferenceEntity fieldType(sanitizeName(entity) + '_' + field.name, field.type, false);
+
+				file << (i > 0 ? ", " : "");
+				generateTyperefJava(fieldType);
+			}
+		}
+
 		else
 		{
 			file << packagePrefix << '.' << entity.getReferred().getHierarchy(".") << ' ' << sanitizeName(entity);
@@ -619,6 +2559,27 @@ void BindingGenerator::generateTyperefJava(TypeReferenceEntity& entity)
 	}
 }
 
+const char* BindingGenerator::getHandleType()
+{
+	return "long";
+}
+
+const char* BindingGenerator::getNullHandle()
+{
+	return "0";
+}
+
+std::string BindingGenerator::getHandleAddress(std::string_view handle)
+{
+	return std::string(handle);
+}
+
+std::string_view BindingGenerator::getObjectHandleName()
+{
+	// The Java side calls native methods with the stored object handle.
+	return onlyParameterNames && !inJni ? "mObjectHandle" : "objectHandle";
+}
+
 std::string BindingGenerator::sanitizeName(Entity& entity)
 {
 	auto name = entity.getName();
@@ -708,9 +2669,22 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity& entity, Func
 {
 	if(inJni)
 	{
-		assert(entity.isPrimitive());
 		jni << "return ";
 
+		if(isValueType(entity))
+		{
+			jni << "toJavaValue(env, ";
+			return true;
+		}
+
+		if(entity.getType() == TypeEntity::Type::Callable)
+		{
+			jni << "toJavaCallable(env, ";
+			return true;
+		}
+
+		assert(entity.isPrimitive());
+
 		if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::ObjectHandle)
 		{
 			jni << "reinterpret_cast <jlong> (";
@@ -719,7 +2693,20 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity& entity, Func
 
 		else if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::String)
 		{
-			jni << "env->NewStringUTF(";
+			jni << "toJavaString(env, ";
+			return true;
+		}
+
+		else if(isBorrowedBuffer(entity))
+		{
+			std::string array = getArrayTypeJNI(entity.getPrimitiveType().getElementType());
+			jni << "toJavaView <" << array.substr(0, array.size() - 5) << "> (env, ";
+			return true;
+		}
+
+		else if(entity.getPrimitiveType().getType() == PrimitiveEntity::Type::Buffer)
+		{
+			jni << "toJava" << getArrayNameJNI(entity.getPrimitiveType().getElementType()) << "Array(env, ";
 			return true;
 		}
 	}
@@ -729,6 +2716,9 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity& entity, Func
 		// Constructors don't return, but instead call the constructor taking an object handle.
 		if(target.getType() == FunctionEntity::Type::Constructor)
 		{
+			assert(ClassEntity::matchType(target.getParent()));
+			ownedReturn = getDestructorIndex(static_cast <ClassEntity&> (target.getParent())) >= 0;
+
 			file << "this(";
 			return true;
 		}
@@ -745,6 +2735,20 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity& entity, Func
 
 			case TypeEntity::Type::Class:
 			{
+				// Value types are decoded from the bytes returned by the JNI glue.
+				if(entity.getClassType().isValueType())
+				{
+					file << "return ";
+
+					if(flattenValues)
+					{
+						file << packagePrefix << '.' << entity.getReferred().getHierarchy(".") << ".AG_fromBytes(";
+						return true;
+					}
+
+					return false;
+				}
+
 				// TODO: Until type extension support is generated, don't instantiate abstract classes.
 				if(entity.getClassType().isAbstract())
 				{
@@ -752,6 +2756,19 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity& entity, Func
 					return false;
 				}
 
+				// Objects returned by value are copied to the heap by the glue code,
+				// whereas references are borrowed.
+				ownedReturn = !entity.isReference() && getDestructorIndex(entity.getClassType()) >= 0;
+
+				// The identity cache returns the existing wrapper of the object if there is one.
+				if(identityCache)
+				{
+					file << "return " << packagePrefix << '.' <<
+							target.getReturnType().getReferred().getHierarchy(".") << ".AG_wrap(";
+
+					return true;
+				}
+
 				// For a class return value, instantiate new Java objects holding the resulting pointer.
 				file << "return new " << packagePrefix << '.' <<
 						target.getReturnType().getReferred().getHierarchy(".") << '(';
@@ -768,9 +2785,30 @@ bool BindingGenerator::generateReturnStatement(TypeReferenceEntity& entity, Func
 			}
 
 			case TypeEntity::Type::Primitive:
+			{
+				file << "return ";
+
+				// The JNI glue returns borrowed buffers as byte buffers which are viewed as the element type.
+				if(flattenValues && isBorrowedBuffer(entity))
+				{
+					file << getViewConversion(entity.getPrimitiveType().getElementType()) << '(';
+					return true;
+				}
+
+				break;
+			}
+
 			case TypeEntity::Type::Callable:
 			{
 				file << "return ";
+
+				// The JNI glue returns the fields of AG_Callable which are wrapped in a Java object.
+				if(flattenValues)
+				{
+					file << packagePrefix << ".AG_" << entity.getReferred().getName() << ".AG_fromNative(";
+					return true;
+				}
+
 				break;
 			}
 		}
@@ -0,0 +1,1477 @@
+#include <autoglue/java/ForeignBindingGenerator.hh>
+#include <autoglue/CallableTypeEntity.hh>
+#include <autoglue/TypeReferenceEntity.hh>
+#include <autoglue/TypeAliasEntity.hh>
+#include <autoglue/FunctionEntity.hh>
+#include <autoglue/FieldEntity.hh>
+#include <autoglue/ClassEntity.hh>
+#include <autoglue/TypeEntity.hh>
+
+#include <algorithm>
+#include <cassert>
+
+namespace ag::java
+{
+
+static std::string getLayout(PrimitiveEntity::Type type, const std::string& packagePrefix)
+{
+	switch(type)
+	{
+		// C++ char is a single byte unlike Java char.
+		case PrimitiveEntity::Type::Character: return "ValueLayout.JAVA_BYTE";
+		case PrimitiveEntity::Type::Integer: return "ValueLayout.JAVA_INT";
+		case PrimitiveEntity::Type::Int8: case PrimitiveEntity::Type::UInt8: return "ValueLayout.JAVA_BYTE";
+		case PrimitiveEntity::Type::Int16: case PrimitiveEntity::Type::UInt16: return "ValueLayout.JAVA_SHORT";
+		case PrimitiveEntity::Type::UInt32: return "ValueLayout.JAVA_INT";
+		case PrimitiveEntity::Type::Int64: case PrimitiveEntity::Type::UInt64: return "ValueLayout.JAVA_LONG";
+
+		case PrimitiveEntity::Type::IntPtr: case PrimitiveEntity::Type::UIntPtr: return packagePrefix + ".AG_Foreign.INTPTR";
+		case PrimitiveEntity::Type::Boolean: return "ValueLayout.JAVA_BOOLEAN";
+		case PrimitiveEntity::Type::Float: return "ValueLayout.JAVA_FLOAT";
+		case PrimitiveEntity::Type::Double: return "ValueLayout.JAVA_DOUBLE";
+		case PrimitiveEntity::Type::String: return packagePrefix + ".AG_Foreign.STRING";
+		case PrimitiveEntity::Type::Buffer: return packagePrefix + ".AG_Foreign.BUFFER";
+		case PrimitiveEntity::Type::ObjectHandle: return "ValueLayout.ADDRESS";
+		case PrimitiveEntity::Type::Void: return "";
+	}
+
+	return "";
+}
+
+static const char* getCarrierType(PrimitiveEntity::Type type)
+{
+	switch(type)
+	{
+		case PrimitiveEntity::Type::Character: return "byte";
+		case PrimitiveEntity::Type::Integer: return "int";
+		case PrimitiveEntity::Type::Int8: case PrimitiveEntity::Type::UInt8: return "byte";
+		case PrimitiveEntity::Type::Int16: case PrimitiveEntity::Type::UInt16: return "short";
+		case PrimitiveEntity::Type::UInt32: return "int";
+		case PrimitiveEntity::Type::Int64: case PrimitiveEntity::Type::UInt64: return "long";
+		case PrimitiveEntity::Type::IntPtr: case PrimitiveEntity::Type::UIntPtr: return "long";
+		case PrimitiveEntity::Type::Boolean: return "boolean";
+		case PrimitiveEntity::Type::Float: return "float";
+		case PrimitiveEntity::Type::Double: return "double";
+		case PrimitiveEntity::Type::String: return "MemorySegment";
+		case PrimitiveEntity::Type::Buffer: return "MemorySegment";
+		case PrimitiveEntity::Type::ObjectHandle: return "MemorySegment";
+		case PrimitiveEntity::Type::Void: return "void";
+	}
+
+	return "";
+}
+
+static bool isWord(PrimitiveEntity::Type type)
+{
+	return type == PrimitiveEntity::Type::IntPtr || type == PrimitiveEntity::Type::UIntPtr;
+}
+
+static std::string getMemory(PrimitiveEntity::Type type, const std::string& segment,
+							const std::string& offset, const std::string& packagePrefix)
+{
+	// Pointer sized integers are longs in Java whatever their native width is.
+	if(isWord(type))
+	{
+		return packagePrefix + ".AG_Foreign.getWord(" + segment + ", " + offset + ')';
+	}
+
+	return segment + ".get(" + getLayout(type, packagePrefix) + ", " + offset + ')';
+}
+
+static std::string setMemory(PrimitiveEntity::Type type, const std::string& segment,
+							const std::string& offset, const std::string& value, const std::string& packagePrefix)
+{
+	if(isWord(type))
+	{
+		return packagePrefix + ".AG_Foreign.setWord(" + segment + ", " + offset + ", " + value + ')';
+	}
+
+	return segment + ".set(" + getLayout(type, packagePrefix) + ", " + offset + ", " + value + ')';
+}
+
+static bool isValue(TypeReferenceEntity& entity)
+{
+	// Value types and callables are the only POD types that aren't primitives.
+	return !entity.getAsPOD().isPrimitive();
+}
+
+static std::string getLayout(TypeReferenceEntity& entity, const std::string& packagePrefix)
+{
+	if(entity.isCallable())
+	{
+		return packagePrefix + ".AG_Foreign.CALLABLE";
+	}
+
+	if(isValue(entity))
+	{
+		return packagePrefix + '.' + entity.getAsPOD().getReferred().getHierarchy(".") + ".AG_LAYOUT";
+	}
+
+	return getLayout(entity.getAsPOD().getPrimitiveType().getType(), packagePrefix);
+}
+
+static const char* getCarrierType(TypeReferenceEntity& entity)
+{
+	// Value types are passed in memory segments.
+	return isValue(entity) ? "MemorySegment" : getCarrierType(entity.getAsPOD().getPrimitiveType().getType());
+}
+
+static std::string getDefaultValue(TypeReferenceEntity& entity, const std::string& packagePrefix)
+{
+	std::string carrier = getCarrierType(entity);
+	if(carrier == "boolean")
+	{
+		return "false";
+	}
+
+	else if(carrier != "MemorySegment")
+	{
+		return "0";
+	}
+
+	// Structs such as strings and value types are returned as zeroed memory.
+	auto layout = getLayout(entity, packagePrefix);
+	return layout == "ValueLayout.ADDRESS" ? "MemorySegment.NULL" : "Arena.ofAuto().allocate(" + layout + ')';
+}
+
+static PrimitiveEntity::Type getPrimitive(TypeReferenceEntity& entity)
+{
+	return entity.getAsPOD().getPrimitiveType().getType();
+}
+
+static PrimitiveEntity::Type getElement(TypeReferenceEntity& entity)
+{
+	return entity.getAsPOD().getPrimitiveType().getElementType();
+}
+
+static bool isView(PrimitiveEntity::Type type)
+{
+	return type == PrimitiveEntity::Type::String || type == PrimitiveEntity::Type::Buffer;
+}
+
+static bool returnsView(FunctionEntity& entity)
+{
+	if(!entity.returnsValue())
+	{
+		return false;
+	}
+
+	auto returnType = entity.getReturnType(true);
+	return !isValue(returnType) && isView(getPrimitive(returnType));
+}
+
+static bool returnsValueType(FunctionEntity& entity)
+{
+	if(!entity.returnsValue())
+	{
+		return false;
+	}
+
+	auto returnType = entity.getReturnType(true);
+	return isValue(returnType);
+}
+
+static bool hasParameter(FunctionEntity& entity, PrimitiveEntity::Type type)
+{
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		if(!isValue(entity.getParameter(i)) && getPrimitive(entity.getParameter(i)) == type)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool hasValueParameter(FunctionEntity& entity)
+{
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		if(isValue(entity.getParameter(i)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool isSkippedInterception(FunctionEntity& entity)
+{
+	// TODO: Implement operator overload and destructor interceptors.
+	return entity.getOverloadedOperator() != FunctionEntity::OverloadedOperator::None ||
+			entity.getType() == FunctionEntity::Type::Destructor;
+}
+
+ForeignBindingGenerator::ForeignBindingGenerator(Backend& backend, std::string_view packagePrefix, std::string_view libName)
+	: BindingGenerator(backend, packagePrefix, false), libName(libName)
+{
+}
+
+void ForeignBindingGenerator::openFile(Entity& entity)
+{
+	BindingGenerator::openFile(entity);
+
+	file << "import java.lang.foreign.*;\n";
+	file << "import java.lang.invoke.MethodHandle;\n";
+	file << "import java.lang.invoke.MethodHandles;\n";
+}
+
+const char* ForeignBindingGenerator::getHandleType()
+{
+	return "MemorySegment";
+}
+
+const char* ForeignBindingGenerator::getStorageType()
+{
+	return "MemorySegment";
+}
+
+const char* ForeignBindingGenerator::getNullHandle()
+{
+	return "MemorySegment.NULL";
+}
+
+std::string ForeignBindingGenerator::getHandleAddress(std::string_view handle)
+{
+	return std::string(handle) + ".address()";
+}
+
+std::string ForeignBindingGenerator::getFunctionDescriptor(FunctionEntity& entity, bool errorSlot, bool unpacked)
+{
+	std::string layouts;
+
+	// The storage for the returned object comes first.
+	if(takesStorage(entity))
+	{
+		layouts += "ValueLayout.ADDRESS";
+	}
+
+	if(entity.needsThisHandle())
+	{
+		layouts += (layouts.empty() ? "" : ", ") + std::string("ValueLayout.ADDRESS");
+	}
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		if(!layouts.empty())
+		{
+			layouts += ", ";
+		}
+
+		// Unpacked buffers are passed as a pointer and a size.
+		auto& parameter = entity.getParameter(i);
+		if(unpacked && !isValue(parameter) && getPrimitive(parameter) == PrimitiveEntity::Type::Buffer)
+		{
+			layouts += "ValueLayout.ADDRESS, " + packagePrefix + ".AG_Foreign.SIZE_T";
+			continue;
+		}
+
+		layouts += getLayout(parameter, packagePrefix);
+	}
+
+	// The error slot of a potentially throwing function comes last.
+	if(errorSlot && entity.isThrowing())
+	{
+		layouts += (layouts.empty() ? "" : ", ") + std::string("ValueLayout.ADDRESS");
+	}
+
+	if(!entity.returnsValue())
+	{
+		return "FunctionDescriptor.ofVoid(" + layouts + ')';
+	}
+
+	auto returnType = entity.getReturnType(true);
+	return "FunctionDescriptor.of(" + getLayout(returnType, packagePrefix) +
+			(layouts.empty() ? "" : ", ") + layouts + ')';
+}
+
+void ForeignBindingGenerator::generateField(FieldEntity& entity)
+{
+	if(!entity.hasOffset())
+	{
+		BindingGenerator::generateField(entity);
+		return;
+	}
+
+	// Fields with a known offset are read and written through the object handle without a downcall.
+	auto& getter = entity.getGetter();
+	auto type = getter.getReturnType(true);
+	auto primitive = getPrimitive(type);
+	auto layout = getLayout(primitive, packagePrefix);
+	auto offset = std::to_string(entity.getOffset());
+
+	// Object handles are zero-length segments, so they are resized to cover the field.
+	std::string segment = "mObjectHandle.reinterpret(" + offset + " + " + layout + ".byteSize())";
+
+	file << "public final ";
+	getter.generateReturnType(*this, false);
+	file << sanitizeName(entity) << "() {\n";
+	file << "return " << convertToJava(type, getMemory(primitive, segment, offset, packagePrefix)) << ";\n}\n\n";
+
+	if(!entity.isReadOnly())
+	{
+		file << "public final void " << sanitizeName(entity) << '(';
+		entity.getSetter().generateParameters(*this, false, false);
+		file << ") {\n";
+		file << setMemory(primitive, segment, offset, convertToForeign(type, sanitizeName(entity.getSetter().getParameter(0))),
+				packagePrefix) << ";\n}\n\n";
+	}
+}
+
+void ForeignBindingGenerator::generateNativeDeclaration(FunctionEntity& entity)
+{
+	auto nativeName = inStorage ? entity.getStorageBridgeName(true) : entity.getBridgeName(true);
+	bool unpacked = !inStorage && entity.hasUnpackedBridge();
+
+	// Interfaces have no bridge function but are still given a method to call.
+	if(!entity.isInterface())
+	{
+		// Leaf functions don't need a thread state transition, much like JNI critical natives.
+		// Those taking buffers call the unpacked bridge with the arrays in place, since
+		// the collector can wait for such a short call instead of the arrays being copied.
+		bool leaf = entity.isLeaf() && !entity.isOverridable() && !entity.isOverride();
+		auto bridgeName = inStorage ? entity.getStorageBridgeName() :
+							unpacked ? entity.getUnpackedBridgeName() : entity.getBridgeName();
+
+		file << "private static final MethodHandle AG_bridge_" << nativeName << " = " << packagePrefix <<
+				".AG_Foreign.downcall(\"" << bridgeName << "\", " << getFunctionDescriptor(entity, true, unpacked) <<
+				(leaf ? (unpacked ? ", Linker.Option.critical(true)" : ", Linker.Option.critical(false)") : "") << ");\n";
+	}
+
+	file << "private static ";
+	entity.generateReturnType(*this, true);
+	file << nativeName << '(';
+	generateStorageParameter(entity);
+	entity.generateParameters(*this, true, true);
+	file << ") {\n";
+
+	if(entity.isInterface())
+	{
+		file << "throw new UnsupportedOperationException(\"" << entity.getName() << " is not implemented\");\n}\n\n";
+		return;
+	}
+
+	// Strings are passed as views of UTF-8 allocated for the duration of the call,
+	// and arrays are copied there since a view can't refer to the Java heap.
+	// Returned views and value types are allocated there as well.
+	// The error slot of a potentially throwing function is allocated there too.
+	bool buffers = !unpacked && hasParameter(entity, PrimitiveEntity::Type::Buffer);
+	bool views = buffers || hasParameter(entity, PrimitiveEntity::Type::String) || returnsView(entity) ||
+				hasValueParameter(entity) || returnsValueType(entity) || entity.isThrowing();
+	file << (views ? "try(Arena arena = Arena.ofConfined()) {\n" : "try {\n");
+
+	if(entity.isThrowing())
+	{
+		file << "MemorySegment AG_error = arena.allocate(" << packagePrefix << ".AG_Foreign.ERROR);\n";
+	}
+
+	std::string call = "AG_bridge_" + nativeName + ".invokeExact(";
+	bool separate = false;
+
+	// Functions returning a struct by value take an allocator for it.
+	if(returnsView(entity) || returnsValueType(entity))
+	{
+		call += "(SegmentAllocator)arena";
+		separate = true;
+	}
+
+	if(takesStorage(entity))
+	{
+		call += std::string(separate ? ", " : "") + "storage";
+		separate = true;
+	}
+
+	if(entity.needsThisHandle())
+	{
+		call += (separate ? ", " : "") + std::string(getObjectHandleName());
+		separate = true;
+	}
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& parameter = entity.getParameter(i);
+
+		if(separate)
+		{
+			call += ", ";
+		}
+
+		separate = true;
+
+		// Callables keep their context alive until the glue code releases it.
+		if(parameter.isCallable())
+		{
+			call += packagePrefix + ".AG_" + parameter.getReferred().getName() + ".AG_encode(arena, " +
+					sanitizeName(parameter) + ')';
+			continue;
+		}
+
+		// Value types are copied to a struct for the duration of the call.
+		if(isValue(parameter))
+		{
+			call += sanitizeName(parameter) + ".AG_encode(arena)";
+			continue;
+		}
+
+		switch(getPrimitive(parameter))
+		{
+			case PrimitiveEntity::Type::String:
+			{
+				call += packagePrefix + ".AG_Foreign.encodeString(arena, " + sanitizeName(parameter) + ')';
+				break;
+			}
+
+			case PrimitiveEntity::Type::Buffer:
+			{
+				if(unpacked)
+				{
+					call += packagePrefix + ".AG_Foreign.heapBuffer(" + sanitizeName(parameter) + "), " +
+							sanitizeName(parameter) + " != null ? (long)" + sanitizeName(parameter) + ".length : 0L";
+					break;
+				}
+
+				file << "MemorySegment AG_" << sanitizeName(parameter) << " = " << packagePrefix <<
+						".AG_Foreign.encodeBuffer(arena, " << sanitizeName(parameter) << ");\n";
+
+				call += "AG_" + sanitizeName(parameter);
+				break;
+			}
+
+			case PrimitiveEntity::Type::Character:
+			{
+				call += "(byte)" + sanitizeName(parameter);
+				break;
+			}
+
+			default:
+			{
+				call += sanitizeName(parameter);
+			}
+		}
+	}
+
+	if(entity.isThrowing())
+	{
+		call += std::string(separate ? ", " : "") + "AG_error";
+	}
+
+	call += ')';
+
+	// The return value is stored while the error slot is checked and the arrays are copied back.
+	bool storesResult = buffers || entity.isThrowing();
+
+	if(entity.returnsValue())
+	{
+		// invokeExact needs the exact return type of the bridge function.
+		auto returnType = entity.getReturnType(true);
+		file << (storesResult ? "var AG_result = " : "return ");
+
+		if(returnType.isCallable())
+		{
+			file << packagePrefix << ".AG_" << returnType.getReferred().getName() <<
+					".AG_decode((MemorySegment)" << call << ')';
+		}
+
+		else if(isValue(returnType))
+		{
+			file << packagePrefix << '.' << returnType.getReferred().getHierarchy(".") <<
+					".AG_decode((MemorySegment)" << call << ')';
+		}
+
+		else
+		{
+			auto primitive = getPrimitive(returnType);
+
+			switch(primitive)
+			{
+				case PrimitiveEntity::Type::String:
+				{
+					file << packagePrefix << ".AG_Foreign.decodeString((MemorySegment)" << call << ')';
+					break;
+				}
+
+				case PrimitiveEntity::Type::Buffer:
+				{
+					// Borrowed buffers are viewed in place instead of being copied.
+					if(returnType.isReference())
+					{
+						file << getViewConversion(getElement(returnType)) << '(' << packagePrefix <<
+								".AG_Foreign.viewBuffer((MemorySegment)" << call << ", " <<
+								getLayout(getElement(returnType), packagePrefix) << "))";
+						break;
+					}
+
+					file << packagePrefix << ".AG_Foreign.decodeBuffer((MemorySegment)" << call << ", " <<
+							getLayout(getElement(returnType), packagePrefix) << ')';
+					break;
+				}
+
+				case PrimitiveEntity::Type::Character:
+				{
+					file << "(char)(byte)" << call;
+					break;
+				}
+
+				default:
+				{
+					file << '(' << getCarrierType(primitive) << ')' << call;
+				}
+			}
+		}
+	}
+
+	else
+	{
+		file << call;
+	}
+
+	file << ";\n";
+
+	if(entity.isThrowing())
+	{
+		file << packagePrefix << ".AG_Foreign.checkError(AG_error);\n";
+	}
+
+	if(buffers)
+	{
+		// The glue code might have modified the copied elements.
+		for(size_t i = 0; i < entity.getParameterCount(); i++)
+		{
+			auto& parameter = entity.getParameter(i);
+
+			if(!isValue(parameter) && getPrimitive(parameter) == PrimitiveEntity::Type::Buffer)
+			{
+				file << packagePrefix << ".AG_Foreign.copyBack(AG_" << sanitizeName(parameter) << ", " <<
+						sanitizeName(parameter) << ");\n";
+			}
+		}
+	}
+
+	if(storesResult && entity.returnsValue())
+	{
+		file << "return AG_result;\n";
+	}
+
+	file << "} catch(Throwable e) {\n";
+	file << "throw " << packagePrefix << ".AG_Foreign.rethrow(e);\n}\n}\n\n";
+}
+
+void ForeignBindingGenerator::generateBatchedNative(FunctionEntity& entity)
+{
+	auto nativeName = entity.getBatchBridgeName(true);
+	auto returned = entity.getReturnType(true);
+
+	// The object handles and their count come first, followed by the broadcast mask.
+	std::string layouts = "ValueLayout.ADDRESS, " + packagePrefix + ".AG_Foreign.SIZE_T, ValueLayout.JAVA_LONG";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		layouts += ", ValueLayout.ADDRESS";
+	}
+
+	if(entity.returnsValue())
+	{
+		layouts += ", ValueLayout.ADDRESS";
+	}
+
+	if(entity.isThrowing())
+	{
+		layouts += ", ValueLayout.ADDRESS";
+	}
+
+	file << "private static final MethodHandle AG_bridge_" << nativeName << " = " << packagePrefix <<
+			".AG_Foreign.downcall(\"" << entity.getBatchBridgeName() << "\", FunctionDescriptor.ofVoid(" <<
+			layouts << "));\n";
+
+	std::string results = entity.returnsValue() ? getCarrierType(getPrimitive(returned)) : "";
+
+	file << "private static " << (results.empty() ? "void" : results + "[]") << ' ' << nativeName << '(' <<
+			packagePrefix << '.' << entity.getParent().getHierarchy(".") << "[] objects, long broadcast";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		file << ", " << getCarrierType(param) << "[] " << sanitizeName(param);
+	}
+
+	file << ") {\n";
+
+	// The object handles and the arguments are copied to native memory for the duration of the call.
+	file << "try(Arena arena = Arena.ofConfined()) {\n";
+	file << "MemorySegment AG_handles = arena.allocate(ValueLayout.ADDRESS, objects.length);\n";
+	file << "for(int AG_i = 0; AG_i < objects.length; AG_i++) {\n";
+	file << "AG_handles.setAtIndex(ValueLayout.ADDRESS, AG_i, objects[AG_i].getObjectHandle());\n}\n\n";
+
+	if(!results.empty())
+	{
+		file << "MemorySegment AG_results = arena.allocate(" << getLayout(returned, packagePrefix) <<
+				", objects.length);\n";
+	}
+
+	if(entity.isThrowing())
+	{
+		file << "MemorySegment AG_error = arena.allocate(" << packagePrefix << ".AG_Foreign.ERROR);\n";
+	}
+
+	file << "AG_bridge_" << nativeName << ".invokeExact(AG_handles, (long)objects.length, broadcast";
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+		file << ", arena.allocateFrom(" << getLayout(param, packagePrefix) << ", " << sanitizeName(param) << ')';
+	}
+
+	file << (results.empty() ? "" : ", AG_results") << (entity.isThrowing() ? ", AG_error" : "") << ");\n";
+
+	// The objects own the native objects, so they have to stay alive during the call.
+	file << "java.lang.ref.Reference.reachabilityFence(objects);\n";
+
+	if(entity.isThrowing())
+	{
+		file << packagePrefix << ".AG_Foreign.checkError(AG_error);\n";
+	}
+
+	if(!results.empty())
+	{
+		file << "return AG_results.toArray(" << getLayout(returned, packagePrefix) << ");\n";
+	}
+
+	file << "} catch(Throwable e) {\n";
+	file << "throw " << packagePrefix << ".AG_Foreign.rethrow(e);\n}\n}\n\n";
+}
+
+void ForeignBindingGenerator::generateAsyncNative(FunctionEntity& entity)
+{
+	auto nativeName = entity.getAsyncBridgeName(true);
+	auto completeName = "AG_complete_" + entity.getBridgeName(true);
+	auto futureType = getFutureType(entity);
+	auto returned = entity.getReturnType(true);
+
+	std::string layouts = entity.needsThisHandle() ? "ValueLayout.ADDRESS, " : "";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		layouts += getLayout(entity.getParameter(i), packagePrefix) + ", ";
+	}
+
+	// The completion function and its context are passed last.
+	file << "private static final MethodHandle AG_bridge_" << nativeName << " = " << packagePrefix <<
+			".AG_Foreign.downcall(\"" << entity.getAsyncBridgeName() << "\", FunctionDescriptor.ofVoid(" <<
+			layouts << "ValueLayout.ADDRESS, ValueLayout.ADDRESS));\n";
+
+	// The glue code calls this on the worker thread once the call has completed.
+	// The future is registered to AG_Foreign until then.
+	file << "private static void " << completeName << "(MemorySegment context, MemorySegment error" <<
+			(entity.returnsValue() ? std::string(", ") + getCarrierType(returned) + " result" : "") << ") {\n";
+	file << "@SuppressWarnings(\"unchecked\")\n";
+	file << futureType << " future = (" << futureType << ')' << packagePrefix << ".AG_Foreign.takeObject(context);\n";
+	file << "if(!error.equals(MemorySegment.NULL)) {\n";
+	file << "future.completeExceptionally(new RuntimeException(" << packagePrefix << ".AG_Foreign.decodeString(error)));\n";
+	file << "} else {\n";
+	file << "future.complete(" << (entity.returnsValue() ? convertToJava(returned, "result") : "null") << ");\n}\n}\n";
+
+	file << "private static final MemorySegment AG_completion_" << entity.getBridgeName(true) << " = " << packagePrefix <<
+			".AG_Foreign.upcall(MethodHandles.lookup(), " << packagePrefix << '.' << entity.getParent().getHierarchy(".") <<
+			".class, \"" << completeName << "\", FunctionDescriptor.ofVoid(ValueLayout.ADDRESS, ValueLayout.ADDRESS" <<
+			(entity.returnsValue() ? ", " + getLayout(returned, packagePrefix) : "") << "));\n";
+
+	file << "private static void " << nativeName << '(';
+	entity.generateParameters(*this, true, true);
+	file << (entity.getParameterCount(true) > 0 ? ", " : "") << futureType << " future) {\n";
+
+	// Strings only need to live for the call since the glue code copies them for the worker.
+	bool strings = hasParameter(entity, PrimitiveEntity::Type::String);
+	file << (strings ? "try(Arena arena = Arena.ofConfined()) {\n" : "try {\n");
+	file << "AG_bridge_" << nativeName << ".invokeExact(";
+
+	if(entity.needsThisHandle())
+	{
+		file << getObjectHandleName() << ", ";
+	}
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& param = entity.getParameter(i);
+
+		if(getPrimitive(param) == PrimitiveEntity::Type::String)
+		{
+			file << packagePrefix << ".AG_Foreign.encodeString(arena, " << sanitizeName(param) << "), ";
+		}
+
+		else
+		{
+			file << convertToForeign(param, sanitizeName(param)) << ", ";
+		}
+	}
+
+	file << "AG_completion_" << entity.getBridgeName(true) << ", " << packagePrefix << ".AG_Foreign.register(future));\n";
+	file << "} catch(Throwable e) {\n";
+	file << "throw " << packagePrefix << ".AG_Foreign.rethrow(e);\n}\n}\n\n";
+}
+
+void ForeignBindingGenerator::generateValueHelpers(ClassEntity& entity)
+{
+	// The layout matches the mirror struct of the glue code, so padding is added between the fields.
+	std::string layouts;
+	size_t end = 0;
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+
+		if(field.offset > end)
+		{
+			layouts += "MemoryLayout.paddingLayout(" + std::to_string(field.offset - end) + "), ";
+		}
+
+		layouts += getLayout(field.type->getType(), packagePrefix) + ".withName(\"" + field.name + "\")";
+		layouts += i + 1 < entity.getValueFieldCount() ? ", " : "";
+		end = field.offset + field.size;
+	}
+
+	if(entity.getValueSize() > end)
+	{
+		layouts += ", MemoryLayout.paddingLayout(" + std::to_string(entity.getValueSize() - end) + ')';
+	}
+
+	file << "public static final StructLayout AG_LAYOUT = MemoryLayout.structLayout(" << layouts <<
+			").withByteAlignment(" << entity.getValueAlignment() << ");\n\n";
+
+	file << "public MemorySegment AG_encode(SegmentAllocator allocator) {\n";
+	file << "MemorySegment segment = allocator.allocate(AG_LAYOUT);\n";
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		file << setMemory(field.type->getType(), "segment", std::to_string(field.offset), field.name, packagePrefix) << ";\n";
+	}
+
+	file << "return segment;\n}\n\n";
+
+	file << "public static " << entity.getName() << " AG_decode(MemorySegment segment) {\n";
+	file << "segment = segment.reinterpret(AG_LAYOUT.byteSize());\n";
+	file << entity.getName() << " result = new " << entity.getName() << "();\n";
+
+	for(size_t i = 0; i < entity.getValueFieldCount(); i++)
+	{
+		auto& field = entity.getValueField(i);
+		file << "result." << field.name << " = " <<
+				getMemory(field.type->getType(), "segment", std::to_string(field.offset), packagePrefix) << ";\n";
+	}
+
+	file << "return result;\n}\n";
+}
+
+void ForeignBindingGenerator::generateNativeImplementation(FunctionEntity&)
+{
+	// The bridge functions are called directly, so there's no native code.
+}
+
+void ForeignBindingGenerator::generateInterceptionSetup(FunctionEntity&)
+{
+	file << "AG_initializeInterceptionContext();\n";
+}
+
+std::string ForeignBindingGenerator::convertToJava(TypeReferenceEntity& entity, const std::string& value)
+{
+	switch(entity.getType())
+	{
+		case TypeEntity::Type::Alias:
+		{
+			TypeReferenceEntity underlying("", entity.getAliasType().getUnderlying(true), entity.isReference());
+			return convertToJava(underlying, value);
+		}
+
+		case TypeEntity::Type::Class:
+		{
+			// Value types are copied from the struct passed by the glue code.
+			if(entity.getClassType().isValueType())
+			{
+				return packagePrefix + '.' + entity.getReferred().getHierarchy(".") + ".AG_decode(" + value + ')';
+			}
+
+			// TODO: Until type extension support is generated, abstract classes can't be instantiated.
+			if(entity.getClassType().isAbstract())
+			{
+				return "null";
+			}
+
+			// Objects passed to interception functions are borrowed.
+			if(identityCache)
+			{
+				return packagePrefix + '.' + entity.getReferred().getHierarchy(".") + ".AG_wrap(" + value + ')';
+			}
+
+			return "new " + packagePrefix + '.' + entity.getReferred().getHierarchy(".") + '(' + value + ')';
+		}
+
+		case TypeEntity::Type::Enum:
+		{
+			return packagePrefix + '.' + entity.getReferred().getHierarchy(".") + ".fromInt(" + value + ')';
+		}
+
+		case TypeEntity::Type::Primitive:
+		{
+			switch(entity.getPrimitiveType().getType())
+			{
+				case PrimitiveEntity::Type::String: return packagePrefix + ".AG_Foreign.decodeString(" + value + ')';
+				case PrimitiveEntity::Type::Character: return "(char)" + value;
+
+				case PrimitiveEntity::Type::Buffer:
+					return packagePrefix + ".AG_Foreign.decodeBuffer(" + value + ", " +
+							getLayout(entity.getPrimitiveType().getElementType(), packagePrefix) + ')';
+
+				default: break;
+			}
+
+			break;
+		}
+
+		case TypeEntity::Type::Callable:
+		{
+			return packagePrefix + ".AG_" + entity.getReferred().getName() + ".AG_decode(" + value + ')';
+		}
+	}
+
+	return value;
+}
+
+std::string ForeignBindingGenerator::convertToForeign(TypeReferenceEntity& entity, const std::string& value)
+{
+	switch(entity.getType())
+	{
+		case TypeEntity::Type::Alias:
+		{
+			TypeReferenceEntity underlying("", entity.getAliasType().getUnderlying(true), entity.isReference());
+			return convertToForeign(underlying, value);
+		}
+
+		case TypeEntity::Type::Class:
+		{
+			// The returned struct is copied by the upcall stub, so it can be freed whenever.
+			if(entity.getClassType().isValueType())
+			{
+				return value + ".AG_encode(Arena.ofAuto())";
+			}
+
+			return value + ".getObjectHandle()";
+		}
+
+		case TypeEntity::Type::Enum:
+		{
+			return value + ".getValue()";
+		}
+
+		case TypeEntity::Type::Primitive:
+		{
+			switch(entity.getPrimitiveType().getType())
+			{
+				case PrimitiveEntity::Type::String:
+					return packagePrefix + ".AG_Foreign.returnString(" + value + ')';
+
+				case PrimitiveEntity::Type::Buffer:
+					return packagePrefix + ".AG_Foreign.returnBuffer(" + value + ')';
+
+				case PrimitiveEntity::Type::Character: return "(byte)" + value;
+				default: break;
+			}
+
+			break;
+		}
+
+		// The returned struct is copied by the upcall stub like value types.
+		case TypeEntity::Type::Callable:
+		{
+			return packagePrefix + ".AG_" + entity.getReferred().getName() + ".AG_encode(Arena.ofAuto(), " + value + ')';
+		}
+	}
+
+	return value;
+}
+
+void ForeignBindingGenerator::generateCallableHelpers(CallableTypeEntity& entity)
+{
+	auto packagePath = packagePrefix;
+	std::replace(packagePath.begin(), packagePath.end(), '.', '/');
+
+	auto name = entity.getName();
+	auto className = packagePrefix + ".AG_" + name;
+	auto interfaceName = packagePrefix + '.' + name;
+	callablesGenerated = true;
+
+	file.open(packagePath + "/AG_" + name + ".java");
+	file << "package " << packagePrefix << ";\n\n";
+	file << "import java.lang.foreign.*;\n";
+	file << "import java.lang.invoke.MethodHandle;\n";
+	file << "import java.lang.invoke.MethodHandles;\n\n";
+
+	file << "public final class AG_" << name << " {\n";
+	file << "private AG_" << name << "() {\n}\n\n";
+
+	// The trampoline receives the context before the parameters of the callable.
+	std::string layouts = "ValueLayout.ADDRESS";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		layouts += ", " + getLayout(entity.getParameter(i), packagePrefix);
+	}
+
+	auto& returnType = entity.getReturnType();
+	file << "private static final FunctionDescriptor AG_DESCRIPTOR = " << (entity.returnsValue() ?
+			"FunctionDescriptor.of(" + getLayout(returnType, packagePrefix) + ", " : "FunctionDescriptor.ofVoid(") <<
+			layouts << ");\n\n";
+
+	// Java callables share a single upcall stub, and the context tells which one is called.
+	std::string returned = entity.returnsValue() ? getCarrierType(returnType) : "void";
+	std::string arguments;
+
+	file << "private static " << returned << " AG_invoke(MemorySegment context";
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& parameter = entity.getParameter(i);
+		file << ", " << getCarrierType(parameter) << ' ' << sanitizeName(parameter);
+		arguments += (i > 0 ? ", " : "") + convertToJava(parameter, sanitizeName(parameter));
+	}
+
+	file << ") {\n";
+
+	std::string call = "((" + interfaceName + ')' + packagePrefix + ".AG_Foreign.getCallable(context)).invoke(" + arguments + ')';
+	file << (entity.returnsValue() ? "return " + convertToForeign(returnType, call) : call) << ";\n}\n\n";
+
+	file << "private static final MemorySegment AG_trampoline = " << packagePrefix <<
+			".AG_Foreign.upcall(MethodHandles.lookup(), AG_" << name << ".class, \"AG_invoke\", AG_DESCRIPTOR);\n";
+	file << "private static final MethodHandle AG_invoker = " << packagePrefix << ".AG_Foreign.invoker(AG_DESCRIPTOR);\n\n";
+
+	file << "public static MemorySegment AG_encode(SegmentAllocator allocator, " << interfaceName << " value) {\n";
+	file << "MemorySegment result = allocator.allocate(" << packagePrefix << ".AG_Foreign.CALLABLE);\n";
+	file << "if(value != null) {\n";
+	file << "result.set(ValueLayout.ADDRESS, 0, AG_trampoline);\n";
+	file << "result.set(ValueLayout.ADDRESS, ValueLayout.ADDRESS.byteSize(), " << packagePrefix << ".AG_Foreign.acquire(value));\n";
+	file << "result.set(ValueLayout.ADDRESS, ValueLayout.ADDRESS.byteSize() * 2, " << packagePrefix << ".AG_Foreign.RELEASE);\n}\n\n";
+	file << "return result;\n}\n\n";
+
+	// Callables returned by the glue code are wrapped in a lambda that calls the trampoline
+	// with the context. The context is released once the lambda is unreachable.
+	std::string parameters;
+	std::string foreignArguments;
+
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& parameter = entity.getParameter(i);
+		parameters += (i > 0 ? ", " : "") + sanitizeName(parameter);
+		foreignArguments += ", " + convertToForeign(parameter, sanitizeName(parameter));
+	}
+
+	call = "AG_invoker.invokeExact(invoke, context" + foreignArguments + ')';
+
+	file << "public static " << interfaceName << " AG_decode(MemorySegment value) {\n";
+	file << "value = value.reinterpret(" << packagePrefix << ".AG_Foreign.CALLABLE.byteSize());\n";
+	file << "MemorySegment invoke = value.get(ValueLayout.ADDRESS, 0);\n";
+	file << "if(invoke.equals(MemorySegment.NULL)) {\nreturn null;\n}\n\n";
+	file << "MemorySegment context = value.get(ValueLayout.ADDRESS, ValueLayout.ADDRESS.byteSize());\n";
+	file << "MemorySegment release = value.get(ValueLayout.ADDRESS, ValueLayout.ADDRESS.byteSize() * 2);\n";
+	file << interfaceName << " result = (" << parameters << ") -> {\n";
+	file << "try {\n";
+
+	if(entity.returnsValue())
+	{
+		// invokeExact needs the exact carrier type of the trampoline.
+		file << "return " << convertToJava(returnType, '(' + returned + ')' + call) << ";\n";
+	}
+
+	else
+	{
+		file << call << ";\n";
+	}
+
+	file << "} catch(Throwable e) {\n";
+	file << "throw " << packagePrefix << ".AG_Foreign.rethrow(e);\n}\n};\n\n";
+	file << "if(!release.equals(MemorySegment.NULL)) {\n";
+	file << packagePrefix << ".AG_Lifetime.onUnreachable(result, () -> " << packagePrefix <<
+			".AG_Foreign.releaseNative(release, context));\n}\n\n";
+	file << "return result;\n}\n}\n";
+	file.close();
+}
+
+void ForeignBindingGenerator::generateInterceptionFunction(FunctionEntity& entity, ClassEntity& parentClass)
+{
+	auto shortName = entity.getBridgeName(true);
+
+	// Are we listing the interception functions for the interception context?
+	switch(interceptionPart)
+	{
+		// Functions without a name are assumed to be overridden.
+		case InterceptionPart::Names:
+		{
+			file << (isSkippedInterception(entity) ? "null" : '"' + sanitizeName(entity) + '"') << ", ";
+			return;
+		}
+
+		// The interception functions are passed as function pointers.
+		case InterceptionPart::Layouts:
+		{
+			file << ", ValueLayout.ADDRESS";
+			return;
+		}
+
+		case InterceptionPart::Arguments:
+		{
+			file << ", " << (isSkippedInterception(entity) ? "MemorySegment.NULL" : "AG_interceptor_" + shortName);
+			return;
+		}
+
+		case InterceptionPart::None: {}
+	}
+
+	if(isSkippedInterception(entity))
+	{
+		return;
+	}
+
+	auto className = packagePrefix + '.' + parentClass.getHierarchy(".");
+
+	// The interception function is called by the glue code through an upcall stub.
+	// The object handle identifies the Java object registered to AG_Foreign.
+	file << "private static ";
+
+	if(entity.returnsValue())
+	{
+		auto returnType = entity.getReturnType(true);
+		file << getCarrierType(returnType);
+	}
+
+	else
+	{
+		file << "void";
+	}
+
+	file << " AG_intercept_" << shortName << "(MemorySegment objectHandle";
+
+	std::string arguments;
+	for(size_t i = 0; i < entity.getParameterCount(); i++)
+	{
+		auto& parameter = entity.getParameter(i);
+		file << ", " << getCarrierType(parameter) << ' ' << sanitizeName(parameter);
+
+		arguments += (i > 0 ? ", " : "") + convertToJava(parameter, sanitizeName(parameter));
+	}
+
+	file << ") {\n";
+	file << "try {\n";
+
+	std::string call = "((" + className + ')' + packagePrefix + ".AG_Foreign.getObject(objectHandle))." +
+			sanitizeName(entity) + '(' + arguments + ')';
+
+	if(entity.returnsValue())
+	{
+		auto returnType = entity.getReturnType();
+		file << "return " << convertToForeign(returnType, call) << ";\n";
+	}
+
+	else
+	{
+		file << call << ";\n";
+	}
+
+	// An exception thrown out of an upcall terminates the JVM, so it's reported and a zero value is returned instead.
+	file << "} catch(Throwable e) {\n";
+	file << packagePrefix << ".AG_Foreign.uncaught(e);\n";
+
+	if(entity.returnsValue())
+	{
+		auto returnType = entity.getReturnType(true);
+		file << "return " << getDefaultValue(returnType, packagePrefix) << ";\n";
+	}
+
+	file << "}\n}\n";
+
+	// The upcall stub is created once per class.
+	file << "private static final MemorySegment AG_interceptor_" << shortName << " = " << packagePrefix <<
+			".AG_Foreign.upcall(MethodHandles.lookup(), " << className << ".class, \"AG_intercept_" << shortName <<
+			"\", " << getFunctionDescriptor(entity, false) << ");\n\n";
+}
+
+void ForeignBindingGenerator::generateInterceptionContext(ClassEntity& entity)
+{
+	auto bridgeName = entity.getHierarchy() + "_AG_initializeInterceptionContext";
+
+	file << "private static final MethodHandle AG_bridge_AG_initializeInterceptionContext = " << packagePrefix <<
+			".AG_Foreign.downcall(\"" << bridgeName << "\", FunctionDescriptor.ofVoid(" <<
+			"ValueLayout.ADDRESS, ValueLayout.ADDRESS, ValueLayout.JAVA_LONG";
+
+	interceptionPart = InterceptionPart::Layouts;
+	entity.generateInterceptionFunctions(*this);
+	file << "));\n";
+
+	// The glue code calls the base implementation directly for functions that
+	// the runtime type of the object doesn't override.
+	file << "private static final String[] AG_interceptedNames = { ";
+	interceptionPart = InterceptionPart::Names;
+	entity.generateInterceptionFunctions(*this);
+	file << "};\n";
+	file << "private static final ClassValue <Long> AG_overrides = " << packagePrefix << ".AG_Foreign.overrides(" <<
+			packagePrefix << '.' << entity.getHierarchy(".") << ".class, AG_interceptedNames);\n\n";
+
+	// The object stays registered until it's closed, so that the glue code never
+	// calls into an object that no longer exists.
+	file << "private void AG_initializeInterceptionContext() {\n";
+	file << "MemorySegment AG_object = " << packagePrefix << ".AG_Foreign.register(this);\n";
+	file << "mCleanable = " << packagePrefix << ".AG_Lifetime.onRelease(mCleanable, () -> " <<
+			packagePrefix << ".AG_Foreign.unregister(AG_object));\n\n";
+	file << "try {\n";
+	file << "AG_bridge_AG_initializeInterceptionContext.invokeExact(mObjectHandle, AG_object, " <<
+			"(long)AG_overrides.get(getClass())";
+
+	interceptionPart = InterceptionPart::Arguments;
+	entity.generateInterceptionFunctions(*this);
+	interceptionPart = InterceptionPart::None;
+
+	file << ");\n} catch(Throwable e) {\n";
+	file << "throw " << packagePrefix << ".AG_Foreign.rethrow(e);\n}\n}\n\n";
+}
+
+void ForeignBindingGenerator::generateLifetimeNatives(std::ofstream& lifetime)
+{
+	lifetime << "private static final java.lang.invoke.MethodHandle[] destructorBridges = {\n";
+
+	for(auto& destructor : destructors)
+	{
+		lifetime << "AG_Foreign.downcall(\"" << destructor.second <<
+				"\", java.lang.foreign.FunctionDescriptor.ofVoid(java.lang.foreign.ValueLayout.ADDRESS)),\n";
+	}
+
+	lifetime << "};\n\n";
+
+	lifetime << "private static void destroy(long handle, int destructor) {\n";
+	lifetime << "try {\n";
+	lifetime << "destructorBridges[destructor].invokeExact(java.lang.foreign.MemorySegment.ofAddress(handle));\n";
+	lifetime << "} catch(Throwable e) {\n";
+	lifetime << "throw AG_Foreign.rethrow(e);\n}\n}\n\n";
+
+	// Native calls are cheap enough that a scope can release its objects one by one.
+	lifetime << "private static void destroyAll(long[] handles, int[] destructors, int count) {\n";
+	lifetime << "for(int i = 0; i < count; i++) {\n";
+	lifetime << "if(handles[i] != 0) {\n";
+	lifetime << "destroy(handles[i], destructors[i]);\n}\n}\n}\n\n";
+}
+
+void ForeignBindingGenerator::generateBridgeStatsNatives(std::ofstream& stats)
+{
+	stats << "private static final java.lang.invoke.MethodHandle countBridge = AG_Foreign.downcall(\"AG_getBridgeCount\", " <<
+			"java.lang.foreign.FunctionDescriptor.of(AG_Foreign.SIZE_T));\n";
+	stats << "private static final java.lang.invoke.MethodHandle nameBridge = AG_Foreign.downcall(\"AG_getBridgeName\", " <<
+			"java.lang.foreign.FunctionDescriptor.of(java.lang.foreign.ValueLayout.ADDRESS, AG_Foreign.SIZE_T));\n";
+	stats << "private static final java.lang.invoke.MethodHandle statsBridge = AG_Foreign.downcall(\"AG_getBridgeStats\", " <<
+			"java.lang.foreign.FunctionDescriptor.ofVoid(java.lang.foreign.ValueLayout.ADDRESS));\n";
+	stats << "private static final java.lang.invoke.MethodHandle resetBridge = AG_Foreign.downcall(\"AG_resetBridgeStats\", " <<
+			"java.lang.foreign.FunctionDescriptor.ofVoid());\n\n";
+
+	stats << "private static String[] getNames() {\n";
+	stats << "try {\n";
+	stats << "String[] result = new String[(int)(long)countBridge.invokeExact()];\n";
+	stats << "for(int i = 0; i < result.length; i++) {\n";
+	stats << "java.lang.foreign.MemorySegment name = (java.lang.foreign.MemorySegment)nameBridge.invokeExact((long)i);\n";
+	stats << "result[i] = name.reinterpret(Long.MAX_VALUE).getString(0);\n}\n\n";
+	stats << "return result;\n";
+	stats << "} catch(Throwable e) {\n";
+	stats << "throw AG_Foreign.rethrow(e);\n}\n}\n\n";
+
+	stats << "private static long[] getCounts(int count) {\n";
+	stats << "try(java.lang.foreign.Arena arena = java.lang.foreign.Arena.ofConfined()) {\n";
+	stats << "java.lang.foreign.MemorySegment counts = arena.allocate(java.lang.foreign.ValueLayout.JAVA_LONG, " <<
+			"(long)count * (LATENCY_BUCKETS + 1));\n";
+	stats << "statsBridge.invokeExact(counts);\n";
+	stats << "return counts.toArray(java.lang.foreign.ValueLayout.JAVA_LONG);\n";
+	stats << "} catch(Throwable e) {\n";
+	stats << "throw AG_Foreign.rethrow(e);\n}\n}\n\n";
+
+	stats << "private static void resetCounts() {\n";
+	stats << "try {\n";
+	stats << "resetBridge.invokeExact();\n";
+	stats << "} catch(Throwable e) {\n";
+	stats << "throw AG_Foreign.rethrow(e);\n}\n}\n\n";
+}
+
+void ForeignBindingGenerator::generateForeignHelper()
+{
+	auto packagePath = packagePrefix;
+	std::replace(packagePath.begin(), packagePath.end(), '.', '/');
+
+	std::ofstream helper(packagePath + "/AG_Foreign.java");
+
+	helper << "package " << packagePrefix << ";\n\n";
+	helper << "import java.lang.foreign.*;\n";
+	helper << "import java.lang.invoke.MethodHandle;\n";
+	helper << "import java.lang.invoke.MethodHandles;\n";
+	helper << "import java.lang.invoke.MethodType;\n";
+	helper << "import java.lang.reflect.Method;\n";
+	helper << "import java.lang.reflect.Modifier;\n";
+	helper << "import java.nio.charset.StandardCharsets;\n";
+	helper << "import java.util.IdentityHashMap;\n";
+	helper << "import java.util.concurrent.ConcurrentHashMap;\n";
+	helper << "import java.util.concurrent.atomic.AtomicLong;\n\n";
+
+	helper << "public final class AG_Foreign {\n";
+	helper << "private static final Linker linker = Linker.nativeLinker();\n\n";
+
+	// The widths of size_t and intptr_t are those of the platform. The names tell them
+	// apart from other integers of the same width, since their Java carriers are always longs.
+	helper << "public static final ValueLayout SIZE_T = ((ValueLayout)linker.canonicalLayouts().get(\"size_t\")).withName(\"size_t\");\n";
+	helper << "public static final ValueLayout INTPTR = (ValueLayout.ADDRESS.byteSize() == 8 ? " <<
+			"(ValueLayout)ValueLayout.JAVA_LONG : ValueLayout.JAVA_INT).withName(\"intptr_t\");\n\n";
+
+	// The layout matches AG_String of the glue code.
+	helper << "public static final StructLayout STRING = MemoryLayout.structLayout(" <<
+			"ValueLayout.ADDRESS.withName(\"data\"), SIZE_T.withName(\"size\"));\n";
+	// The layout matches AG_Buffer of the glue code.
+	helper << "public static final StructLayout BUFFER = MemoryLayout.structLayout(" <<
+			"ValueLayout.ADDRESS.withName(\"data\"), SIZE_T.withName(\"size\"));\n";
+	// The layout matches AG_Error of the glue code.
+	helper << "public static final StructLayout ERROR = errorLayout();\n";
+	helper << "private static final long SIZE_OFFSET = STRING.byteOffset(MemoryLayout.PathElement.groupElement(\"size\"));\n";
+	helper << "private static final long MESSAGE_OFFSET = ERROR.byteOffset(MemoryLayout.PathElement.groupElement(\"message\"));\n\n";
+	helper << "private static final SymbolLookup library = SymbolLookup.libraryLookup(\"" << libName << "\", Arena.global());\n";
+	helper << "private static final ConcurrentHashMap <Long, Object> objects = new ConcurrentHashMap <> ();\n";
+	helper << "private static final AtomicLong nextObject = new AtomicLong(1);\n";
+	helper << "private static final ThreadLocal <MemorySegment[]> returned = ThreadLocal.withInitial(() -> new MemorySegment[1]);\n\n";
+
+	if(callablesGenerated)
+	{
+		// The layout matches AG_Callable of the glue code.
+		helper << "public static final StructLayout CALLABLE = MemoryLayout.structLayout(ValueLayout.ADDRESS.withName(\"invoke\"), " <<
+				"ValueLayout.ADDRESS.withName(\"context\"), ValueLayout.ADDRESS.withName(\"release\"));\n";
+		helper << "public static final MemorySegment RELEASE = upcall(MethodHandles.lookup(), AG_Foreign.class, " <<
+				"\"releaseCallable\", FunctionDescriptor.ofVoid(ValueLayout.ADDRESS));\n";
+		helper << "private static final MethodHandle releaseInvoker = linker.downcallHandle(FunctionDescriptor.ofVoid(ValueLayout.ADDRESS));\n";
+		helper << "private static final ConcurrentHashMap <Long, Object> callables = new ConcurrentHashMap <> ();\n";
+		helper << "private static final IdentityHashMap <Object, long[]> callableContexts = new IdentityHashMap <> ();\n\n";
+	}
+
+	helper << "private AG_Foreign() {\n}\n\n";
+
+	// The message pointer is aligned after the kind.
+	helper << "private static StructLayout errorLayout() {\n";
+	helper << "long padding = ValueLayout.ADDRESS.byteAlignment() - ValueLayout.JAVA_INT.byteSize();\n";
+	helper << "if(padding > 0) {\n";
+	helper << "return MemoryLayout.structLayout(ValueLayout.JAVA_INT.withName(\"kind\"), " <<
+			"MemoryLayout.paddingLayout(padding), ValueLayout.ADDRESS.withName(\"message\"));\n}\n\n";
+	helper << "return MemoryLayout.structLayout(ValueLayout.JAVA_INT.withName(\"kind\"), ValueLayout.ADDRESS.withName(\"message\"));\n}\n\n";
+
+	// Method handles take and return size_t and intptr_t as longs, and narrower ones are cast.
+	// Downcall handles can take an allocator or a function pointer before the arguments.
+	helper << "private static MethodType carrierType(MethodType type, FunctionDescriptor descriptor) {\n";
+	helper << "int leading = type.parameterCount() - descriptor.argumentLayouts().size();\n";
+	helper << "for(int i = 0; i < descriptor.argumentLayouts().size(); i++) {\n";
+	helper << "if(isWord(descriptor.argumentLayouts().get(i))) {\n";
+	helper << "type = type.changeParameterType(leading + i, long.class);\n}\n}\n\n";
+	helper << "if(descriptor.returnLayout().filter(AG_Foreign::isWord).isPresent()) {\n";
+	helper << "type = type.changeReturnType(long.class);\n}\n\n";
+	helper << "return type;\n}\n\n";
+
+	helper << "private static boolean isWord(MemoryLayout layout) {\n";
+	helper << "return layout.equals(SIZE_T) || layout.equals(INTPTR);\n}\n\n";
+
+	// Sizes and pointer sized integers in memory are as wide as a pointer.
+	helper << "public static long getWord(MemorySegment segment, long offset) {\n";
+	helper << "return ValueLayout.ADDRESS.byteSize() == 8 ? segment.get(ValueLayout.JAVA_LONG, offset) : segment.get(ValueLayout.JAVA_INT, offset);\n}\n\n";
+
+	helper << "public static void setWord(MemorySegment segment, long offset, long value) {\n";
+	helper << "if(ValueLayout.ADDRESS.byteSize() == 8) {\nsegment.set(ValueLayout.JAVA_LONG, offset, value);\n}\n\n";
+	helper << "else {\nsegment.set(ValueLayout.JAVA_INT, offset, (int)value);\n}\n}\n\n";
+
+	helper << "public static MethodHandle downcall(String name, FunctionDescriptor descriptor, Linker.Option... options) {\n";
+	helper << "MemorySegment bridge = library.find(name).orElseThrow(() -> new UnsatisfiedLinkError(name));\n";
+	helper << "MethodHandle handle = linker.downcallHandle(bridge, descriptor, options);\n";
+	helper << "return MethodHandles.explicitCastArguments(handle, carrierType(handle.type(), descriptor));\n}\n\n";
+
+	helper << "public static MemorySegment upcall(MethodHandles.Lookup lookup, Class <?> owner, String name, FunctionDescriptor descriptor) {\n";
+	helper << "try {\n";
+	helper << "MethodType type = descriptor.toMethodType();\n";
+	helper << "MethodHandle target = lookup.findStatic(owner, name, carrierType(type, descriptor));\n";
+	helper << "return linker.upcallStub(MethodHandles.explicitCastArguments(target, type), descriptor, Arena.global());\n";
+	helper << "} catch(ReflectiveOperationException e) {\n";
+	helper << "throw new IllegalStateException(e);\n}\n}\n\n";
+
+	// Exceptions caught by the glue code are mapped to the closest Java exception.
+	helper << "public static void checkError(MemorySegment error) {\n";
+	helper << "int kind = error.get(ValueLayout.JAVA_INT, 0);\n";
+	helper << "if(kind == 0) {\nreturn;\n}\n\n";
+	helper << "String message = error.get(ValueLayout.ADDRESS, MESSAGE_OFFSET).reinterpret(Long.MAX_VALUE).getString(0);\n";
+	helper << "if(kind == 2) {\nthrow new IllegalArgumentException(message);\n}\n\n";
+	helper << "if(kind == 3) {\nthrow new IndexOutOfBoundsException(message);\n}\n\n";
+	helper << "if(kind == 4) {\nthrow new OutOfMemoryError(message);\n}\n\n";
+	helper << "throw new RuntimeException(message);\n}\n\n";
+
+	// Exceptions can't be thrown through the glue code, so the exceptions thrown
+	// by interception functions are passed to the handler of the current thread.
+	helper << "public static void uncaught(Throwable e) {\n";
+	helper << "Thread thread = Thread.currentThread();\n";
+	helper << "try {\n";
+	helper << "thread.getUncaughtExceptionHandler().uncaughtException(thread, e);\n";
+	helper << "} catch(Throwable ignored) {\n}\n}\n\n";
+
+	helper << "public static RuntimeException rethrow(Throwable e) {\n";
+	helper << "if(e instanceof Error error) {\nthrow error;\n}\n\n";
+	helper << "return e instanceof RuntimeException runtime ? runtime : new RuntimeException(e);\n}\n\n";
+
+	// Strings passed to the glue code are also null terminated so that they can be used as C strings.
+	helper << "public static MemorySegment encodeString(SegmentAllocator allocator, String value) {\n";
+	helper << "MemorySegment string = allocator.allocate(STRING);\n";
+	helper << "if(value != null) {\n";
+	helper << "MemorySegment data = allocator.allocateFrom(value);\n";
+	helper << "string.set(ValueLayout.ADDRESS, 0, data);\n";
+	helper << "setWord(string, SIZE_OFFSET, data.byteSize() - 1);\n}\n\n";
+	helper << "return string;\n}\n\n";
+
+	// Strings and buffers returned to the glue code are copied by it right away, so each
+	// thread reuses a single segment for them. The segment is freed once it's unreachable.
+	helper << "private static SegmentAllocator returnAllocator(long size) {\n";
+	helper << "MemorySegment[] segment = returned.get();\n";
+	helper << "if(segment[0] == null || segment[0].byteSize() < size) {\n";
+	helper << "segment[0] = Arena.ofAuto().allocate(Math.max(size, 256), 16);\n}\n\n";
+	helper << "return SegmentAllocator.slicingAllocator(segment[0]);\n}\n\n";
+
+	// A character takes at most three bytes in UTF-8.
+	helper << "public static MemorySegment returnString(String value) {\n";
+	helper << "long size = STRING.byteSize() + (value != null ? value.length() * 3L + 1 : 0);\n";
+	helper << "return encodeString(returnAllocator(size), value);\n}\n\n";
+
+	// Strings returned by the glue code aren't necessarily null terminated.
+	helper << "public static String decodeString(MemorySegment string) {\n";
+	helper << "MemorySegment data = string.get(ValueLayout.ADDRESS, 0);\n";
+	helper << "if(data.equals(MemorySegment.NULL)) {\nreturn null;\n}\n\n";
+	helper << "long size = getWord(string, SIZE_OFFSET);\n";
+	helper << "return new String(data.reinterpret(size).toArray(ValueLayout.JAVA_BYTE), StandardCharsets.UTF_8);\n}\n\n";
+
+	// Arrays are copied to and from native memory since the views passed
+	// to the glue code can't refer to the Java heap.
+	for(auto element : { PrimitiveEntity::Type::Integer, PrimitiveEntity::Type::Float,
+						PrimitiveEntity::Type::Double, PrimitiveEntity::Type::Character })
+	{
+		std::string array = std::string(getCarrierType(element)) + "[]";
+		std::string layout = getLayout(element, packagePrefix);
+		std::string layoutType = getCarrierType(element);
+		layoutType[0] = ::toupper(layoutType[0]);
+		layoutType = "ValueLayout.Of" + layoutType;
+
+		helper << "public static MemorySegment encodeBuffer(SegmentAllocator allocator, " << array << " value) {\n";
+		helper << "MemorySegment buffer = allocator.allocate(BUFFER);\n";
+		helper << "if(value != null) {\n";
+		helper << "buffer.set(ValueLayout.ADDRESS, 0, allocator.allocateFrom(" << layout << ", value));\n";
+		helper << "setWord(buffer, SIZE_OFFSET, value.length);\n}\n\n";
+		helper << "return buffer;\n}\n\n";
+
+		helper << "public static MemorySegment heapBuffer(" << array << " value) {\n";
+		helper << "return value != null ? MemorySegment.ofArray(value) : MemorySegment.NULL;\n}\n\n";
+
+		helper << "public static MemorySegment returnBuffer(" << array << " value) {\n";
+		helper << "long size = BUFFER.byteSize() + (value != null ? value.length * " << layout << ".byteSize() + " <<
+				layout << ".byteAlignment() : 0);\n";
+		helper << "return encodeBuffer(returnAllocator(size), value);\n}\n\n";
+
+		helper << "public static void copyBack(MemorySegment buffer, " << array << " value) {\n";
+		helper << "if(value != null) {\n";
+		helper << "MemorySegment data = buffer.get(ValueLayout.ADDRESS, 0).reinterpret(value.length * " << layout << ".byteSize());\n";
+		helper << "MemorySegment.copy(data, " << layout << ", 0, value, 0, value.length);\n}\n}\n\n";
+
+		helper << "public static " << array << " decodeBuffer(MemorySegment buffer, " << layoutType << " layout) {\n";
+		helper << "MemorySegment data = buffer.get(ValueLayout.ADDRESS, 0);\n";
+		helper << "if(data.equals(MemorySegment.NULL)) {\nreturn null;\n}\n\n";
+		helper << "long size = getWord(buffer, SIZE_OFFSET);\n";
+		helper << "return data.reinterpret(size * layout.byteSize()).toArray(layout);\n}\n\n";
+	}
+
+	helper << "public static java.nio.ByteBuffer viewBuffer(MemorySegment buffer, ValueLayout layout) {\n";
+	helper << "MemorySegment data = buffer.get(ValueLayout.ADDRESS, 0);\n";
+	helper << "if(data.equals(MemorySegment.NULL)) {\nreturn null;\n}\n\n";
+	helper << "long size = getWord(buffer, SIZE_OFFSET);\n";
+	helper << "return data.reinterpret(size * layout.byteSize()).asByteBuffer();\n}\n\n";
+
+	// Java objects that the glue code refers to are identified by a number
+	// that is passed to the glue code as the foreign object. Like the GCHandle
+	// of C# objects, the registration keeps the object alive until it's unregistered.
+	helper << "public static MemorySegment register(Object object) {\n";
+	helper << "long id = nextObject.getAndIncrement();\n";
+	helper << "objects.put(id, object);\n";
+	helper << "return MemorySegment.ofAddress(id);\n}\n\n";
+
+	helper << "public static Object getObject(MemorySegment handle) {\n";
+	helper << "return objects.get(handle.address());\n}\n\n";
+
+	helper << "public static void unregister(MemorySegment handle) {\n";
+	helper << "objects.remove(handle.address());\n}\n\n";
+
+	// Objects that are only needed once, such as futures, are unregistered when taken.
+	helper << "public static Object takeObject(MemorySegment handle) {\n";
+	helper << "return objects.remove(handle.address());\n}\n\n";
+
+	if(callablesGenerated)
+	{
+		// Passing the same Java callable again reuses its context, which
+		// is counted so that it lives until every copy is released.
+		helper << "public static synchronized MemorySegment acquire(Object callable) {\n";
+		helper << "long[] context = callableContexts.get(callable);\n";
+		helper << "if(context == null) {\n";
+		helper << "context = new long[] { nextObject.getAndIncrement(), 0 };\n";
+		helper << "callableContexts.put(callable, context);\n";
+		helper << "callables.put(context[0], callable);\n}\n\n";
+		helper << "context[1]++;\n";
+		helper << "return MemorySegment.ofAddress(context[0]);\n}\n\n";
+
+		helper << "private static synchronized void releaseCallable(MemorySegment context) {\n";
+		helper << "Object callable = callables.get(context.address());\n";
+		helper << "long[] counted = callableContexts.get(callable);\n";
+		helper << "if(counted != null && --counted[1] == 0) {\n";
+		helper << "callableContexts.remove(callable);\n";
+		helper << "callables.remove(context.address());\n}\n}\n\n";
+
+		helper << "public static Object getCallable(MemorySegment context) {\n";
+		helper << "return callables.get(context.address());\n}\n\n";
+
+		helper << "public static MethodHandle invoker(FunctionDescriptor descriptor) {\n";
+		helper << "MethodHandle handle = linker.downcallHandle(descriptor);\n";
+		helper << "return MethodHandles.explicitCastArguments(handle, carrierType(handle.type(), descriptor));\n}\n\n";
+
+		helper << "public static void releaseNative(MemorySegment release, MemorySegment context) {\n";
+		helper << "try {\n";
+		helper << "releaseInvoker.invokeExact(release, context);\n";
+		helper << "} catch(Throwable e) {\n";
+		helper << "throw rethrow(e);\n}\n}\n\n";
+	}
+
+	// Each generated class caches the masks of its runtime types, since the mask of a type
+	// differs between the generated classes it derives. A function is considered overridden
+	// when a class deriving the generated class declares a method of the same name.
+	helper << "public static ClassValue <Long> overrides(Class <?> generated, String[] names) {\n";
+	helper << "return new ClassValue <> () {\n";
+	helper << "@Override\nprotected Long computeValue(Class <?> type) {\n";
+	helper << "return computeOverrides(type, generated, names);\n}\n};\n}\n\n";
+
+	helper << "private static long computeOverrides(Class <?> type, Class <?> generated, String[] names) {\n";
+	helper << "long mask = 0;\n";
+	helper << "for(int i = 0; i < names.length && i < 64; i++) {\n";
+	helper << "if(names[i] == null) {\nmask |= 1L << i;\n}\n}\n\n";
+	helper << "for(Class <?> current = type; current != null && current != generated; current = current.getSuperclass()) {\n";
+	helper << "for(Method method : current.getDeclaredMethods()) {\n";
+	helper << "if(Modifier.isStatic(method.getModifiers())) {\ncontinue;\n}\n\n";
+	helper << "for(int i = 0; i < names.length && i < 64; i++) {\n";
+	helper << "if(method.getName().equals(names[i])) {\nmask |= 1L << i;\n}\n}\n}\n}\n\n";
+	helper << "return mask;\n}\n}\n";
+}
+
+void ForeignBindingGenerator::finishGeneration()
+{
+	generateLifetime();
+
+	if(bridgeStats)
+	{
+		generateBridgeStats();
+	}
+
+	generateForeignHelper();
+
+	natives.clear();
+	destructors.clear();
+	callablesGenerated = false;
+}
+
+}
@@ -2,11 +2,14 @@
 #define AUTOGLUE_JAVA_BINDING_GENERATOR_HH
 
 #include <autoglue/BindingGenerator.hh>
+#include <autoglue/PrimitiveEntity.hh>
 
 #include <string_view>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <stack>
+#include <set>
 
 namespace ag::java
 {
@@ -14,19 +17,188 @@ namespace ag::java
 class BindingGenerator : public ag::BindingGenerator
 {
 public:
+	/// CallMode determines how the JNI glue calls the bridge functions.
+	enum class CallMode
+	{
+		/// The bridge functions are declared and linked by name.
+		Linked,
+
+		/// The bridge functions are called through the table returned by AG_getBridgeTable.
+		/// The JNI glue then includes glue_table.hh from the glue code directory.
+		BridgeTable
+	};
+
 	BindingGenerator(Backend& backend, std::string_view packagePrefix);
 
-private:
+	/// Sets how the JNI glue calls the bridge functions.
+	///
+	/// \param mode The call mode to use.
+	void setCallMode(CallMode mode);
+
+	/// Sets whether object handles returned by the glue code are wrapped through an
+	/// identity cache. Each class then keeps a weak map from object addresses to the
+	/// objects wrapping them, so that the same native object is always represented
+	/// by the same Java object while it's reachable.
+	///
+	/// \param value If true, the identity cache is used.
+	void setIdentityCache(bool value);
+
+	/// Sets whether BridgeStats is generated. It reads the call counts and the
+	/// latency histograms of the bridge functions, so the glue code has to be
+	/// generated with ag::clang::GlueOptions::callCounters set.
+	///
+	/// \param value If true, BridgeStats is generated.
+	void setBridgeStats(bool value);
+
+protected:
+	/// Creates a generator for Java classes.
+	///
+	/// \param backend The backend to generate bindings for.
+	/// \param packagePrefix The package that the generated classes are placed in.
+	/// \param jniGlue If true, the JNI glue is generated to jni_glue.cpp.
+	BindingGenerator(Backend& backend, std::string_view packagePrefix, bool jniGlue);
+
 	void generateClass(ClassEntity& entity) override;
 	void generateEnum(EnumEntity& entity) override;
 	void generateEnumEntry(EnumEntryEntity& entity) override;
+	void generateCallableType(CallableTypeEntity& entity) override;
 	void generateFunction(FunctionEntity& entity) override;
+	void generateField(FieldEntity& entity) override;
 	void generateTypeReference(TypeReferenceEntity& entity) override;
 	void generateTypeAlias(TypeAliasEntity& entity) override;
 	bool generateBaseType(TypeEntity& entity, size_t index) override;
 	void generateNamedScope(ScopeEntity& entity) override;
 	void generateArgumentSeparator() override;
 	bool generateReturnStatement(TypeReferenceEntity& entity, FunctionEntity& target) override;
+	void finishGeneration() override;
+	std::string_view getObjectHandleName() override;
+
+	/// Generates the declaration of the static Java method that calls the bridge function.
+	///
+	/// \param entity The function to generate the declaration for.
+	virtual void generateNativeDeclaration(FunctionEntity& entity);
+
+	/// Generates the native code that the static Java method is bound to.
+	///
+	/// \param entity The function to generate the native code for.
+	virtual void generateNativeImplementation(FunctionEntity& entity);
+
+	/// Generates the private static Java method that calls the batched bridge function
+	/// of the given function. It takes the objects, the broadcast mask and an array for
+	/// each parameter, and returns an array containing the results if there are any.
+	///
+	/// \param entity The batched function to generate the method for.
+	virtual void generateBatchedNative(FunctionEntity& entity);
+
+	/// Generates the static methods that call a batched function for an array of objects.
+	///
+	/// \param entity The batched function to generate the methods for.
+	void generateBatchedFunction(FunctionEntity& entity);
+
+	/// Generates the private static Java method that calls the asynchronous bridge function
+	/// of the given function. It takes the future to complete after the parameters, and
+	/// passes a completion function that completes it to the asynchronous bridge function.
+	///
+	/// \param entity The asynchronous function to generate the method for.
+	virtual void generateAsyncNative(FunctionEntity& entity);
+
+	/// Gets the type of the future that an asynchronous function completes.
+	///
+	/// \param entity The asynchronous function.
+	/// \return The type of the future.
+	std::string getFutureType(FunctionEntity& entity);
+
+	/// Generates a method returning a future that is completed once the asynchronous
+	/// bridge function has called the function on a native worker thread.
+	///
+	/// \param entity The asynchronous function to generate the method for.
+	void generateAsyncFunction(FunctionEntity& entity);
+
+	/// Generates the overload that returns an object to caller provided storage,
+	/// or destroyInPlace if the function is the destructor of a storable class.
+	///
+	/// \param entity The function that has a storage bridge function.
+	void generateStorageFunction(FunctionEntity& entity);
+
+	/// Checks whether the storage bridge function of the given function is being
+	/// generated and takes storage for the returned object.
+	///
+	/// \param entity The function to check.
+	/// \return True if the storage parameter should be generated.
+	bool takesStorage(FunctionEntity& entity);
+
+	/// Generates the storage parameter of a storage bridge function for the current context.
+	///
+	/// \param entity The function whose storage bridge function is called.
+	void generateStorageParameter(FunctionEntity& entity);
+
+	/// Gets the Java type of the storage that objects are returned to.
+	///
+	/// \return The Java type of the storage.
+	virtual const char* getStorageType();
+
+	/// Gets the name of the Java method that calls the given function.
+	///
+	/// \param entity The function to get the method name of.
+	/// \return The name of the Java method.
+	std::string getMethodName(FunctionEntity& entity);
+
+	/// Generates the class that converts callables of the given type to and from
+	/// the format that the native code uses.
+	///
+	/// \param entity The callable type to generate the class for.
+	virtual void generateCallableHelpers(CallableTypeEntity& entity);
+
+	/// Generates the statements that a constructor of a class with
+	/// interception functions uses to set up the interception.
+	///
+	/// \param entity The constructor to generate the statements for.
+	virtual void generateInterceptionSetup(FunctionEntity& entity);
+
+	/// Generates the native methods of AG_Lifetime that call the destructors.
+	///
+	/// \param lifetime The stream to write AG_Lifetime to.
+	virtual void generateLifetimeNatives(std::ofstream& lifetime);
+
+	/// Generates BridgeStats which reads the call counters of the glue code.
+	void generateBridgeStats();
+
+	/// Generates the native methods of BridgeStats that read and reset the call counters.
+	///
+	/// \param stats The stream to write BridgeStats to.
+	virtual void generateBridgeStatsNatives(std::ofstream& stats);
+
+	/// Generates the identity cache of a class and AG_wrap which looks objects up from it.
+	///
+	/// \param entity The class to generate the identity cache for.
+	void generateIdentityCache(ClassEntity& entity);
+
+	/// Generates the Java class holding the fields of a value type.
+	///
+	/// \param entity The value type to generate the class for.
+	void generateValueType(ClassEntity& entity);
+
+	/// Generates the functions that convert a value type to and from
+	/// the format that the native code uses.
+	///
+	/// \param entity The value type to generate the functions for.
+	virtual void generateValueHelpers(ClassEntity& entity);
+
+	/// Gets the Java type used for object handles.
+	///
+	/// \return The Java type used for object handles.
+	virtual const char* getHandleType();
+
+	/// Gets the Java expression for an object handle that refers to nothing.
+	///
+	/// \return The Java expression for a null object handle.
+	virtual const char* getNullHandle();
+
+	/// Gets an expression that converts an object handle to a long address.
+	///
+	/// \param handle The expression containing the object handle.
+	/// \return An expression that evaluates to the address of the object.
+	virtual std::string getHandleAddress(std::string_view handle);
 
 	void generateTyperefJNI(TypeReferenceEntity& entity);
 	void generateTyperefJava(TypeReferenceEntity& entity);
@@ -34,7 +206,71 @@ private:
 	std::string sanitizeName(Entity& entity);
 	std::shared_ptr <FunctionEntity> findClashing(FunctionEntity& entity, TypeEntity& from, int baseDepth);
 
-	void openFile(Entity& entity);
+	virtual void openFile(Entity& entity);
+
+	struct Native
+	{
+		std::string name;
+		std::string signature;
+		std::string function;
+	};
+
+	/// Ensures that the JNI glue has access to the bridge table.
+	void ensureBridgeTableAccess();
+
+	/// Ensures that the JNI glue defines the mirror structs of the value types used by the given function.
+	///
+	/// \param entity The function whose parameters and return type to check.
+	void ensureValueTypesJNI(FunctionEntity& entity);
+
+	/// Gets the method of AG_View that views a byte buffer as borrowed elements of the given type.
+	///
+	/// \param element The element type of the borrowed buffer.
+	/// \return The qualified name of the method.
+	std::string getViewConversion(PrimitiveEntity::Type element);
+
+	/// Ensures that AG_View, which views borrowed buffers as their element type, is generated.
+	void ensureViewHelper();
+
+	/// Ensures that the JNI glue has the helpers shared by every callable type.
+	void ensureCallableAccessJNI();
+
+	/// Ensures that the JNI glue has the trampolines of the callable types used by the given function.
+	///
+	/// \param entity The function whose parameters and return type to check.
+	void ensureCallablesJNI(FunctionEntity& entity);
+
+	/// Adds a JNI function to the natives registered for the class containing the given function.
+	///
+	/// \param entity The function that the JNI function was generated for.
+	/// \param functionName The name of the JNI function.
+	void addNative(FunctionEntity& entity, const std::string& functionName);
+
+	/// Adds a JNI function to the natives registered for the given class.
+	///
+	/// \param classPath The JNI class path of the class containing the native method.
+	/// \param native The native method to register.
+	void addNative(const std::string& classPath, Native&& native);
+
+	/// Gets the index of the destructor of the given class within the destructors
+	/// that AG_Lifetime can call. The destructor is registered if necessary.
+	///
+	/// \param entity The class to get the destructor index of.
+	/// \return The destructor index or -1 if the class has no destructor.
+	int getDestructorIndex(ClassEntity& entity);
+
+	/// Generates AG_Lifetime which releases owned native objects, and the JNI
+	/// functions that call the destructor bridges for it.
+	void generateLifetime();
+
+	/// Generates JNI_OnLoad which registers every JNI function with RegisterNatives.
+	void generateOnLoad();
+
+	/// The natives to register for each class, identified by the JNI class path.
+	std::vector <std::pair <std::string, std::vector <Native>>> natives;
+
+	/// The destructor bridges of each class, indexed by the destructor index.
+	std::vector <std::pair <ClassEntity*, std::string>> destructors;
 
 	std::ofstream file;
 	std::ofstream jni;
@@ -53,6 +289,44 @@ private:
 
 	/// Used to indicate that type parameters should be written in the bridge format
 	bool inExtern = false;
+
+	/// Used to pass ownership of the returned object handle to the created Java object.
+	bool ownedReturn = false;
+
+	/// Used to access the elements of Java arrays in a critical region.
+	bool criticalArrays = false;
+
+	/// Used to indicate that the declaration of a native method is being generated.
+	bool inNative = false;
+
+	/// Used to call the storage bridge function of a function.
+	bool inStorage = false;
+
+	/// If true, value types are passed to native methods as their fields and returned as bytes.
+	bool flattenValues = false;
+
+	/// Strings that fit in this many bytes are converted on the stack.
+	static constexpr size_t stackStringSize = 256;
+
+	CallMode callMode = CallMode::Linked;
+	bool identityCache = false;
+	bool bridgeStats = false;
+	bool bridgeTableAccessGenerated = false;
+
+	/// The value types whose mirror structs the JNI glue defines.
+	std::set <ClassEntity*> valueTypesJNI;
+
+	/// The callable types whose trampolines the JNI glue defines.
+	std::set <CallableTypeEntity*> callablesJNI;
+
+	/// The completion methods of asynchronous functions that the JNI glue calls, identified by the
+	/// JNI class path. The function of each is the prefix of the variables caching the method.
+	std::vector <std::pair <std::string, Native>> asyncCompletions;
+
+	/// The name and the interface method descriptor of each callable type that the JNI glue calls.
+	std::vector <std::pair <std::string, std::string>> callableMethods;
+	bool callableAccessGenerated = false;
+	bool viewHelperGenerated = false;
 };
 
 }
@@ -0,0 +1,85 @@
+#ifndef AUTOGLUE_JAVA_FOREIGN_BINDING_GENERATOR_HH
+#define AUTOGLUE_JAVA_FOREIGN_BINDING_GENERATOR_HH
+
+#include <autoglue/java/BindingGenerator.hh>
+
+namespace ag::java
+{
+
+/// ForeignBindingGenerator generates Java classes that call the bridge functions
+/// through the Foreign Function & Memory API of Java 22 instead of JNI. No native
+/// code is generated, and virtual functions can be overridden in Java.
+class ForeignBindingGenerator : public BindingGenerator
+{
+public:
+	/// Creates a generator for Java classes using the Foreign Function & Memory API.
+	///
+	/// \param backend The backend to generate bindings for.
+	/// \param packagePrefix The package that the generated classes are placed in.
+	/// \param libName The name of the library containing the glue code.
+	ForeignBindingGenerator(Backend& backend, std::string_view packagePrefix, std::string_view libName);
+
+private:
+	void generateField(FieldEntity& entity) override;
+	void generateNativeDeclaration(FunctionEntity& entity) override;
+	void generateNativeImplementation(FunctionEntity& entity) override;
+	void generateBatchedNative(FunctionEntity& entity) override;
+	void generateAsyncNative(FunctionEntity& entity) override;
+	void generateInterceptionSetup(FunctionEntity& entity) override;
+	void generateInterceptionFunction(FunctionEntity& entity, ClassEntity& parentClass) override;
+	void generateInterceptionContext(ClassEntity& entity) override;
+	void generateLifetimeNatives(std::ofstream& lifetime) override;
+	void generateBridgeStatsNatives(std::ofstream& stats) override;
+	void generateValueHelpers(ClassEntity& entity) override;
+	void generateCallableHelpers(CallableTypeEntity& entity) override;
+	void finishGeneration() override;
+	void openFile(Entity& entity) override;
+
+	const char* getHandleType() override;
+	const char* getNullHandle() override;
+	const char* getStorageType() override;
+	std::string getHandleAddress(std::string_view handle) override;
+
+	/// Generates AG_Foreign which looks up the bridge functions and keeps
+	/// track of the Java objects that the glue code refers to.
+	void generateForeignHelper();
+
+	/// Gets the function descriptor of the bridge function of the given function.
+	///
+	/// \param entity The function to get the function descriptor for.
+	/// \param errorSlot If true, the error slot of a potentially throwing function is included.
+	/// \param unpacked If true, the descriptor is that of the unpacked bridge function.
+	/// \return An expression creating the function descriptor.
+	std::string getFunctionDescriptor(FunctionEntity& entity, bool errorSlot, bool unpacked = false);
+
+	/// Gets an expression converting a value received from the glue code to its Java type.
+	///
+	/// \param entity The type of the value.
+	/// \param value The expression containing the value.
+	/// \return An expression evaluating to the converted value.
+	std::string convertToJava(TypeReferenceEntity& entity, const std::string& value);
+
+	/// Gets an expression converting a Java value to a value passed to the glue code.
+	///
+	/// \param entity The type of the value.
+	/// \param value The expression containing the value.
+	/// \return An expression evaluating to the converted value.
+	std::string convertToForeign(TypeReferenceEntity& entity, const std::string& value);
+
+	/// What is listed for each interception function in the interception context.
+	enum class InterceptionPart
+	{
+		None,
+		Names,
+		Layouts,
+		Arguments
+	};
+
+	std::string libName;
+	InterceptionPart interceptionPart = InterceptionPart::None;
+	bool callablesGenerated = false;
+};
+
+}
+
+#endif
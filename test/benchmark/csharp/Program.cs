@@ -0,0 +1,199 @@
+using System.Diagnostics;
+using System.Globalization;
+using System.Reflection;
+using System.Runtime.InteropServices;
+using System.Text.Json;
+using gencs.bench;
+
+// Marks a method of Benchmarks as a benchmark. Each invocation is one operation.
+[AttributeUsage(AttributeTargets.Method)]
+sealed class BenchmarkAttribute : Attribute
+{
+}
+
+sealed class CountingListener : Listener
+{
+	public override int onValue(int value)
+	{
+		return value + 1;
+	}
+}
+
+// The benchmarks store their results in sink so that the calls can't be optimized away.
+sealed unsafe class Benchmarks
+{
+	public long sink;
+
+	private readonly Fixture fixture = new Fixture();
+	private readonly Listener listener = new CountingListener();
+	private readonly Color color = Color.Green;
+	private readonly string text = "The quick brown fox";
+
+	// Points returned into caller provided storage reuse this block.
+	private readonly IntPtr storage = (IntPtr)NativeMemory.AlignedAlloc((nuint)Point.StorageSize, (nuint)Point.StorageAlignment);
+
+	// Measures the cost of invoking a benchmark, which is subtracted from the other results.
+	public void Overhead()
+	{
+	}
+
+	[Benchmark]
+	public void EmptyCall()
+	{
+		fixture.empty();
+	}
+
+	[Benchmark]
+	public void PrimitiveArguments()
+	{
+		sink += (long)fixture.combine(1, 2L, 3.0f, 4.0, true);
+	}
+
+	[Benchmark]
+	public void StringIn()
+	{
+		sink += (long)fixture.measure(text);
+	}
+
+	[Benchmark]
+	public void StringOut()
+	{
+		sink += fixture.getName().Length;
+	}
+
+	// C# wrappers don't release the objects they own, so this includes the native
+	// allocation of every returned point, which is never freed.
+	[Benchmark]
+	public void ObjectReturn()
+	{
+		sink += fixture.makePoint(3, 4).getX();
+	}
+
+	[Benchmark]
+	public void ObjectReturnStorage()
+	{
+		var point = fixture.makePoint(3, 4, storage);
+		sink += point.getX();
+		point.destroyInPlace();
+	}
+
+	[Benchmark]
+	public void VirtualCallback()
+	{
+		sink += fixture.notify(listener, 1);
+	}
+
+	[Benchmark]
+	public void EnumRoundTrip()
+	{
+		sink += (long)fixture.nextColor(color);
+	}
+}
+
+static class Program
+{
+	// Each iteration runs for about this long once the pilot stage has sized it.
+	const double IterationTime = 0.1;
+	const int WarmupIterations = 5;
+	const int MeasuredIterations = 15;
+
+	record Result(string Name, double Mean, double Median, double StdDev, double Min, long Operations);
+
+	static (double[] Samples, long Operations) Measure(Action action)
+	{
+		// The pilot stage doubles the amount of operations until an iteration is long enough.
+		long operations = 1;
+		while(true)
+		{
+			var time = Run(action, operations);
+			if(time >= IterationTime || operations >= (1L << 40))
+			{
+				break;
+			}
+
+			operations *= 2;
+		}
+
+		for(int i = 0; i < WarmupIterations; i++)
+		{
+			Run(action, operations);
+		}
+
+		var samples = new double[MeasuredIterations];
+		for(int i = 0; i < MeasuredIterations; i++)
+		{
+			samples[i] = Run(action, operations) * 1e9 / operations;
+		}
+
+		return (samples, operations);
+	}
+
+	static double Run(Action action, long operations)
+	{
+		var watch = Stopwatch.StartNew();
+		for(long i = 0; i < operations; i++)
+		{
+			action();
+		}
+
+		return watch.Elapsed.TotalSeconds;
+	}
+
+	static Result Summarize(string name, (double[] Samples, long Operations) measured, double overhead)
+	{
+		var samples = measured.Samples.Select(sample => Math.Max(0, sample - overhead)).ToArray();
+		var sorted = samples.OrderBy(sample => sample).ToArray();
+		double mean = samples.Average();
+		double variance = samples.Sum(sample => (sample - mean) * (sample - mean)) / (samples.Length - 1);
+
+		return new Result(name, mean, sorted[sorted.Length / 2], Math.Sqrt(variance), sorted[0], measured.Operations);
+	}
+
+	static string Format(double value)
+	{
+		return value.ToString("0.###", CultureInfo.InvariantCulture);
+	}
+
+	static void Main(string[] args)
+	{
+		string output = args.Length > 0 ? args[0] : "results-csharp.json";
+		string filter = args.Length > 1 ? args[1] : "";
+
+		var benchmarks = new Benchmarks();
+		double overhead = Measure(benchmarks.Overhead).Samples.Average();
+
+		var results = new List<Result>();
+		foreach(var method in typeof(Benchmarks).GetMethods())
+		{
+			if(method.GetCustomAttribute<BenchmarkAttribute>() == null || !method.Name.Contains(filter))
+			{
+				continue;
+			}
+
+			var action = method.CreateDelegate<Action>(benchmarks);
+			var result = Summarize(method.Name, Measure(action), overhead);
+
+			Console.WriteLine($"{result.Name,-20} {Format(result.Mean),10} ns/op  ± {Format(result.StdDev)}");
+			results.Add(result);
+		}
+
+		// The results are written in the same format as the Java benchmarks use.
+		var report = new
+		{
+			suite = "csharp",
+			unit = "ns/op",
+			benchmarks = results.Select(result => new
+			{
+				name = result.Name,
+				mean = result.Mean,
+				median = result.Median,
+				stddev = result.StdDev,
+				min = result.Min,
+				iterations = MeasuredIterations,
+				operations = result.Operations
+			})
+		};
+
+		File.WriteAllText(output, JsonSerializer.Serialize(report, new JsonSerializerOptions { WriteIndented = true }));
+	}
+}
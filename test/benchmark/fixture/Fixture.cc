@@ -0,0 +1,68 @@
+#include <bench/Fixture.hh>
+
+namespace bench
+{
+
+Point::Point(int x, int y) : x(x), y(y)
+{
+}
+
+int Point::getX() const noexcept
+{
+	return x;
+}
+
+int Point::getY() const noexcept
+{
+	return y;
+}
+
+Listener::~Listener()
+{
+}
+
+int Listener::onValue(int value)
+{
+	return value;
+}
+
+void Fixture::empty() noexcept
+{
+}
+
+int Fixture::add(int a, int b) noexcept
+{
+	return a + b;
+}
+
+double Fixture::combine(int a, long long b, float c, double d, bool e) noexcept
+{
+	return a + b + c + d + e;
+}
+
+size_t Fixture::measure(const std::string& text)
+{
+	return text.size();
+}
+
+std::string Fixture::getName() const
+{
+	return name;
+}
+
+Point Fixture::makePoint(int x, int y) const
+{
+	return Point(x, y);
+}
+
+int Fixture::notify(Listener& listener, int value)
+{
+	return listener.onValue(value);
+}
+
+Color Fixture::nextColor(Color color) noexcept
+{
+	return static_cast <Color> ((static_cast <int> (color) + 1) % 3);
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef BENCH_FIXTURE_HH
+#define BENCH_FIXTURE_HH
+
+#include <string>
+#include <cstddef>
+
+namespace bench
+{
+
+/// Color is passed to and returned from Fixture::nextColor.
+enum class Color
+{
+	Red,
+	Green,
+	Blue
+};
+
+/// Point is returned by value from Fixture::makePoint.
+class Point
+{
+public:
+	Point(int x, int y);
+
+	int getX() const noexcept;
+	int getY() const noexcept;
+
+private:
+	int x;
+	int y;
+};
+
+/// Listener is overridden by the benchmarks so that Fixture::notify
+/// calls back into the foreign language.
+class Listener
+{
+public:
+	virtual ~Listener();
+
+	/// Called by Fixture::notify.
+	///
+	/// \param value The value passed to Fixture::notify.
+	/// \return The value that Fixture::notify returns.
+	virtual int onValue(int value);
+};
+
+/// Fixture has a function for each case that the benchmarks measure. The functions
+/// are defined in a separate source file so that the glue code really calls them,
+/// and they do as little as possible so that the cost of the bindings dominates.
+class Fixture
+{
+public:
+	/// Does nothing.
+	void empty() noexcept;
+
+	/// Adds two integers.
+	int add(int a, int b) noexcept;
+
+	/// Sums up primitives of different types.
+	double combine(int a, long long b, float c, double d, bool e) noexcept;
+
+	/// Gets the length of the given string.
+	size_t measure(const std::string& text);
+
+	/// Gets the name of the fixture.
+	std::string getName() const;
+
+	/// Creates a point.
+	Point makePoint(int x, int y) const;
+
+	/// Calls Listener::onValue of the given listener.
+	int notify(Listener& listener, int value);
+
+	/// Gets the color following the given color.
+	Color nextColor(Color color) noexcept;
+
+private:
+	std::string name = "fixture";
+};
+
+}
+
+#endif
@@ -0,0 +1,236 @@
+import java.io.IOException;
+import java.lang.annotation.ElementType;
+import java.lang.annotation.Retention;
+import java.lang.annotation.RetentionPolicy;
+import java.lang.annotation.Target;
+import java.lang.invoke.MethodHandle;
+import java.lang.invoke.MethodHandles;
+import java.lang.invoke.MethodType;
+import java.lang.reflect.Method;
+import java.nio.Buffer;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Locale;
+
+import org.bench.Color;
+import org.bench.Fixture;
+import org.bench.Listener;
+import org.bench.Point;
+
+public final class Benchmark {
+	// Marks a method of State as a benchmark. Each invocation is one operation.
+	@Retention(RetentionPolicy.RUNTIME)
+	@Target(ElementType.METHOD)
+	@interface Measured {
+	}
+
+	static final class CountingListener extends Listener {
+		@Override
+		public int onValue(int value) {
+			return value + 1;
+		}
+	}
+
+	// The benchmarks store their results in sink so that the calls can't be optimized away.
+	public static final class State {
+		public long sink;
+
+		private final Fixture fixture = new Fixture();
+		private final Listener listener = new CountingListener();
+		private final Color color = Color.Green;
+		private final String text = "The quick brown fox";
+
+		// The storage overload takes a direct ByteBuffer with JNI and a MemorySegment with the
+		// Foreign Function & Memory API, so it's looked up once for whichever bindings are used.
+		private static final Class <?> STORAGE_TYPE;
+		private static final MethodHandle MAKE_POINT_IN_STORAGE;
+
+		static {
+			try {
+				Method method = Arrays.stream(Fixture.class.getMethods())
+					.filter(m -> m.getName().equals("makePoint") && m.getParameterCount() == 3)
+					.findFirst().orElseThrow();
+
+				STORAGE_TYPE = method.getParameterTypes()[2];
+				MAKE_POINT_IN_STORAGE = MethodHandles.publicLookup().unreflect(method)
+					.asType(MethodType.methodType(Point.class, Fixture.class, int.class, int.class, Object.class));
+			} catch(ReflectiveOperationException e) {
+				throw new ExceptionInInitializerError(e);
+			}
+		}
+
+		// Points returned into caller provided storage reuse this block.
+		private final Object storage = allocateStorage();
+
+		private static Object allocateStorage() {
+			ByteBuffer buffer = ByteBuffer.allocateDirect((int)(Point.STORAGE_SIZE + Point.STORAGE_ALIGNMENT))
+				.alignedSlice((int)Point.STORAGE_ALIGNMENT);
+
+			try {
+				return STORAGE_TYPE == ByteBuffer.class ? buffer :
+					STORAGE_TYPE.getMethod("ofBuffer", Buffer.class).invoke(null, buffer);
+			} catch(ReflectiveOperationException e) {
+				throw new IllegalStateException(e);
+			}
+		}
+
+		// Measures the cost of invoking a benchmark, which is subtracted from the other results.
+		public void overhead() {
+		}
+
+		@Measured
+		public void emptyCall() {
+			fixture.empty();
+		}
+
+		@Measured
+		public void primitiveArguments() {
+			sink += (long)fixture.combine(1, 2L, 3.0f, 4.0, true);
+		}
+
+		@Measured
+		public void stringIn() {
+			sink += fixture.measure(text);
+		}
+
+		@Measured
+		public void stringOut() {
+			sink += fixture.getName().length();
+		}
+
+		@Measured
+		public void objectReturn() {
+			try(Point point = fixture.makePoint(3, 4)) {
+				sink += point.getX();
+			}
+		}
+
+		@Measured
+		public void objectReturnStorage() throws Throwable {
+			Point point = (Point)MAKE_POINT_IN_STORAGE.invokeExact(fixture, 3, 4, storage);
+			sink += point.getX();
+			point.destroyInPlace();
+		}
+
+		@Measured
+		public void virtualCallback() {
+			sink += fixture.notify(listener, 1);
+		}
+
+		@Measured
+		public void enumRoundTrip() {
+			sink += fixture.nextColor(color).getValue();
+		}
+	}
+
+	// Each iteration runs for about this long once the pilot stage has sized it.
+	private static final double ITERATION_TIME = 0.1;
+	private static final int WARMUP_ITERATIONS = 5;
+	private static final int MEASURED_ITERATIONS = 15;
+
+	private record Measurement(double[] samples, long operations) {
+	}
+
+	private record Result(String name, double mean, double median, double stddev, double min, long operations) {
+	}
+
+	private interface Operation {
+		void run() throws Exception;
+	}
+
+	private static Measurement measure(Operation operation) throws Exception {
+		// The pilot stage doubles the amount of operations until an iteration is long enough.
+		long operations = 1;
+		while(run(operation, operations) < ITERATION_TIME && operations < (1L << 40)) {
+			operations *= 2;
+		}
+
+		for(int i = 0; i < WARMUP_ITERATIONS; i++) {
+			run(operation, operations);
+		}
+
+		double[] samples = new double[MEASURED_ITERATIONS];
+		for(int i = 0; i < MEASURED_ITERATIONS; i++) {
+			samples[i] = run(operation, operations) * 1e9 / operations;
+		}
+
+		return new Measurement(samples, operations);
+	}
+
+	private static double run(Operation operation, long operations) throws Exception {
+		long start = System.nanoTime();
+		for(long i = 0; i < operations; i++) {
+			operation.run();
+		}
+
+		return (System.nanoTime() - start) / 1e9;
+	}
+
+	private static Result summarize(String name, Measurement measured, double overhead) {
+		double[] samples = Arrays.stream(measured.samples()).map(sample -> Math.max(0, sample - overhead)).toArray();
+		double[] sorted = samples.clone();
+		Arrays.sort(sorted);
+
+		double mean = Arrays.stream(samples).average().orElse(0);
+		double variance = Arrays.stream(samples).map(sample -> (sample - mean) * (sample - mean)).sum() / (samples.length - 1);
+
+		return new Result(name, mean, sorted[sorted.length / 2], Math.sqrt(variance), sorted[0], measured.operations());
+	}
+
+	private static String format(double value) {
+		return String.format(Locale.ROOT, "%.3f", value);
+	}
+
+	public static void main(String[] args) throws Exception {
+		String output = args.length > 0 ? args[0] : "results-java.json";
+		String filter = args.length > 1 ? args[1] : "";
+
+		// JNI bindings need the glue code to be loaded first, whereas bindings using
+		// the Foreign Function & Memory API look it up by themselves.
+		System.loadLibrary("cppglue");
+
+		// Benchmarks are invoked through reflection, so the overhead is measured the same way.
+		State state = new State();
+		Method empty = State.class.getMethod("overhead");
+		double overhead = Arrays.stream(measure(() -> empty.invoke(state)).samples()).average().orElse(0);
+
+		List <Result> results = new ArrayList <> ();
+		for(Method method : State.class.getMethods()) {
+			if(!method.isAnnotationPresent(Measured.class) || !method.getName().contains(filter)) {
+				continue;
+			}
+
+			Result result = summarize(method.getName(), measure(() -> method.invoke(state)), overhead);
+			System.out.printf(Locale.ROOT, "%-20s %10s ns/op  ± %s%n", result.name(), format(result.mean()), format(result.stddev()));
+			results.add(result);
+		}
+
+		write(Path.of(output), results);
+	}
+
+	// The results are written in the same format as the C# benchmarks use.
+	private static void write(Path path, List <Result> results) throws IOException {
+		StringBuilder json = new StringBuilder();
+		json.append("{\n  \"suite\": \"java\",\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n");
+
+		for(int i = 0; i < results.size(); i++) {
+			Result result = results.get(i);
+			json.append("    { \"name\": \"").append(result.name()).append('"')
+				.append(", \"mean\": ").append(format(result.mean()))
+				.append(", \"median\": ").append(format(result.median()))
+				.append(", \"stddev\": ").append(format(result.stddev()))
+				.append(", \"min\": ").append(format(result.min()))
+				.append(", \"iterations\": ").append(MEASURED_ITERATIONS)
+				.append(", \"operations\": ").append(result.operations())
+				.append(i + 1 < results.size() ? " },\n" : " }\n");
+		}
+
+		json.append("  ]\n}\n");
+		Files.writeString(path, json.toString(), StandardCharsets.UTF_8);
+	}
+}
@@ -0,0 +1,78 @@
+#include <autoglue/ClassEntity.hh>
+
+#include <autoglue/clang/Backend.hh>
+#include <autoglue/clang/GlueGenerator.hh>
+
+#include <autoglue/java/BindingGenerator.hh>
+#include <autoglue/java/ForeignBindingGenerator.hh>
+
+#include <autoglue/csharp/BindingGenerator.hh>
+
+#include <iostream>
+#include <string_view>
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <compile_commands.json> [dllimport | libraryimport | table | ffm]\n";
+		return 1;
+	}
+
+	ag::clang::Backend clangBackend(argv[1]);
+
+	if(!clangBackend.generateHierarchy())
+	{
+		return 1;
+	}
+
+	// Only the fixture is measured.
+	auto ns = clangBackend.getRoot().resolve("bench");
+	if(!ns)
+	{
+		std::cerr << "The fixture wasn't found in " << argv[1] << '\n';
+		return 1;
+	}
+
+	ns->useAll();
+
+	// The call mode is selectable so that the modes can be compared against each other.
+	std::string_view mode = argc > 2 ? argv[2] : "dllimport";
+	bool table = mode == "table";
+	clangBackend.getGlueOptions().hideBridges = table;
+
+	// Export bindings for Java. The ffm mode uses the Foreign Function & Memory API
+	// instead of JNI so that the two can be compared, and C# uses its default mode.
+	if(mode == "ffm")
+	{
+		ag::java::ForeignBindingGenerator javaGen(clangBackend, "org", "libcppglue.so");
+		javaGen.generateBindings();
+	}
+
+	else
+	{
+		ag::java::BindingGenerator javaGen(clangBackend, "org");
+
+		if(table)
+		{
+			javaGen.setCallMode(ag::java::BindingGenerator::CallMode::BridgeTable);
+		}
+
+		javaGen.generateBindings();
+	}
+
+	// Export bindings for C#.
+	ag::csharp::BindingGenerator csGen(clangBackend, "libcppglue.so");
+
+	if(table)
+	{
+		csGen.setCallMode(ag::csharp::BindingGenerator::CallMode::BridgeTable);
+	}
+
+	else if(mode == "libraryimport")
+	{
+		csGen.setCallMode(ag::csharp::BindingGenerator::CallMode::LibraryImport);
+	}
+
+	csGen.generateBindings();
+}
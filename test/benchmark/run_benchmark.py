@@ -0,0 +1,176 @@
+from argparse import ArgumentParser
+import subprocess
+import shutil
+import json
+import sys, os
+
+# Import the Autoglue build utility.
+sys.path.append(os.path.join(os.path.dirname(__file__), "../.."))
+from build import *
+
+benchmark_path = os.path.abspath(os.path.dirname(__file__))
+generator_build_path = f"{benchmark_path}/build/generator"
+glue_build_path = f"{benchmark_path}/build/glue"
+output_path = f"{benchmark_path}/output"
+results_path = f"{benchmark_path}/results"
+
+def run(command, **kwargs):
+    result = subprocess.run(command, **kwargs)
+    if result.returncode != 0:
+        print(f"Running {command[0]} failed")
+        exit(1)
+
+def generate_bindings(mode):
+    # Configure and build the program that generates the bindings.
+    run([
+        cmake_path,
+        "-S", benchmark_path, "-B", generator_build_path,
+        "-DCMAKE_EXPORT_COMPILE_COMMANDS=ON",
+        "-DCMAKE_BUILD_TYPE=Release"
+    ])
+
+    run([cmake_path, "--build", generator_build_path])
+
+    # Only the fixture is parsed, so leave the generator out of the compilation database.
+    with open(f"{generator_build_path}/compile_commands.json") as database:
+        commands = [entry for entry in json.load(database) if entry["file"].endswith("Fixture.cc")]
+
+    shutil.rmtree(output_path, ignore_errors=True)
+    os.makedirs(output_path)
+
+    with open(f"{output_path}/compile_commands.json", "w") as database:
+        json.dump(commands, database, indent=2)
+
+    print(f"Generate {mode} bindings to {output_path}")
+    run([f"{generator_build_path}/autogluebench", "compile_commands.json", mode], cwd=output_path)
+
+def build_glue():
+    run([
+        cmake_path,
+        "-S", benchmark_path, "-B", glue_build_path,
+        f"-DAUTOGLUE_BENCHMARK_GLUE={output_path}",
+        "-DCMAKE_BUILD_TYPE=Release"
+    ])
+
+    run([cmake_path, "--build", glue_build_path])
+
+def run_csharp(filter):
+    dotnet_path = shutil.which("dotnet")
+    if not dotnet_path:
+        print("Skipping the C# benchmarks since dotnet wasn't found")
+        return None
+
+    output = f"{results_path}/csharp.json"
+    env = dict(os.environ, LD_LIBRARY_PATH=glue_build_path)
+
+    run([
+        dotnet_path, "run", "-c", "Release",
+        "--project", f"{benchmark_path}/csharp/Benchmark.csproj",
+        f"-p:BindingsDirectory={output_path}/gencs",
+        "--", output, filter
+    ], env=env)
+
+    return output
+
+def run_java(filter, mode):
+    javac_path = shutil.which("javac")
+    java_path = shutil.which("java")
+    if not javac_path or not java_path:
+        print("Skipping the Java benchmarks since the JDK wasn't found")
+        return None
+
+    classes_path = f"{benchmark_path}/build/java"
+    sources = [f"{benchmark_path}/java/Benchmark.java"]
+
+    for directory, _, files in os.walk(f"{output_path}/org"):
+        sources += [os.path.join(directory, name) for name in files if name.endswith(".java")]
+
+    run([javac_path, "-d", classes_path] + sources)
+
+    output = f"{results_path}/java.json"
+    env = dict(os.environ, LD_LIBRARY_PATH=glue_build_path)
+
+    # Bindings using the Foreign Function & Memory API load the glue code themselves.
+    options = ["--enable-native-access=ALL-UNNAMED"] if mode == "ffm" else []
+
+    run([
+        java_path, "-cp", classes_path,
+        f"-Djava.library.path={glue_build_path}", *options,
+        "Benchmark", output, filter
+    ], env=env)
+
+    return output
+
+def compare(results, baseline, threshold):
+    # A benchmark regresses when its median grows by more than the threshold. The median
+    # is less affected by outliers than the mean, and differences of less than a
+    # nanosecond are ignored since they are within the timer resolution.
+    previous = {}
+    for suite in baseline["suites"]:
+        for benchmark in suite["benchmarks"]:
+            previous[(suite["suite"], benchmark["name"])] = benchmark["median"]
+
+    regressions = 0
+    for suite in results["suites"]:
+        for benchmark in suite["benchmarks"]:
+            key = (suite["suite"], benchmark["name"])
+            if key not in previous:
+                continue
+
+            before = previous[key]
+            after = benchmark["median"]
+            change = (after - before) / before * 100 if before > 0 else 0
+
+            # Against a baseline from another mode, such as JNI against ffm, this compares the modes.
+            regressed = after > before * (1 + threshold) and after - before > 1
+            print(f"{key[0]:8} {key[1]:20} {before:10.3f} -> {after:10.3f} ns/op ({change:+.1f}%)" +
+                  (" regression" if regressed else ""))
+
+            if regressed:
+                regressions += 1
+
+    return regressions
+
+def main():
+    arg_parser = ArgumentParser(
+        prog="Autoglue binding benchmarks"
+    )
+
+    arg_parser.add_argument("--mode", choices=["dllimport", "libraryimport", "table", "ffm"], default="dllimport",
+                            help="how the generated bindings call the glue code, ffm uses the Foreign Function & Memory API in Java")
+    arg_parser.add_argument("--filter", default="", help="only run benchmarks whose name contains this")
+    arg_parser.add_argument("--baseline", help="results of an earlier run to compare against")
+    arg_parser.add_argument("--threshold", type=float, default=0.1,
+                            help="how much slower a benchmark can get before it's a regression")
+
+    args = arg_parser.parse_args()
+
+    # Build all subsystems.
+    for entry in optional_subsystems:
+        if not entry.build(generator=True, backend=True):
+            print("Build failed")
+            exit(1)
+
+    generate_bindings(args.mode)
+    build_glue()
+
+    os.makedirs(results_path, exist_ok=True)
+    results = { "mode": args.mode, "suites": [] }
+
+    for output in [run_csharp(args.filter), run_java(args.filter, args.mode)]:
+        if output:
+            with open(output) as suite:
+                results["suites"].append(json.load(suite))
+
+    with open(f"{results_path}/results.json", "w") as combined:
+        json.dump(results, combined, indent=2)
+
+    print(f"Results written to {results_path}/results.json")
+
+    if args.baseline:
+        with open(args.baseline) as baseline:
+            if compare(results, json.load(baseline), args.threshold) > 0:
+                exit(1)
+
+if __name__== "__main__":
+    main()